@@ -0,0 +1,173 @@
+/*
+ * adaptivebinarizer.cpp - Local Adaptive Binarization Implementation
+ *
+ * Purpose: Implements the parallel integral images and the per-pixel
+ * Sauvola/Niblack thresholds
+ */
+
+#include "adaptivebinarizer.h"
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+// Dynamic range of the standard deviation in Sauvola's formula
+constexpr double kSauvolaRange = 128.0;
+
+// Columns accumulated together in the vertical integral pass. Wide
+// enough for whole cache lines, narrow enough to give every thread work
+constexpr int kColumnBlock = 256;
+
+double defaultK(ThresholdMethod method)
+{
+    return method == ThresholdMethod::Niblack ? -0.2 : 0.2;
+}
+
+} // namespace
+
+const char *thresholdMethodName(ThresholdMethod method)
+{
+    switch (method) {
+    case ThresholdMethod::Otsu:
+        return "otsu";
+    case ThresholdMethod::Sauvola:
+        return "sauvola";
+    case ThresholdMethod::Niblack:
+        return "niblack";
+    }
+    return "unknown";
+}
+
+AdaptiveBinarizer::AdaptiveBinarizer(ThresholdMethod method, int window, double k)
+    : thresholdMethod(method)
+    , windowSize(window)
+    , kParam(k)
+{
+}
+
+int AdaptiveBinarizer::windowFor(int rows) const
+{
+    // About two text lines of a typical capture: large enough that a
+    // window over a glyph also sees background, small enough to follow
+    // lighting gradients
+    int window = windowSize > 0 ? windowSize : std::clamp(rows / 24, 15, 101);
+    return window | 1;
+}
+
+void AdaptiveBinarizer::computeIntegrals(const cv::Mat &luma)
+{
+    const int rows = luma.rows;
+    const int cols = luma.cols;
+
+    sum.create(rows + 1, cols + 1, CV_32S);
+    sqsum.create(rows + 1, cols + 1, CV_64F);
+
+    std::fill_n(sum.ptr<int>(0), cols + 1, 0);
+    std::fill_n(sqsum.ptr<double>(0), cols + 1, 0.0);
+
+    // Pass 1: prefix sums along each row, rows are independent
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range &band) {
+        for (int y = band.start; y < band.end; ++y) {
+            const uchar *src = luma.ptr<uchar>(y);
+            int *s = sum.ptr<int>(y + 1);
+            double *q = sqsum.ptr<double>(y + 1);
+
+            int rowSum = 0;
+            int64_t rowSq = 0;
+            s[0] = 0;
+            q[0] = 0.0;
+            for (int x = 0; x < cols; ++x) {
+                const int v = src[x];
+                rowSum += v;
+                rowSq += v * v;
+                s[x + 1] = rowSum;
+                q[x + 1] = double(rowSq);
+            }
+        }
+    });
+
+    // Pass 2: accumulate down the columns, split into column blocks so
+    // each thread walks its own strip row by row
+    const int blocks = (cols + 1 + kColumnBlock - 1) / kColumnBlock;
+    cv::parallel_for_(cv::Range(0, blocks), [&](const cv::Range &range) {
+        const int xBegin = range.start * kColumnBlock;
+        const int xEnd = std::min(cols + 1, range.end * kColumnBlock);
+        for (int y = 2; y <= rows; ++y) {
+            const int *sPrev = sum.ptr<int>(y - 1);
+            int *s = sum.ptr<int>(y);
+            const double *qPrev = sqsum.ptr<double>(y - 1);
+            double *q = sqsum.ptr<double>(y);
+            for (int x = xBegin; x < xEnd; ++x) {
+                s[x] += sPrev[x];
+                q[x] += qPrev[x];
+            }
+        }
+    });
+}
+
+void AdaptiveBinarizer::apply(const cv::Mat &luma, cv::Mat &binary, bool lightText)
+{
+    CV_Assert(luma.type() == CV_8UC1);
+    CV_Assert(thresholdMethod != ThresholdMethod::Otsu);
+    // The 32-bit sum holds 255 * pixels: enough for 4K frames
+    CV_Assert(luma.total() <= size_t(INT_MAX / 255));
+
+    computeIntegrals(luma);
+    binary.create(luma.size(), CV_8UC1);
+
+    const int rows = luma.rows;
+    const int cols = luma.cols;
+    const int half = windowFor(rows) / 2;
+    const bool sauvola = thresholdMethod == ThresholdMethod::Sauvola;
+    const double k = kParam != 0.0 ? kParam : defaultK(thresholdMethod);
+
+    // Window width per column (clipped at the borders), as a reciprocal
+    // so the inner loop has no division
+    columnScale.create(1, cols, CV_64F);
+    double *widthInv = columnScale.ptr<double>(0);
+    for (int x = 0; x < cols; ++x) {
+        widthInv[x] = 1.0 / double(std::min(cols, x + half + 1) - std::max(0, x - half));
+    }
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range &band) {
+        for (int y = band.start; y < band.end; ++y) {
+            const int y0 = std::max(0, y - half);
+            const int y1 = std::min(rows, y + half + 1);
+            const double heightInv = 1.0 / double(y1 - y0);
+            const int *s0 = sum.ptr<int>(y0);
+            const int *s1 = sum.ptr<int>(y1);
+            const double *q0 = sqsum.ptr<double>(y0);
+            const double *q1 = sqsum.ptr<double>(y1);
+            const uchar *src = luma.ptr<uchar>(y);
+            uchar *dst = binary.ptr<uchar>(y);
+
+            for (int x = 0; x < cols; ++x) {
+                const int x0 = std::max(0, x - half);
+                const int x1 = std::min(cols, x + half + 1);
+                const double inv = heightInv * widthInv[x];
+
+                const double mean = (s1[x1] - s1[x0] - s0[x1] + s0[x0]) * inv;
+                const double sq = (q1[x1] - q1[x0] - q0[x1] + q0[x0]) * inv;
+                const double stddev = std::sqrt(std::max(sq - mean * mean, 0.0));
+
+                // Both methods expect dark text. For light text work on
+                // the inverted image, whose mean is 255 - mean and whose
+                // deviation is unchanged
+                const double m = lightText ? 255.0 - mean : mean;
+                const double t = sauvola ? m * (1.0 + k * (stddev / kSauvolaRange - 1.0))
+                                         : m + k * stddev;
+
+                if (lightText) {
+                    // Text in the inverted image is at or below t
+                    dst[x] = (255 - src[x]) <= t ? 255 : 0;
+                } else {
+                    // Background is above t
+                    dst[x] = src[x] > t ? 255 : 0;
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,72 @@
+/*
+ * adaptivebinarizer.h - Local Adaptive Binarization Header
+ *
+ * Purpose: Thresholds a luma image with a threshold computed per pixel
+ * from its neighbourhood instead of one global Otsu threshold, so text
+ * survives camera vignetting, uneven lighting and screen glare:
+ * - Sauvola: T = m * (1 + k * (s / R - 1))
+ * - Niblack: T = m + k * s
+ * where m and s are the mean and standard deviation of a square window.
+ *
+ * Window statistics come from integral images of the values and their
+ * squares, so the cost does not depend on the window size. Both the
+ * integral images and the thresholding run in parallel row bands
+ * (cv::parallel_for_).
+ */
+
+#ifndef ADAPTIVEBINARIZER_H
+#define ADAPTIVEBINARIZER_H
+
+#include <opencv2/core.hpp>
+
+// How a frame is split into two classes
+enum class ThresholdMethod {
+    Otsu,     // One global threshold (fast, fails under uneven light)
+    Sauvola,  // Local, suppresses flat background well
+    Niblack   // Local, keeps faint strokes but also background noise
+};
+
+// Get a printable name for a method ("otsu", "sauvola", "niblack")
+const char *thresholdMethodName(ThresholdMethod method);
+
+// Not thread-safe: keeps its integral images between calls so that a
+// stream of equally sized frames allocates nothing. Use one per thread.
+class AdaptiveBinarizer
+{
+public:
+    // method: Sauvola or Niblack (Otsu is handled by the callers)
+    // window: odd window size in pixels, 0 picks one from the frame height
+    // k: method parameter, 0 picks the usual value (Sauvola 0.2,
+    //    Niblack -0.2)
+    explicit AdaptiveBinarizer(ThresholdMethod method = ThresholdMethod::Sauvola,
+                               int window = 0, double k = 0.0);
+
+    // Threshold a CV_8UC1 luma image into a 0/255 binary where 255 marks
+    // the brighter class, like cv::THRESH_BINARY. lightText tells which
+    // class is text: the local threshold is always placed relative to the
+    // text, as these methods assume text darker than its surroundings.
+    // binary is reallocated only if its size or type differ.
+    void apply(const cv::Mat &luma, cv::Mat &binary, bool lightText);
+
+    // Configuration
+    void setMethod(ThresholdMethod method) { thresholdMethod = method; }
+    ThresholdMethod method() const { return thresholdMethod; }
+    void setWindow(int window) { windowSize = window; }
+
+    // Window size used for a frame of the given height
+    int windowFor(int rows) const;
+
+private:
+    // Fill the integral images of luma (parallel over rows, then columns)
+    void computeIntegrals(const cv::Mat &luma);
+
+    ThresholdMethod thresholdMethod;
+    int windowSize;   // 0 = automatic
+    double kParam;    // 0 = default for the method
+
+    cv::Mat sum;      // CV_32S (rows + 1) x (cols + 1), sum of values
+    cv::Mat sqsum;    // CV_64F (rows + 1) x (cols + 1), sum of squares
+    cv::Mat columnScale;  // CV_64F 1 x cols, 1 / window width per column
+};
+
+#endif // ADAPTIVEBINARIZER_H
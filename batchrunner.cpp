@@ -0,0 +1,770 @@
+/*
+ * batchrunner.cpp - Headless Batch Mode Implementation
+ *
+ * Purpose: Implements command line parsing, input enumeration and the
+ * decode -> OCR loop of batch mode
+ */
+
+#include "batchrunner.h"
+#include "videoprocessor.h"
+#include "ocrprescale.h"
+#include "pipelinestats.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QDebug>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace {
+
+// Files with these extensions are read as still images, anything else
+// is handed to cv::VideoCapture
+bool isImageFile(const QString &path)
+{
+    static const QStringList extensions = {
+        "png", "jpg", "jpeg", "bmp", "tif", "tiff", "webp", "pbm", "pgm", "ppm"
+    };
+    return extensions.contains(QFileInfo(path).suffix().toLower());
+}
+
+// Frame ranges shorter than this are not worth a seek and two threads
+constexpr double kMinChunkSeconds = 30.0;
+
+// Cues of neighboring ranges are joined when they touch: both sides
+// compute the boundary time from the same frame index
+constexpr double kChunkJoinToleranceMs = 0.5;
+
+// SRT timestamp: hours:minutes:seconds,milliseconds
+QString srtTime(double ms)
+{
+    const qint64 total = qint64(std::max(0.0, ms) + 0.5);
+    return QString("%1:%2:%3,%4")
+        .arg(total / 3600000, 2, 10, QChar('0'))
+        .arg(total / 60000 % 60, 2, 10, QChar('0'))
+        .arg(total / 1000 % 60, 2, 10, QChar('0'))
+        .arg(total % 1000, 3, 10, QChar('0'));
+}
+
+} // namespace
+
+BatchRunner::BatchRunner(QObject *parent)
+    : QObject(parent)
+    , frameStride(1)
+    , format(OutputFormat::Jsonl)
+    , foreground("#ffffff")
+    , background("#000000")
+    , engineCount(0)
+    , fullFrame(false)
+    , threshold(ThresholdMethod::Otsu)
+    , glyphHeight(OcrPrescale::kDefaultGlyphHeight)
+    , deadlineMsecs(0)
+    , fuseFrames(0)
+    , fuseMethod(FusionMethod::Average)
+    , subtitleMode(false)
+    , chunkCount(1)
+    , bandTop(0.75)
+    , bandBottom(1.0)
+    , videoProcessor(nullptr)
+    , inputIndex(0)
+    , videoFrameIndex(0)
+    , videoFps(0.0)
+    , maxInFlight(1)
+    , chunksRunning(0)
+    , cueNumber(0)
+    , framesDecoded(0)
+    , framesProcessed(0)
+    , framesUnchanged(0)
+    , cuesWritten(0)
+    , videoMs(0.0)
+{
+}
+
+BatchRunner::~BatchRunner()
+{
+    // Stop their threads before the processor they submit to goes
+    qDeleteAll(extractors);
+
+    if (capture.isOpened()) {
+        capture.release();
+    }
+}
+
+bool BatchRunner::isBatchInvocation(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--batch") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BatchRunner::attachConsole()
+{
+#ifdef Q_OS_WIN
+    // A GUI program inherits only the handles the caller redirected; the
+    // others are unset and must be opened on the parent's console
+    auto unset = [](DWORD stream) {
+        HANDLE handle = GetStdHandle(stream);
+        return handle == nullptr || handle == INVALID_HANDLE_VALUE
+               || GetFileType(handle) == FILE_TYPE_UNKNOWN;
+    };
+    const bool outUnset = unset(STD_OUTPUT_HANDLE);
+    const bool errUnset = unset(STD_ERROR_HANDLE);
+    if ((!outUnset && !errUnset) || !AttachConsole(ATTACH_PARENT_PROCESS)) {
+        return;
+    }
+
+    FILE *stream = nullptr;
+    if (outUnset) {
+        freopen_s(&stream, "CONOUT$", "w", stdout);
+    }
+    if (errUnset) {
+        freopen_s(&stream, "CONOUT$", "w", stderr);
+    }
+#endif
+}
+
+bool BatchRunner::parseArguments(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Run OCR over video files and image folders without the GUI");
+    parser.addHelpOption();
+
+    QCommandLineOption batchOption("batch", "Run in headless batch mode.");
+    QCommandLineOption strideOption("stride", "OCR every <n>th video frame (default 1).", "n", "1");
+    QCommandLineOption formatOption("format",
+                                    "Output format: jsonl, text or srt (srt with --subtitles "
+                                    "only; default jsonl).",
+                                    "format", "jsonl");
+    QCommandLineOption outputOption({"o", "output"},
+                                    "Write results to <file> instead of stdout. With "
+                                    "--subtitles, a folder gets one file per video.",
+                                    "file");
+    QCommandLineOption enginesOption("engines", "Number of OCR engines (default: physical cores).",
+                                     "n", "0");
+    QCommandLineOption darkTextOption("dark-text",
+                                      "Text is dark on a light background (default: light on dark).");
+    QCommandLineOption fullFrameOption("full-frame",
+                                       "OCR whole frames instead of detected text regions only.");
+
+    QCommandLineOption thresholdOption("threshold",
+                                       "Threshold method: otsu, sauvola or niblack (default otsu).",
+                                       "method", "otsu");
+
+    QCommandLineOption glyphHeightOption("glyph-height",
+                                         "Rescale OCR input to this text height in pixels, "
+                                         "0 = native resolution (default 30).",
+                                         "px", QString::number(OcrPrescale::kDefaultGlyphHeight));
+
+    QCommandLineOption deadlineOption("deadline",
+                                      "Give up on an image after <ms> milliseconds, "
+                                      "0 = no limit (default).",
+                                      "ms", "0");
+
+    QCommandLineOption fuseOption("fuse",
+                                  "Fuse the <n> video frames up to each OCR'd frame into one "
+                                  "denoised image, 0 = off (default).",
+                                  "n", "0");
+
+    QCommandLineOption fuseMethodOption("fuse-method",
+                                        "How frames are fused: average or median (default average).",
+                                        "method", "average");
+
+    QCommandLineOption statsOption("stats", "Write per-stage pipeline statistics as JSON to <file>.",
+                                   "file");
+
+    QCommandLineOption subtitlesOption("subtitles",
+                                       "Extract timed subtitles (or a ticker) from the videos "
+                                       "instead of reading every frame.");
+
+    QCommandLineOption bandOption("band",
+                                  "Band of the frame holding the subtitles, as top:bottom "
+                                  "fractions of the frame height (default 0.75:1).",
+                                  "top:bottom", "0.75:1");
+
+    QCommandLineOption chunksOption("chunks",
+                                    "With --subtitles, split each video into <n> frame ranges "
+                                    "read at once, 0 = one per OCR engine (default 1).",
+                                    "n", "1");
+
+    parser.addOptions({batchOption, strideOption, formatOption, outputOption,
+                       enginesOption, darkTextOption, fullFrameOption, thresholdOption,
+                       glyphHeightOption, deadlineOption, fuseOption, fuseMethodOption,
+                       statsOption, subtitlesOption, bandOption, chunksOption});
+    parser.addPositionalArgument("inputs", "Video files, image files or image folders.",
+                                 "<input>...");
+
+    parser.process(arguments);
+
+    QTextStream err(stderr);
+
+    bool ok = false;
+    frameStride = parser.value(strideOption).toInt(&ok);
+    if (!ok || frameStride < 1) {
+        err << "Invalid --stride, expected a positive number\n";
+        return false;
+    }
+
+    engineCount = parser.value(enginesOption).toInt(&ok);
+    if (!ok || engineCount < 0) {
+        err << "Invalid --engines, expected a number\n";
+        return false;
+    }
+
+    subtitleMode = parser.isSet(subtitlesOption);
+
+    QString formatName = parser.value(formatOption);
+    if (formatName == "jsonl") {
+        format = OutputFormat::Jsonl;
+    } else if (formatName == "text") {
+        format = OutputFormat::Text;
+    } else if (formatName == "srt" && subtitleMode) {
+        format = OutputFormat::Srt;
+    } else {
+        err << (subtitleMode ? "Invalid --format, expected jsonl, text or srt\n"
+                             : "Invalid --format, expected jsonl or text (srt needs --subtitles)\n");
+        return false;
+    }
+
+    const QStringList band = parser.value(bandOption).split(':');
+    bool topOk = false;
+    bool bottomOk = false;
+    if (band.size() == 2) {
+        bandTop = band[0].toDouble(&topOk);
+        bandBottom = band[1].toDouble(&bottomOk);
+    }
+    if (!topOk || !bottomOk || bandTop < 0.0 || bandBottom > 1.0 || bandTop >= bandBottom) {
+        err << "Invalid --band, expected top:bottom fractions such as 0.75:1\n";
+        return false;
+    }
+
+    if (parser.isSet(darkTextOption)) {
+        // Same as the "Black on White" scheme of the main window
+        foreground = QColor("#000000");
+        background = QColor("#ffffff");
+    }
+
+    glyphHeight = parser.value(glyphHeightOption).toInt(&ok);
+    if (!ok || glyphHeight < 0) {
+        err << "Invalid --glyph-height, expected a number of pixels\n";
+        return false;
+    }
+
+    deadlineMsecs = parser.value(deadlineOption).toInt(&ok);
+    if (!ok || deadlineMsecs < 0) {
+        err << "Invalid --deadline, expected milliseconds\n";
+        return false;
+    }
+
+    fuseFrames = parser.value(fuseOption).toInt(&ok);
+    if (!ok || fuseFrames < 0) {
+        err << "Invalid --fuse, expected a number of frames\n";
+        return false;
+    }
+
+    QString fusion = parser.value(fuseMethodOption);
+    if (fusion == fusionMethodName(FusionMethod::Average)) {
+        fuseMethod = FusionMethod::Average;
+    } else if (fusion == fusionMethodName(FusionMethod::Median)) {
+        fuseMethod = FusionMethod::Median;
+    } else {
+        err << "Invalid --fuse-method, expected average or median\n";
+        return false;
+    }
+    chunkCount = parser.value(chunksOption).toInt(&ok);
+    if (!ok || chunkCount < 0) {
+        err << "Invalid --chunks, expected a number\n";
+        return false;
+    }
+    if (!subtitleMode && chunkCount != 1) {
+        err << "--chunks needs --subtitles\n";
+        return false;
+    }
+
+    if (subtitleMode && fuseFrames > 0) {
+        err << "--fuse cannot be combined with --subtitles\n";
+        return false;
+    }
+    videoFusion.configure(fuseFrames, fuseMethod);
+
+    fullFrame = parser.isSet(fullFrameOption);
+
+    QString method = parser.value(thresholdOption);
+    if (method == thresholdMethodName(ThresholdMethod::Otsu)) {
+        threshold = ThresholdMethod::Otsu;
+    } else if (method == thresholdMethodName(ThresholdMethod::Sauvola)) {
+        threshold = ThresholdMethod::Sauvola;
+    } else if (method == thresholdMethodName(ThresholdMethod::Niblack)) {
+        threshold = ThresholdMethod::Niblack;
+    } else {
+        err << "Invalid --threshold, expected otsu, sauvola or niblack\n";
+        return false;
+    }
+    statsPath = parser.value(statsOption);
+
+    if (parser.isSet(outputOption)) {
+        const QString path = parser.value(outputOption);
+        if (!QFileInfo(path).isDir()) {
+            output.setFileName(path);
+        } else if (subtitleMode) {
+            outputDir = path;
+        } else {
+            err << "--output is a folder, expected a file\n";
+            return false;
+        }
+    }
+
+    if (!collectInputs(parser.positionalArguments())) {
+        return false;
+    }
+
+    if (inputs.isEmpty()) {
+        err << "No inputs given\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool BatchRunner::collectInputs(const QStringList &paths)
+{
+    for (const QString &path : paths) {
+        QFileInfo info(path);
+
+        if (info.isDir()) {
+            // Image folders: every image file, in name order
+            QDir dir(path);
+            const QStringList entries = dir.entryList(QDir::Files, QDir::Name);
+            for (const QString &entry : entries) {
+                if (isImageFile(entry)) {
+                    inputs.append(dir.filePath(entry));
+                }
+            }
+        } else if (info.isFile()) {
+            inputs.append(path);
+        } else {
+            QTextStream(stderr) << "Input not found: " << path << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+void BatchRunner::start()
+{
+    if (!outputDir.isEmpty()) {
+        // Opened per video, see nextSubtitles
+    } else if (output.fileName().isEmpty()) {
+        output.open(stdout, QIODevice::WriteOnly);
+    } else if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QTextStream(stderr) << "Could not open " << output.fileName() << " for writing\n";
+        QCoreApplication::exit(1);
+        return;
+    }
+
+    // Same preprocessing and OCR engines as the camera path
+    videoProcessor = new VideoProcessor(this, engineCount);
+    connect(videoProcessor, &VideoProcessor::ocrResult,
+            this, &BatchRunner::onOCRResult);
+    videoProcessor->setRegionProposals(!fullFrame);
+    videoProcessor->setThresholdMethod(threshold);
+    videoProcessor->setPrescaleHeight(glyphHeight);
+    videoProcessor->setOCRDeadline(deadlineMsecs);
+
+    // Keep every engine busy with one job queued behind it, without
+    // decoding a whole video into memory ahead of the OCR
+    maxInFlight = 2 * videoProcessor->ocrEngineCount();
+
+    timer.start();
+    if (subtitleMode) {
+        nextSubtitles();
+    } else {
+        pump();
+    }
+}
+
+void BatchRunner::nextSubtitles()
+{
+    SubtitleExtractor::Options options;
+    options.bandTop = bandTop;
+    options.bandBottom = bandBottom;
+    options.stride = frameStride;
+    options.foreground = foreground;
+    options.background = background;
+    options.threshold = threshold;
+
+    while (inputIndex < inputs.size()) {
+        const QString path = inputs[inputIndex++];
+        if (isImageFile(path)) {
+            qWarning() << "Skipping image" << path << "- subtitles are read from videos";
+            continue;
+        }
+
+        if (!outputDir.isEmpty()) {
+            // One file per video, named after it
+            static const char *const extensions[] = {"jsonl", "txt", "srt"};
+            output.close();
+            output.setFileName(QDir(outputDir).filePath(
+                QFileInfo(path).completeBaseName() + "." + extensions[int(format)]));
+            if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                QTextStream(stderr) << "Could not open " << output.fileName() << " for writing\n";
+                QCoreApplication::exit(1);
+                return;
+            }
+            cueNumber = 0;
+        }
+
+        const auto ranges = planChunks(path);
+        if (startSubtitles(path, options, ranges)) {
+            return;
+        }
+
+        // A range could not seek (e.g. the frame count was off): read the
+        // video in one piece
+        if (ranges.size() > 1 && startSubtitles(path, options, {{0, -1}})) {
+            return;
+        }
+    }
+
+    finish();
+}
+
+std::vector<std::pair<qint64, qint64>> BatchRunner::planChunks(const QString &path) const
+{
+    std::vector<std::pair<qint64, qint64>> ranges;
+
+    int chunks = chunkCount > 0 ? chunkCount : videoProcessor->ocrEngineCount();
+    if (chunks > 1) {
+        // Containers may only estimate the frame count; the last range
+        // reads to the real end, so an estimate is good enough
+        cv::VideoCapture probe(path.toStdString());
+        const double fps = probe.get(cv::CAP_PROP_FPS);
+        const qint64 frames = qint64(probe.get(cv::CAP_PROP_FRAME_COUNT));
+        chunks = fps > 0.0 && frames > 0
+                     ? int(std::min<qint64>(chunks, qint64(frames / (kMinChunkSeconds * fps))))
+                     : 1;
+
+        // Boundaries on the stride grid, so the ranges together look at
+        // the same frames as a single pass
+        for (int i = 0; i < chunks && chunks > 1; i++) {
+            qint64 start = frames * i / chunks;
+            start -= start % frameStride;
+            qint64 end = -1;
+            if (i + 1 < chunks) {
+                end = frames * (i + 1) / chunks;
+                end -= end % frameStride;
+            }
+            ranges.emplace_back(start, end);
+        }
+    }
+
+    if (ranges.empty()) {
+        ranges.emplace_back(0, -1);
+    }
+    return ranges;
+}
+
+bool BatchRunner::startSubtitles(const QString &path, SubtitleExtractor::Options options,
+                                 const std::vector<std::pair<qint64, qint64>> &ranges)
+{
+    const int chunks = int(ranges.size());
+
+    // The ranges share the engines as sources of equal priority (the
+    // first one is the processor's own): about two jobs per engine in
+    // flight in total, as for a single range
+    options.maxInFlight = std::max(2, 2 * videoProcessor->ocrEngineCount() / chunks);
+
+    stitcher.reset(new CueStitcher(chunks, kChunkJoinToleranceMs));
+    subtitleSource = path;
+
+    for (int chunk = 0; chunk < chunks; chunk++) {
+        options.startFrame = ranges[chunk].first;
+        options.endFrame = ranges[chunk].second;
+        options.source = videoProcessor->sourceId() + chunk;
+
+        SubtitleExtractor *extractor = new SubtitleExtractor(videoProcessor, path, options);
+        connect(extractor, &SubtitleExtractor::cue, this, [this, chunk](const SubtitleCue &cue) {
+            for (const SubtitleCue &stitched : stitcher->add(chunk, cue)) {
+                writeCue(subtitleSource, stitched);
+            }
+        });
+        connect(extractor, &SubtitleExtractor::finished, this, [this, chunk]() {
+            chunkFinished(chunk);
+        });
+        extractors.push_back(extractor);
+    }
+
+    for (SubtitleExtractor *extractor : extractors) {
+        if (!extractor->start()) {
+            qDeleteAll(extractors);
+            extractors.clear();
+            stitcher.reset();
+            return false;
+        }
+    }
+
+    chunksRunning = chunks;
+    return true;
+}
+
+void BatchRunner::chunkFinished(int chunk)
+{
+    SubtitleExtractor *extractor = extractors[chunk];
+    SubtitleExtractor::Counters counters = extractor->counters();
+    framesDecoded += counters.decoded;
+    framesProcessed += counters.recognized;
+    framesUnchanged += counters.unchanged;
+    videoMs += extractor->durationMs();
+
+    for (const SubtitleCue &stitched : stitcher->finish(chunk)) {
+        writeCue(subtitleSource, stitched);
+    }
+
+    if (--chunksRunning > 0) {
+        return;
+    }
+
+    // Deleted once their finished signals have returned
+    for (SubtitleExtractor *done : extractors) {
+        done->deleteLater();
+    }
+    extractors.clear();
+    stitcher.reset();
+
+    nextSubtitles();
+}
+
+void BatchRunner::pump()
+{
+    while (int(inFlight.size()) < maxInFlight) {
+        cv::Mat image;
+        JobInfo info;
+        if (!nextImage(image, info)) {
+            break;
+        }
+
+        quint64 jobId = videoProcessor->performOCR(image, foreground, background);
+        inFlight[jobId] = info;
+    }
+
+    // Nothing left to read and nothing outstanding
+    if (inFlight.empty()) {
+        finish();
+    }
+}
+
+void BatchRunner::pushFusionFrame(const cv::Mat &frame)
+{
+    cv::Mat luma;
+    if (frame.channels() == 3) {
+        cv::cvtColor(frame, luma, cv::COLOR_BGR2GRAY);
+    } else {
+        luma = frame;
+    }
+    videoFusion.push(luma);
+}
+
+bool BatchRunner::nextImage(cv::Mat &image, JobInfo &info)
+{
+    while (inputIndex < inputs.size()) {
+        const QString path = inputs[inputIndex];
+
+        if (isImageFile(path)) {
+            inputIndex++;
+
+            // The pipeline only needs luma, let the decoder produce it
+            image = cv::imread(path.toStdString(), cv::IMREAD_GRAYSCALE);
+            if (image.empty()) {
+                qWarning() << "Could not read image" << path;
+                continue;
+            }
+
+            info = JobInfo{path, 0, 0.0};
+            framesDecoded++;
+            return true;
+        }
+
+        if (!capture.isOpened()) {
+            if (!capture.open(path.toStdString())) {
+                qWarning() << "Could not open video" << path;
+                inputIndex++;
+                continue;
+            }
+            videoFrameIndex = 0;
+            videoFps = capture.get(cv::CAP_PROP_FPS);
+            videoFusion.clear();
+        }
+
+        // Skip frames between strides; grab() spares us their retrieval
+        // and color conversion. Frames fused into the next OCR'd one are
+        // retrieved
+        bool ok = true;
+        while (ok && videoFrameIndex % frameStride != 0) {
+            const int framesAhead = frameStride - int(videoFrameIndex % frameStride);
+            if (framesAhead < videoFusion.capacity()) {
+                cv::Mat skipped;
+                ok = capture.read(skipped);
+                if (ok) {
+                    pushFusionFrame(skipped);
+                }
+            } else {
+                ok = capture.grab();
+            }
+            if (ok) {
+                videoFrameIndex++;
+                framesDecoded++;
+            }
+        }
+
+        if (ok && capture.read(image)) {
+            if (videoFusion.capacity() > 0) {
+                // OCR the fusion of this frame and the ones before it
+                pushFusionFrame(image);
+                ScopedStageTimer timer(PipelineStats::CaptureFusion);
+                videoFusion.fuse(image);
+            }
+
+            double timestampMs = videoFps > 0.0
+                                     ? videoFrameIndex * 1000.0 / videoFps
+                                     : capture.get(cv::CAP_PROP_POS_MSEC);
+            info = JobInfo{path, videoFrameIndex, timestampMs};
+            videoFrameIndex++;
+            framesDecoded++;
+            return true;
+        }
+
+        // End of this video, move on to the next input
+        capture.release();
+        inputIndex++;
+    }
+
+    return false;
+}
+
+void BatchRunner::onOCRResult(quint64 jobId, const QString &text)
+{
+    auto it = inFlight.find(jobId);
+    if (it == inFlight.end()) {
+        return;
+    }
+
+    writeResult(it->second, text);
+    inFlight.erase(it);
+    framesProcessed++;
+
+    // A slot freed up, keep the engines fed
+    pump();
+}
+
+void BatchRunner::writeResult(const JobInfo &info, const QString &text)
+{
+    QByteArray line;
+
+    if (format == OutputFormat::Jsonl) {
+        QJsonObject object;
+        object["source"] = info.source;
+        object["frame"] = info.frameIndex;
+        object["timestamp_ms"] = info.timestampMs;
+        object["text"] = text.trimmed();
+        line = QJsonDocument(object).toJson(QJsonDocument::Compact);
+    } else {
+        line = QString("%1 #%2 @ %3 ms: %4")
+                   .arg(info.source)
+                   .arg(info.frameIndex)
+                   .arg(info.timestampMs, 0, 'f', 0)
+                   .arg(text.trimmed().replace('\n', ' '))
+                   .toUtf8();
+    }
+
+    line.append('\n');
+    output.write(line);
+    output.flush();
+}
+
+void BatchRunner::writeCue(const QString &source, const SubtitleCue &cue)
+{
+    QByteArray text;
+
+    if (format == OutputFormat::Srt) {
+        // Numbered from 1 in each file
+        text = QString("%1\n%2 --> %3\n%4\n\n")
+                   .arg(++cueNumber)
+                   .arg(srtTime(cue.startMs))
+                   .arg(srtTime(cue.endMs))
+                   .arg(cue.text)
+                   .toUtf8();
+    } else if (format == OutputFormat::Jsonl) {
+        QJsonObject object;
+        object["source"] = source;
+        object["start_ms"] = cue.startMs;
+        object["end_ms"] = cue.endMs;
+        object["text"] = cue.text;
+        text = QJsonDocument(object).toJson(QJsonDocument::Compact);
+        text.append('\n');
+    } else {
+        text = QString("%1 %2 - %3 ms: %4\n")
+                   .arg(source)
+                   .arg(cue.startMs, 0, 'f', 0)
+                   .arg(cue.endMs, 0, 'f', 0)
+                   .arg(QString(cue.text).replace('\n', ' '))
+                   .toUtf8();
+    }
+
+    output.write(text);
+    output.flush();
+    cuesWritten++;
+}
+
+void BatchRunner::finish()
+{
+    double seconds = timer.elapsed() / 1000.0;
+    if (seconds <= 0.0) {
+        seconds = 0.001;
+    }
+
+    QTextStream(stderr) << QString("Processed %1 frames (%2 decoded) in %3 s: "
+                                   "%4 frames/s OCR, %5 frames/s decoded\n")
+                               .arg(framesProcessed)
+                               .arg(framesDecoded)
+                               .arg(seconds, 0, 'f', 2)
+                               .arg(framesProcessed / seconds, 0, 'f', 1)
+                               .arg(framesDecoded / seconds, 0, 'f', 1);
+
+    if (subtitleMode) {
+        QTextStream(stderr) << QString("Subtitles: %1 cues, %2 bands unchanged (not read), "
+                                       "%3 s of video at %4x real time\n")
+                                   .arg(cuesWritten)
+                                   .arg(framesUnchanged)
+                                   .arg(videoMs / 1000.0, 0, 'f', 1)
+                                   .arg(videoMs / 1000.0 / seconds, 0, 'f', 1);
+    }
+
+    output.close();
+
+    if (!statsPath.isEmpty()) {
+        QFile statsFile(statsPath);
+        if (statsFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            statsFile.write(QJsonDocument(videoProcessor->statsSnapshot()).toJson());
+        } else {
+            QTextStream(stderr) << "Could not open " << statsPath << " for writing\n";
+        }
+    }
+
+    QCoreApplication::quit();
+}
@@ -0,0 +1,158 @@
+/*
+ * batchrunner.h - Headless Batch Mode Header
+ *
+ * Purpose: Runs OCR over video files and image folders without the GUI
+ * (VideoOCR --batch). Uses the same VideoProcessor preprocessing and
+ * OCR engine pool as the camera path, and writes one result per line
+ * to stdout or a file, as JSONL or plain text.
+ *
+ * With --subtitles, videos are turned into timed cues instead (see
+ * SubtitleExtractor), written as JSONL, plain text or SRT. A long video
+ * can be split into frame ranges read side by side (--chunks).
+ */
+
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QColor>
+#include <opencv2/videoio.hpp>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "adaptivebinarizer.h"
+#include "framefusion.h"
+#include "subtitleextractor.h"
+
+class VideoProcessor;
+
+class BatchRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BatchRunner(QObject *parent = nullptr);
+    ~BatchRunner();
+
+    // Check if the command line asks for batch mode (before any
+    // QCoreApplication exists, so we know which kind to create)
+    static bool isBatchInvocation(int argc, char *argv[]);
+
+    // Send stdout and stderr to the console batch mode was started from.
+    // Only needed on Windows, where the GUI build gets no console of its
+    // own; streams redirected by the caller are left alone
+    static void attachConsole();
+
+    // Parse the command line. Returns false (after printing why) if the
+    // arguments are invalid
+    bool parseArguments(const QStringList &arguments);
+
+public slots:
+    // Slot: Start processing; quits the application when done
+    void start();
+
+private slots:
+    // Slot: Called for every OCR result, in submission order
+    void onOCRResult(quint64 jobId, const QString &text);
+
+private:
+    // How results are written
+    enum class OutputFormat {
+        Jsonl,  // One JSON object per line
+        Text,   // One plain line per result
+        Srt     // SubRip subtitles (--subtitles only)
+    };
+
+    // Where a submitted job came from
+    struct JobInfo {
+        QString source;     // File path
+        qint64 frameIndex;  // Frame number within a video, 0 for images
+        double timestampMs; // Position within a video, 0 for images
+    };
+
+    // Expand input arguments into a list of files (folders are listed)
+    bool collectInputs(const QStringList &paths);
+
+    // Submit work until enough jobs are in flight or inputs run out
+    void pump();
+
+    // Read the next frame to OCR; returns false when all inputs are done
+    bool nextImage(cv::Mat &image, JobInfo &info);
+
+    // Add a decoded video frame to the fusion buffer
+    void pushFusionFrame(const cv::Mat &frame);
+
+    // Print results summary and quit
+    void finish();
+
+    // Write one result line
+    void writeResult(const JobInfo &info, const QString &text);
+
+    // Start extracting the subtitles of the next video input; finishes
+    // when there is none left
+    void nextSubtitles();
+
+    // Frame ranges [start, end) to split a video into; one range (0, -1)
+    // for the whole video if it is short or its length is unknown
+    std::vector<std::pair<qint64, qint64>> planChunks(const QString &path) const;
+
+    // Start an extractor per range. Returns false if one cannot start
+    bool startSubtitles(const QString &path, SubtitleExtractor::Options options,
+                        const std::vector<std::pair<qint64, qint64>> &ranges);
+
+    // A range of the current video is complete
+    void chunkFinished(int chunk);
+
+    // Write one subtitle cue
+    void writeCue(const QString &source, const SubtitleCue &cue);
+
+    // Options
+    QStringList inputs;         // Files to process, in order
+    int frameStride;            // OCR every Nth video frame
+    OutputFormat format;        // How results are written
+    QColor foreground;          // Scheme colors, decide the text polarity
+    QColor background;
+    int engineCount;            // OCR engines, 0 = one per physical core
+    bool fullFrame;             // Disable text region proposals
+    ThresholdMethod threshold;  // Global or local thresholding
+    int glyphHeight;            // OCR input glyph height, 0 = native
+    int deadlineMsecs;          // Per-image OCR time limit, 0 = none
+    int fuseFrames;             // Video frames fused per OCR, 0 = off
+    FusionMethod fuseMethod;    // How they are fused
+    QString statsPath;          // Pipeline statistics JSON, if requested
+    bool subtitleMode;          // Timed cues instead of per-frame results
+    int chunkCount;             // Ranges per video, 0 = one per engine
+    double bandTop;             // Subtitle band, fractions of the height
+    double bandBottom;
+    QString outputDir;          // One output file per video, if set
+
+    // Processing state
+    VideoProcessor *videoProcessor;  // Shared preprocessing and OCR pool
+    QFile output;                    // Result destination
+    int inputIndex;                  // Current entry of inputs
+    cv::VideoCapture capture;        // Open video, if the input is one
+    qint64 videoFrameIndex;          // Next frame number of the open video
+    double videoFps;                 // Frame rate of the open video
+    std::map<quint64, JobInfo> inFlight;  // Submitted, not yet reported
+    FrameFusion videoFusion;         // Frames leading up to the next OCR
+    int maxInFlight;                 // Backpressure limit on inFlight
+    std::vector<SubtitleExtractor *> extractors;  // Ranges of the current video
+    std::unique_ptr<CueStitcher> stitcher;        // Their cues, in order
+    int chunksRunning;               // Ranges not complete yet
+    QString subtitleSource;          // Current video
+    int cueNumber;                   // Last SRT cue number written
+
+    // Statistics
+    QElapsedTimer timer;             // Started in start()
+    qint64 framesDecoded;            // Frames read from videos and images
+    qint64 framesProcessed;          // OCR results written
+    qint64 framesUnchanged;          // Subtitle bands not read again
+    qint64 cuesWritten;              // Subtitle cues written
+    double videoMs;                  // Length of the videos read
+};
+
+#endif // BATCHRUNNER_H
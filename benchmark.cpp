@@ -0,0 +1,1677 @@
+/*
+ * benchmark.cpp - Frame Pipeline Microbenchmarks
+ *
+ * Purpose: Standalone benchmark executable (videoocr_bench) that measures
+ * every stage of the frame pipeline in isolation:
+ * - ingest:        QVideoFrame -> luma (FrameIngest) per pixel format
+ * - threshold:     Otsu per frame vs. estimated over time (ThresholdEstimator)
+ *                  vs. local (Sauvola, Niblack, cv::adaptiveThreshold);
+ *                  Sauvola and Niblack are checked against brute-force
+ *                  window sums
+ * - colorize:      binary -> scheme colors, per instruction set
+ * - ocr-prep:      luma -> Tesseract binary vs. the original chain
+ * - prescale:      glyph height estimate and resize of the OCR input
+ * - scene:         Auto OCR's change detection on a noisy dashboard where
+ *                  a single reading changes; must fire once per scene
+ * - fusion:        ring buffer push and multi-frame fusion of a capture,
+ *                  with the noise left after fusing
+ * - process-frame: VideoProcessor::processFrame end to end
+ * - regions:       text region proposals on rendered text
+ * - tracking:      text region tracking of a changing dashboard and a
+ *                  scrolling ticker, with the regions re-read per frame
+ * - subtitles:     which bands of a subtitle over noisy, moving video are
+ *                  read again; every new subtitle must be
+ * - cues:          merging synthetic readings into subtitle cues and
+ *                  stitching the cues of frame ranges, checked against
+ *                  the expected cues
+ * - ocr-log:       appending recognitions to the OCR log, and searches
+ *                  for a rare part number and a common word in two weeks
+ *                  of results from four cameras
+ * - ocr:           OCRWorker::processOCR latency percentiles
+ * - ocr-sources:   latency of a quiet camera next to a busy one sharing
+ *                  the engine pool, per scheduling policy
+ * - engine-init:   Tesseract engine start-up time and private memory,
+ *                  from the file vs. from the shared model (OcrModel)
+ *
+ * Frames are synthetic, from 480p to 4K. Kernels are checked for
+ * bit-exact output against their reference before they are timed.
+ *
+ * Usage: videoocr_bench [--json] [--filter <stage>] [--no-ocr]
+ *   --json    one JSON object per line, for regression tracking
+ *   --filter  only run stages whose name contains the given text
+ *   --no-ocr  skip the stages that need Tesseract
+ */
+
+#include "monochromekernel.h"
+#include "ocrpreprocess.h"
+#include "frameingest.h"
+#include "textregions.h"
+#include "ocrenginepool.h"
+#include "videoprocessor.h"
+#include "framearena.h"
+#include "adaptivebinarizer.h"
+#include "thresholdestimator.h"
+#include "ocrprescale.h"
+#include "ocrmodel.h"
+#include "framefusion.h"
+#include "texttracker.h"
+#include "ocrlog.h"
+#include "ocrresultcache.h"
+#include "scenechangedetector.h"
+#include "subtitleextractor.h"
+#include <QGuiApplication>
+#include <QTemporaryDir>
+#include <QImage>
+#include <QPainter>
+#include <QFont>
+#include <QVideoSink>
+#include <QVideoFrame>
+#include <QVideoFrameFormat>
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+// ===================== Allocation Counting =====================
+// On glibc every heap allocation (C++, Qt, OpenCV) ends up in one of the
+// functions below, so the benchmark replaces them with counting wrappers
+// around glibc's own implementations.
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define BENCH_COUNT_ALLOCATIONS 1
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+}
+
+namespace {
+
+std::atomic<unsigned long long> allocationCount{0};       // All allocations
+std::atomic<unsigned long long> largeAllocationCount{0};  // Frame-sized ones
+
+// Allocations at least this big are image buffers, not bookkeeping
+const size_t kLargeAllocation = 64 * 1024;
+
+inline void countAllocation(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (size >= kLargeAllocation) {
+        largeAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+extern "C" void *malloc(size_t size) noexcept
+{
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) noexcept
+{
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) noexcept
+{
+    countAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" int posix_memalign(void **out, size_t alignment, size_t size) noexcept
+{
+    countAllocation(size);
+    void *ptr = __libc_memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+extern "C" void *aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    countAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void *memalign(size_t alignment, size_t size) noexcept
+{
+    countAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+#endif
+
+namespace {
+
+// ===================== Options and Reporting =====================
+
+struct Options {
+    bool json = false;       // Machine-readable output
+    bool runOCR = true;      // Run the Tesseract stages
+    std::string filter;      // Substring of stage names to run
+};
+
+Options options;
+
+bool stageEnabled(const char *stage)
+{
+    return options.filter.empty() || std::strstr(stage, options.filter.c_str()) != nullptr;
+}
+
+// One measured configuration of a stage
+struct Result {
+    std::string stage;       // Pipeline stage
+    std::string variant;     // Pixel format, instruction set, ...
+    std::string resolution;  // 480p ... 4K
+    double mpixels = 0.0;    // Frame size in megapixels
+    double nsPerFrame = 0.0;
+    double allocsPerFrame = -1.0;       // -1: not counted on this platform
+    double largeAllocsPerFrame = -1.0;
+    std::string status;      // "exact", "MISMATCH", or empty
+};
+
+std::string jsonEscape(const std::string &text)
+{
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+void report(const Result &result)
+{
+    double mpixelPerSecond = result.nsPerFrame > 0.0 ? result.mpixels * 1e9 / result.nsPerFrame : 0.0;
+
+    if (options.json) {
+        std::printf("{\"stage\":\"%s\",\"variant\":\"%s\",\"resolution\":\"%s\","
+                    "\"ns_per_frame\":%.0f,\"mpixel_per_s\":%.2f,"
+                    "\"allocs_per_frame\":%.2f,\"large_allocs_per_frame\":%.2f,"
+                    "\"status\":\"%s\"}\n",
+                    jsonEscape(result.stage).c_str(), jsonEscape(result.variant).c_str(),
+                    jsonEscape(result.resolution).c_str(), result.nsPerFrame, mpixelPerSecond,
+                    result.allocsPerFrame, result.largeAllocsPerFrame,
+                    jsonEscape(result.status).c_str());
+    } else {
+        std::printf("%-13s %-11s %-6s %12.0f ns/frame %9.1f Mpixel/s %7.2f allocs/frame "
+                    "(%5.2f large) %s\n",
+                    result.stage.c_str(), result.variant.c_str(), result.resolution.c_str(),
+                    result.nsPerFrame, mpixelPerSecond, result.allocsPerFrame,
+                    result.largeAllocsPerFrame, result.status.c_str());
+    }
+    std::fflush(stdout);
+}
+
+// Latency distribution of a stage (OCR)
+void reportLatency(const std::string &stage, const std::string &variant,
+                   const std::string &resolution, std::vector<double> latenciesMs)
+{
+    if (latenciesMs.empty()) {
+        return;
+    }
+    std::sort(latenciesMs.begin(), latenciesMs.end());
+
+    auto percentile = [&](double p) {
+        size_t index = std::min(latenciesMs.size() - 1, size_t(p * (latenciesMs.size() - 1) + 0.5));
+        return latenciesMs[index];
+    };
+
+    if (options.json) {
+        std::printf("{\"stage\":\"%s\",\"variant\":\"%s\",\"resolution\":\"%s\","
+                    "\"samples\":%zu,\"p50_ms\":%.2f,\"p90_ms\":%.2f,\"p99_ms\":%.2f,"
+                    "\"max_ms\":%.2f}\n",
+                    jsonEscape(stage).c_str(), jsonEscape(variant).c_str(),
+                    jsonEscape(resolution).c_str(), latenciesMs.size(), percentile(0.50),
+                    percentile(0.90), percentile(0.99), latenciesMs.back());
+    } else {
+        std::printf("%-13s %-11s %-6s p50 %8.2f ms  p90 %8.2f ms  p99 %8.2f ms  max %8.2f ms "
+                    "(%zu samples)\n",
+                    stage.c_str(), variant.c_str(), resolution.c_str(), percentile(0.50),
+                    percentile(0.90), percentile(0.99), latenciesMs.back(), latenciesMs.size());
+    }
+    std::fflush(stdout);
+}
+
+// ===================== Measurement =====================
+
+// Frame sizes used by all benchmarks
+struct Resolution {
+    const char *name;
+    int width;
+    int height;
+};
+
+const Resolution kResolutions[] = {
+    {"480p", 640, 480},
+    {"720p", 1280, 720},
+    {"1080p", 1920, 1080},
+    {"4K", 3840, 2160},
+};
+
+int iterationsFor(const Resolution &res)
+{
+    return res.height >= 2160 ? 20 : 100;
+}
+
+// Time fn over enough iterations to smooth out noise and count the heap
+// allocations it makes; fills the timing fields of result
+template <typename Fn>
+void measure(Fn &&fn, int iterations, Result &result)
+{
+    fn();  // Warm up caches and lazy allocations
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+    unsigned long long allocsBefore = allocationCount.load();
+    unsigned long long largeBefore = largeAllocationCount.load();
+#endif
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    result.nsPerFrame = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+    result.allocsPerFrame = double(allocationCount.load() - allocsBefore) / iterations;
+    result.largeAllocsPerFrame = double(largeAllocationCount.load() - largeBefore) / iterations;
+#endif
+}
+
+Result makeResult(const char *stage, const std::string &variant, const Resolution &res)
+{
+    Result result;
+    result.stage = stage;
+    result.variant = variant;
+    result.resolution = res.name;
+    result.mpixels = res.width * double(res.height) / 1e6;
+    return result;
+}
+
+// ===================== Synthetic Input =====================
+
+// Synthetic camera frame in the given pixel format: a checkerboard in
+// every plane, so thresholding has two classes to separate
+QVideoFrame makeVideoFrame(QVideoFrameFormat::PixelFormat format, int width, int height)
+{
+    QVideoFrame frame(QVideoFrameFormat(QSize(width, height), format));
+    if (!frame.map(QVideoFrame::WriteOnly)) {
+        return QVideoFrame();
+    }
+
+    for (int plane = 0; plane < frame.planeCount(); plane++) {
+        uchar *bits = frame.bits(plane);
+        const int stride = frame.bytesPerLine(plane);
+        const int rows = stride > 0 ? frame.mappedBytes(plane) / stride : 0;
+
+        for (int y = 0; y < rows; y++) {
+            uchar *row = bits + y * stride;
+            for (int x = 0; x < stride; x++) {
+                row[x] = ((x / 16 + y / 16) & 1) ? 200 : 40;
+            }
+        }
+    }
+
+    frame.unmap();
+    return frame;
+}
+
+// Pixel formats a camera typically delivers, plus one (ARGB8888) that
+// has to go through the QImage fallback of FrameIngest
+struct FormatCase {
+    const char *name;
+    QVideoFrameFormat::PixelFormat format;
+};
+
+const FormatCase kFormats[] = {
+    {"NV12", QVideoFrameFormat::Format_NV12},
+    {"YUV420P", QVideoFrameFormat::Format_YUV420P},
+    {"YUYV", QVideoFrameFormat::Format_YUYV},
+    {"UYVY", QVideoFrameFormat::Format_UYVY},
+    {"Y8", QVideoFrameFormat::Format_Y8},
+    {"BGRA8888", QVideoFrameFormat::Format_BGRA8888},
+    {"ARGB8888", QVideoFrameFormat::Format_ARGB8888},
+};
+
+// Synthetic binary frame: random 0/255 pixels, plus one row of 128s
+// to exercise the strict > 128 comparison
+cv::Mat makeBinaryFrame(int width, int height)
+{
+    cv::Mat gray(height, width, CV_8UC1);
+    cv::randu(gray, 0, 256);
+
+    cv::Mat binary;
+    cv::threshold(gray, binary, 127, 255, cv::THRESH_BINARY);
+    binary.row(0).setTo(128);
+    return binary;
+}
+
+// Synthetic camera frame: rows of light text on a dark, noisy background
+cv::Mat makeTextFrame(int width, int height)
+{
+    cv::Mat bgr(height, width, CV_8UC3, cv::Scalar(40, 40, 40));
+    double scale = height / 480.0;
+
+    for (int y = int(40 * scale); y < height; y += int(40 * scale)) {
+        cv::putText(bgr, "The quick brown fox 0123456789", cv::Point(int(10 * scale), y),
+                    cv::FONT_HERSHEY_SIMPLEX, scale, cv::Scalar(220, 220, 220), 2);
+    }
+
+    cv::Mat noise(bgr.size(), bgr.type());
+    cv::randn(noise, 0, 12);
+    cv::add(bgr, noise, bgr);
+    return bgr;
+}
+
+// Text rendered with a real font, as dark-on-light luma: a few lines
+// (sparse) or a screen full of text (dense)
+cv::Mat makeRenderedText(int width, int height, bool dense)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    image.fill(Qt::white);
+
+    QPainter painter(&image);
+    QFont font("DejaVu Sans");
+    font.setPixelSize(std::max(12, height / 30));
+    painter.setFont(font);
+    painter.setPen(Qt::black);
+
+    const int lineHeight = font.pixelSize() * 3 / 2;
+    const int lines = dense ? height / lineHeight - 1 : 3;
+    for (int i = 0; i < lines; i++) {
+        int y = dense ? (i + 1) * lineHeight : height / 3 + i * lineHeight;
+        painter.drawText(width / 20, y,
+                         QString("Line %1: Part number VX-%2 status OK, temperature 23.%3 C")
+                             .arg(i + 1)
+                             .arg(4100 + i * 7)
+                             .arg(i % 10));
+    }
+    painter.end();
+
+    QImage gray = image.convertToFormat(QImage::Format_Grayscale8);
+    cv::Mat luma(gray.height(), gray.width(), CV_8UC1,
+                 const_cast<uchar *>(gray.constBits()), gray.bytesPerLine());
+    return luma.clone();
+}
+
+// Lines of text on a dashboard of the given height
+int dashboardLines(int height)
+{
+    const int lineHeight = std::max(12, height / 30) * 3 / 2;
+    return height / lineHeight - 1;
+}
+
+// Dense text screen where line (variant % lines) shows another value,
+// like a dashboard updating one reading at a time
+cv::Mat makeDashboard(int width, int height, int variant)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    image.fill(Qt::white);
+
+    QPainter painter(&image);
+    QFont font("DejaVu Sans");
+    font.setPixelSize(std::max(12, height / 30));
+    painter.setFont(font);
+    painter.setPen(Qt::black);
+
+    const int lineHeight = font.pixelSize() * 3 / 2;
+    const int lines = dashboardLines(height);
+    for (int i = 0; i < lines; i++) {
+        const int reading = i == variant % lines ? 40 + variant : 23;
+        painter.drawText(width / 20, (i + 1) * lineHeight,
+                         QString("Line %1: Part number VX-%2 status OK, temperature %3.%4 C")
+                             .arg(i + 1)
+                             .arg(4100 + i * 7)
+                             .arg(reading)
+                             .arg(i % 10));
+    }
+    painter.end();
+
+    QImage gray = image.convertToFormat(QImage::Format_Grayscale8);
+    cv::Mat luma(gray.height(), gray.width(), CV_8UC1,
+                 const_cast<uchar *>(gray.constBits()), gray.bytesPerLine());
+    return luma.clone();
+}
+
+// News ticker band across the bottom of a strip of the given width, to
+// be viewed through a frame-sized window moving along it
+cv::Mat makeTickerStrip(int width, int height)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    image.fill(Qt::white);
+
+    QPainter painter(&image);
+    QFont font("DejaVu Sans");
+    font.setPixelSize(std::max(12, height / 24));
+    painter.setFont(font);
+    painter.setPen(Qt::black);
+
+    QString headlines;
+    for (int i = 0; headlines.size() * font.pixelSize() / 2 < width; i++) {
+        headlines += QString("Market update %1: index up %2.%3 percent +++ ")
+                         .arg(i + 1)
+                         .arg(i % 5)
+                         .arg(i * 3 % 10);
+    }
+    painter.drawText(0, height - font.pixelSize(), headlines);
+    painter.end();
+
+    QImage gray = image.convertToFormat(QImage::Format_Grayscale8);
+    cv::Mat luma(gray.height(), gray.width(), CV_8UC1,
+                 const_cast<uchar *>(gray.constBits()), gray.bytesPerLine());
+    return luma.clone();
+}
+
+// Subtitle band of a video: light text (empty for none) centered over a
+// dark background, with a pattern drifting by step pixels per frame.
+// frame selects the position of the pattern; the glyph edges are
+// antialiased, so they straddle any threshold
+cv::Mat makeSubtitleBand(int width, int height, const QString &text, int frame)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    image.fill(Qt::black);
+
+    QPainter painter(&image);
+    QFont font("DejaVu Sans");
+    font.setPixelSize(std::max(12, height / 5));
+    painter.setFont(font);
+    painter.setPen(Qt::white);
+    painter.drawText(image.rect(), Qt::AlignCenter, text);
+    painter.end();
+
+    QImage gray = image.convertToFormat(QImage::Format_Grayscale8);
+    cv::Mat coverage;
+    cv::Mat(gray.height(), gray.width(), CV_8UC1,
+            const_cast<uchar *>(gray.constBits()), gray.bytesPerLine())
+        .convertTo(coverage, CV_32F, 1.0 / 255);
+
+    // Background 30..90, text 230, blended by the glyph coverage
+    const int step = 3;
+    cv::Mat background(height, width, CV_32F);
+    for (int y = 0; y < height; y++) {
+        float *row = background.ptr<float>(y);
+        for (int x = 0; x < width; x++) {
+            row[x] = 60.f + 30.f * std::sin((x + y + frame * step) / 40.f);
+        }
+    }
+    cv::Mat band = background.mul(1.0 - coverage) + coverage * 230.0;
+
+    cv::Mat luma;
+    band.convertTo(luma, CV_8U);
+    return luma;
+}
+
+// ===================== Reference Implementations =====================
+
+// The original per-pixel loop from VideoProcessor::convertToMonochrome
+void colorizeReference(const cv::Mat &binary, cv::Mat &colorMono,
+                       const cv::Vec3b &fg, const cv::Vec3b &bg)
+{
+    colorMono.create(binary.size(), CV_8UC3);
+    for (int y = 0; y < binary.rows; y++) {
+        for (int x = 0; x < binary.cols; x++) {
+            if (binary.at<uchar>(y, x) > 128) {
+                colorMono.at<cv::Vec3b>(y, x) = fg;
+            } else {
+                colorMono.at<cv::Vec3b>(y, x) = bg;
+            }
+        }
+    }
+}
+
+// Sauvola/Niblack threshold of one pixel, summing its window pixel by
+// pixel. Sums are exact integers, scaled as in AdaptiveBinarizer, so the
+// result must match bit for bit
+uchar localThresholdReference(const cv::Mat &luma, int y, int x, int window,
+                              ThresholdMethod method, bool lightText)
+{
+    const int half = window / 2;
+    const int y0 = std::max(0, y - half);
+    const int y1 = std::min(luma.rows, y + half + 1);
+    const int x0 = std::max(0, x - half);
+    const int x1 = std::min(luma.cols, x + half + 1);
+
+    long long sum = 0;
+    long long sqsum = 0;
+    for (int yy = y0; yy < y1; yy++) {
+        for (int xx = x0; xx < x1; xx++) {
+            const int v = luma.at<uchar>(yy, xx);
+            sum += v;
+            sqsum += v * v;
+        }
+    }
+
+    const double inv = (1.0 / double(y1 - y0)) * (1.0 / double(x1 - x0));
+    const double mean = double(sum) * inv;
+    const double stddev = std::sqrt(std::max(double(sqsum) * inv - mean * mean, 0.0));
+
+    const bool sauvola = method == ThresholdMethod::Sauvola;
+    const double k = sauvola ? 0.2 : -0.2;
+    const double m = lightText ? 255.0 - mean : mean;
+    const double t = sauvola ? m * (1.0 + k * (stddev / 128.0 - 1.0)) : m + k * stddev;
+
+    const int v = luma.at<uchar>(y, x);
+    if (lightText) {
+        return (255 - v) <= t ? 255 : 0;
+    }
+    return v > t ? 255 : 0;
+}
+
+// The original performOCR chain: gray, threshold, colorize, gray again
+void ocrChainReference(const cv::Mat &bgr, cv::Mat &gray,
+                       const cv::Vec3b &fg, const cv::Vec3b &bg)
+{
+    cv::Mat luma, binary, colorMono;
+    cv::cvtColor(bgr, luma, cv::COLOR_BGR2GRAY);
+    cv::threshold(luma, binary, 128, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+    colorizeReference(binary, colorMono, fg, bg);
+    cv::cvtColor(colorMono, gray, cv::COLOR_BGR2GRAY);
+}
+
+// ===================== Stages =====================
+
+void benchIngest()
+{
+    // Computed luma goes into an arena, as on the processing thread
+    FrameArena arena;
+
+    for (const Resolution &res : kResolutions) {
+        for (const FormatCase &format : kFormats) {
+            QVideoFrame frame = makeVideoFrame(format.format, res.width, res.height);
+            if (!frame.isValid()) {
+                continue;
+            }
+
+            Result result = makeResult("ingest", format.name, res);
+            measure([&] {
+                FrameIngest ingest(frame, &arena);
+                // Touch the result so the work cannot be skipped
+                volatile uchar first = ingest.isValid() ? ingest.luma().at<uchar>(0, 0) : 0;
+                (void)first;
+            }, iterationsFor(res), result);
+
+            FrameIngest ingest(frame, &arena);
+            result.status = ingest.isZeroCopy() ? "zero-copy" : "copy";
+            report(result);
+        }
+    }
+}
+
+bool benchThreshold()
+{
+    bool allExact = true;
+
+    for (const Resolution &res : kResolutions) {
+        cv::Mat luma;
+        cv::cvtColor(makeTextFrame(res.width, res.height), luma, cv::COLOR_BGR2GRAY);
+
+        cv::Mat binary;
+        Result result = makeResult("threshold", "otsu", res);
+        int otsuLevel = 0;
+        measure([&] {
+            otsuLevel = int(cv::threshold(luma, binary, 128, 255, cv::THRESH_BINARY | cv::THRESH_OTSU));
+        }, iterationsFor(res), result);
+        report(result);
+
+        // Steady stream: after the first frame only the subsample is read
+        ThresholdEstimator estimator;
+        int level = 0;
+        Result temporal = makeResult("threshold", "otsu-temporal", res);
+        measure([&] {
+            level = estimator.estimate(luma);
+            cv::threshold(luma, binary, level, 255, cv::THRESH_BINARY);
+        }, iterationsFor(res), temporal);
+        temporal.status = "level " + std::to_string(level) + ", otsu " + std::to_string(otsuLevel);
+        report(temporal);
+
+        // Pixels checked against the brute-force window sums: all of them
+        // at 480p, the corners and a random sample above, where summing
+        // every window would take minutes
+        std::vector<cv::Point> checked;
+        if (res.height <= 480) {
+            for (int y = 0; y < res.height; y++) {
+                for (int x = 0; x < res.width; x++) {
+                    checked.emplace_back(x, y);
+                }
+            }
+        } else {
+            cv::RNG rng(res.height);
+            checked = {{0, 0}, {res.width - 1, 0}, {0, res.height - 1}, {res.width - 1, res.height - 1}};
+            for (int i = 0; i < 20000; i++) {
+                checked.emplace_back(rng.uniform(0, res.width), rng.uniform(0, res.height));
+            }
+        }
+
+        // Local thresholds over the same window, which is what makes
+        // cv::adaptiveThreshold slow at large sizes
+        for (ThresholdMethod method : {ThresholdMethod::Sauvola, ThresholdMethod::Niblack}) {
+            AdaptiveBinarizer binarizer(method);
+            const int window = binarizer.windowFor(res.height);
+
+            bool exact = true;
+            for (bool lightText : {false, true}) {
+                binarizer.apply(luma, binary, lightText);
+                for (const cv::Point &p : checked) {
+                    if (binary.at<uchar>(p) != localThresholdReference(luma, p.y, p.x, window,
+                                                                       method, lightText)) {
+                        exact = false;
+                        break;
+                    }
+                }
+            }
+            allExact = allExact && exact;
+
+            Result local = makeResult("threshold", thresholdMethodName(method), res);
+            measure([&] { binarizer.apply(luma, binary, false); }, iterationsFor(res), local);
+            local.status = "window " + std::to_string(window) + (exact ? ", exact" : ", MISMATCH");
+            report(local);
+        }
+
+        const int window = AdaptiveBinarizer().windowFor(res.height);
+        const struct {
+            const char *variant;
+            int type;
+        } cvMethods[] = {
+            {"cv-mean", cv::ADAPTIVE_THRESH_MEAN_C},
+            {"cv-gaussian", cv::ADAPTIVE_THRESH_GAUSSIAN_C},
+        };
+        for (const auto &cvMethod : cvMethods) {
+            Result reference = makeResult("threshold", cvMethod.variant, res);
+            measure([&] {
+                cv::adaptiveThreshold(luma, binary, 255, cvMethod.type, cv::THRESH_BINARY, window, 10);
+            }, iterationsFor(res), reference);
+            reference.status = "window " + std::to_string(window);
+            report(reference);
+        }
+    }
+
+    return allExact;
+}
+
+bool benchColorize()
+{
+    using MonochromeKernel::Isa;
+
+    const cv::Vec3b fg(0x0e, 0xc7, 0x11);  // Green on Black, BGR order
+    const cv::Vec3b bg(0x00, 0x00, 0x00);
+    const Isa isas[] = {Isa::Scalar, Isa::SSSE3, Isa::AVX2};
+
+    bool allExact = true;
+
+    for (const Resolution &res : kResolutions) {
+        cv::Mat binary = makeBinaryFrame(res.width, res.height);
+
+        cv::Mat expected;
+        colorizeReference(binary, expected, fg, bg);
+
+        Result reference = makeResult("colorize", "reference", res);
+        measure([&] { colorizeReference(binary, expected, fg, bg); }, iterationsFor(res), reference);
+        report(reference);
+
+        for (Isa isa : isas) {
+            Result result = makeResult("colorize", MonochromeKernel::isaName(isa), res);
+            if (!MonochromeKernel::isIsaAvailable(isa)) {
+                result.status = "unavailable";
+                report(result);
+                continue;
+            }
+
+            cv::Mat output;
+            MonochromeKernel::colorize(binary, output, fg, bg, isa);
+            bool exact = cv::norm(output, expected, cv::NORM_INF) == 0;
+            allExact = allExact && exact;
+
+            measure([&] { MonochromeKernel::colorize(binary, output, fg, bg, isa); },
+                    iterationsFor(res), result);
+            result.status = exact ? "exact" : "MISMATCH";
+            report(result);
+        }
+    }
+
+    return allExact;
+}
+
+// 4-channel variant, as rendered into display frames
+bool benchColorizeBgrx()
+{
+    using MonochromeKernel::Isa;
+
+    const cv::Vec3b fg(0x0e, 0xc7, 0x11);  // Green on Black, BGR order
+    const cv::Vec3b bg(0x00, 0x00, 0x00);
+    const Isa isas[] = {Isa::Scalar, Isa::SSSE3, Isa::AVX2};
+
+    bool allExact = true;
+
+    for (const Resolution &res : kResolutions) {
+        cv::Mat binary = makeBinaryFrame(res.width, res.height);
+
+        // Reference: the 3-channel result plus an opaque fourth channel
+        cv::Mat bgr, expected;
+        colorizeReference(binary, bgr, fg, bg);
+        cv::cvtColor(bgr, expected, cv::COLOR_BGR2BGRA);
+
+        for (Isa isa : isas) {
+            Result result = makeResult("colorize",
+                                       std::string(MonochromeKernel::isaName(isa)) + "-bgrx", res);
+            if (!MonochromeKernel::isIsaAvailable(isa)) {
+                result.status = "unavailable";
+                report(result);
+                continue;
+            }
+
+            cv::Mat output;
+            MonochromeKernel::colorizeBgrx(binary, output, fg, bg, isa);
+            bool exact = cv::norm(output, expected, cv::NORM_INF) == 0;
+            allExact = allExact && exact;
+
+            measure([&] { MonochromeKernel::colorizeBgrx(binary, output, fg, bg, isa); },
+                    iterationsFor(res), result);
+            result.status = exact ? "exact" : "MISMATCH";
+            report(result);
+        }
+    }
+
+    return allExact;
+}
+
+bool benchOcrPreprocess()
+{
+    const cv::Vec3b fg(0xff, 0xff, 0xff);  // White on Black
+    const cv::Vec3b bg(0x00, 0x00, 0x00);
+    const bool lightText = OcrPreprocess::isLightText(fg, bg);
+
+    bool allExact = true;
+
+    for (const Resolution &res : kResolutions) {
+        cv::Mat bgr = makeTextFrame(res.width, res.height);
+        cv::Mat luma;
+        cv::cvtColor(bgr, luma, cv::COLOR_BGR2GRAY);
+
+        cv::Mat chained, fused;
+        ocrChainReference(bgr, chained, fg, bg);
+        OcrPreprocess::binarize(luma, fused, lightText);
+
+        // Same pixels must be text, with text now dark on light
+        cv::Mat expected = chained;
+        if (lightText) {
+            expected = 255 - chained;
+        }
+        bool exact = cv::norm(fused, expected, cv::NORM_INF) == 0;
+        allExact = allExact && exact;
+
+        Result chain = makeResult("ocr-prep", "chain", res);
+        measure([&] { ocrChainReference(bgr, chained, fg, bg); }, iterationsFor(res), chain);
+        report(chain);
+
+        Result result = makeResult("ocr-prep", "fused", res);
+        measure([&] { OcrPreprocess::binarize(luma, fused, lightText); }, iterationsFor(res), result);
+        result.status = exact ? "exact" : "MISMATCH";
+        report(result);
+    }
+
+    return allExact;
+}
+
+bool benchProcessFrame()
+{
+    // One engine is enough, processFrame itself never waits for OCR.
+    // The display sink makes it render every frame; processing events
+    // delivers each one, as the GUI thread would
+    QVideoSink sink;
+    VideoProcessor processor(nullptr, 1);
+    processor.setDisplaySink(&sink);
+
+    bool allReused = true;
+    const QColor fg("#11c70e");
+    const QColor bg("#000000");
+
+    for (const Resolution &res : kResolutions) {
+        for (const FormatCase &format : kFormats) {
+            QVideoFrame frame = makeVideoFrame(format.format, res.width, res.height);
+            if (!frame.isValid()) {
+                continue;
+            }
+
+            auto process = [&] {
+                processor.processFrame(frame, fg, bg);
+                QCoreApplication::processEvents();
+            };
+
+            // After the first frame of a size, buffers must be reused
+            process();
+            quint64 buffersBefore = processor.frameCounters().bufferAllocations;
+
+            Result result = makeResult("process-frame", format.name, res);
+            measure(process, iterationsFor(res), result);
+
+            bool reused = processor.frameCounters().bufferAllocations == buffersBefore;
+            allReused = allReused && reused;
+            result.status = reused ? "buffers reused" : "REALLOCATED";
+            report(result);
+        }
+    }
+
+    return allReused;
+}
+
+void benchRegions()
+{
+    for (const Resolution &res : kResolutions) {
+        for (bool dense : {false, true}) {
+            cv::Mat luma = makeRenderedText(res.width, res.height, dense);
+            cv::Mat binary;
+            OcrPreprocess::binarize(luma, binary, false);
+
+            size_t found = 0;
+            Result result = makeResult("regions", dense ? "dense" : "sparse", res);
+            measure([&] { found = TextRegions::propose(binary).size(); },
+                    iterationsFor(res) / 4, result);
+            result.status = std::to_string(found) + " regions";
+            report(result);
+        }
+    }
+}
+
+void benchTracking()
+{
+    // Recognition is answered at once, so every changed region is sent
+    // again as soon as it changes
+    auto track = [](TextTracker &tracker, const cv::Mat &luma, const cv::Mat &binary) {
+        for (const TextTracker::Request &request : tracker.update(luma, binary)) {
+            tracker.setText(request.track, "text");
+        }
+    };
+
+    auto status = [](const TextTracker &tracker) {
+        TextTracker::Counters counters = tracker.counters();
+        char text[96];
+        std::snprintf(text, sizeof(text), "%d regions, %.2f re-read/frame",
+                      counters.tracks, double(counters.requests) / std::max<quint64>(1, counters.frames));
+        return std::string(text);
+    };
+
+    for (const Resolution &res : kResolutions) {
+        // Dashboard: about two lines differ from one frame to the next
+        {
+            std::vector<cv::Mat> lumas, binaries;
+            for (int variant = 0; variant < 8; variant++) {
+                lumas.push_back(makeDashboard(res.width, res.height, variant));
+                binaries.emplace_back();
+                OcrPreprocess::binarize(lumas.back(), binaries.back(), false);
+            }
+
+            TextTracker tracker;
+            tracker.setMaxPending(1000);
+            size_t i = 0;
+            Result result = makeResult("tracking", "dashboard", res);
+            measure([&] {
+                track(tracker, lumas[i % lumas.size()], binaries[i % lumas.size()]);
+                i++;
+            }, iterationsFor(res), result);
+            result.status = status(tracker);
+            report(result);
+        }
+
+        // Ticker: a window moving 4 pixels per frame along a long band
+        {
+            const int iterations = iterationsFor(res);
+            const int step = 4;
+            cv::Mat strip = makeTickerStrip(res.width + step * (iterations + 2), res.height);
+            cv::Mat stripBinary;
+            OcrPreprocess::binarize(strip, stripBinary, false);
+
+            TextTracker tracker;
+            tracker.setMaxPending(1000);
+            int offset = 0;
+            Result result = makeResult("tracking", "ticker", res);
+            measure([&] {
+                cv::Rect window(offset, 0, res.width, res.height);
+                track(tracker, strip(window), stripBinary(window));
+                offset += step;
+            }, iterations, result);
+            result.status = status(tracker);
+            report(result);
+        }
+    }
+}
+
+bool benchSubtitles()
+{
+    // A few subtitles with gaps between them, each shown for a while
+    // over drifting video with compression-like noise. Every subtitle
+    // (and every gap) must be read; the rest should be skipped
+    const QStringList texts = {
+        "Where were you last night?",
+        "At the station, waiting for the 9:15.",
+        "",
+        "It never came.",
+        "Never?",
+    };
+    const int framesPerText = 24;
+    const double sigma = 6.0;
+
+    bool allSeen = true;
+
+    for (const Resolution &res : kResolutions) {
+        const int width = res.width;
+        const int height = res.height / 4;
+        cv::RNG rng(2024);
+
+        int frames = 0;
+        int skipped = 0;        // Bands not read, block comparison
+        int skippedExact = 0;   // Bands not read, exact hash
+        int missed = 0;         // New subtitles taken for the old one
+        cv::Mat previous, binary, last;
+        quint64 previousHash = 0;
+
+        for (const QString &text : texts) {
+            for (int i = 0; i < framesPerText; i++) {
+                cv::Mat clean = makeSubtitleBand(width, height, text, frames);
+                cv::Mat noise(clean.size(), CV_16S);
+                rng.fill(noise, cv::RNG::NORMAL, 0, sigma);
+                cv::Mat luma;
+                cv::add(clean, noise, luma, cv::noArray(), CV_8U);
+                OcrPreprocess::binarize(luma, binary, true);
+                frames++;
+
+                const quint64 hash = OCRResultCache::computeKey(binary).exact;
+                if (frames > 1 && hash == previousHash) {
+                    skippedExact++;
+                }
+                previousHash = hash;
+
+                if (!SubtitleExtractor::bandChanged(previous, binary)) {
+                    skipped++;
+                    missed += i == 0 ? 1 : 0;
+                    continue;
+                }
+                previous = binary.clone();
+            }
+        }
+        last = binary;
+        allSeen = allSeen && missed == 0;
+
+        Result result = makeResult("subtitles", "compare", res);
+        result.mpixels = width * double(height) / 1e6;
+        measure([&] { SubtitleExtractor::bandChanged(previous, last); }, iterationsFor(res), result);
+
+        char status[96];
+        std::snprintf(status, sizeof(status), "skipped %d%% (exact hash %d%%), %d missed%s",
+                      100 * skipped / frames, 100 * skippedExact / frames, missed,
+                      missed == 0 ? "" : " MISMATCH");
+        result.status = status;
+        report(result);
+    }
+
+    return allSeen;
+}
+
+// Run a cue case, time it and check its cues against the expected ones
+template <typename Fn>
+bool checkCues(const char *variant, Fn &&run, const std::vector<SubtitleCue> &expected)
+{
+    std::vector<SubtitleCue> cues;
+    Result result;
+    result.stage = "cues";
+    result.variant = variant;
+    result.resolution = "-";
+    measure([&] { cues = run(); }, 1000, result);
+
+    bool exact = cues.size() == expected.size();
+    for (size_t i = 0; exact && i < cues.size(); i++) {
+        exact = cues[i].startMs == expected[i].startMs && cues[i].endMs == expected[i].endMs
+                && cues[i].text == expected[i].text;
+    }
+    if (!exact) {
+        for (const SubtitleCue &cue : cues) {
+            std::fprintf(stderr, "cues: %s got %.0f-%.0f \"%s\"\n", variant,
+                         cue.startMs, cue.endMs, qPrintable(cue.text));
+        }
+    }
+    result.status = exact ? "exact" : "MISMATCH";
+    report(result);
+    return exact;
+}
+
+bool benchCues()
+{
+    bool ok = true;
+
+    // Readings of one band as the pool returns them: repeats of a
+    // subtitle, a gap, noise lines around the text and failures
+    ok = checkCues("merge", [] {
+        const struct {
+            double startMs;
+            double endMs;
+            const char *text;
+        } readings[] = {
+            {0, 100, "Where were you?"},
+            {100, 200, " Where were you? \n\n"},    // Band changed, text not
+            {200, 300, OCREnginePool::kNoTextText}, // Gap between subtitles
+            {300, 400, "Where were you?"},          // Same text again
+            {400, 500, "At the station.\nAlone."},
+            {500, 600, "Error: OCR failed"},        // Failure ends the cue
+            {600, 700, "  \n"},                     // Blank lines only
+            {700, 800, "At the station.\nAlone."},
+            {800, 900, "At the station.\nAlone."},
+        };
+
+        CueMerger merger;
+        std::vector<SubtitleCue> cues;
+        for (const auto &reading : readings) {
+            for (const SubtitleCue &cue : merger.add(reading.startMs, reading.endMs, reading.text)) {
+                cues.push_back(cue);
+            }
+        }
+        for (const SubtitleCue &cue : merger.finish()) {
+            cues.push_back(cue);
+        }
+        return cues;
+    }, {
+        {0, 200, "Where were you?"},
+        {300, 400, "Where were you?"},
+        {400, 500, "At the station.\nAlone."},
+        {700, 900, "At the station.\nAlone."},
+    }) && ok;
+
+    // Cues of frame ranges as their extractors report them (chunk, cue),
+    // or a range finishing (chunk, no cue). Boundaries are at 1000 and
+    // 2000 ms; cues touching them are joined
+    struct Event {
+        int chunk;
+        bool finish;
+        SubtitleCue cue;
+    };
+    auto stitch = [](int chunks, const std::vector<Event> &events) {
+        CueStitcher stitcher(chunks, 0.5);
+        std::vector<SubtitleCue> cues;
+        for (const Event &event : events) {
+            for (const SubtitleCue &cue : event.finish ? stitcher.finish(event.chunk)
+                                                       : stitcher.add(event.chunk, event.cue)) {
+                cues.push_back(cue);
+            }
+        }
+        return cues;
+    };
+    auto cue = [](int chunk, double startMs, double endMs, const char *text) {
+        return Event{chunk, false, SubtitleCue{startMs, endMs, text}};
+    };
+    auto finish = [](int chunk) {
+        return Event{chunk, true, SubtitleCue{0, 0, QString()}};
+    };
+
+    // A subtitle showing across the boundary becomes one cue
+    ok = checkCues("stitch-join", [&] {
+        return stitch(2, {cue(0, 0, 600, "A"), cue(0, 600, 1000, "B"), cue(1, 1000, 1400, "B"),
+                          cue(1, 1400, 2000, "C"), finish(0), finish(1)});
+    }, {{0, 600, "A"}, {600, 1400, "B"}, {1400, 2000, "C"}}) && ok;
+
+    // Nothing shown around the boundary: the same text on both sides
+    // stays two cues
+    ok = checkCues("stitch-gap", [&] {
+        return stitch(2, {cue(0, 0, 900, "B"), cue(1, 1100, 1400, "B"), finish(1), finish(0)});
+    }, {{0, 900, "B"}, {1100, 1400, "B"}}) && ok;
+
+    // Later ranges finish first: their cues wait for the earlier ones
+    // and are still joined across both boundaries
+    ok = checkCues("stitch-order", [&] {
+        return stitch(3, {cue(2, 2000, 2200, "B"), cue(2, 2500, 3000, "C"), finish(2),
+                          cue(1, 1000, 1500, "A"), cue(1, 1500, 2000, "B"), finish(1),
+                          cue(0, 0, 1000, "A"), finish(0)});
+    }, {{0, 1500, "A"}, {1500, 2200, "B"}, {2500, 3000, "C"}}) && ok;
+
+    // A single range passes its cues through unchanged
+    ok = checkCues("stitch-single", [&] {
+        return stitch(1, {cue(0, 0, 100, "A"), cue(0, 100, 200, "B"), cue(0, 300, 400, "A"),
+                          finish(0)});
+    }, {{0, 100, "A"}, {100, 200, "B"}, {300, 400, "A"}}) && ok;
+
+    return ok;
+}
+
+bool benchOCRLog()
+{
+    QTemporaryDir folder;
+    if (!folder.isValid()) {
+        std::fprintf(stderr, "ocr-log: no temporary folder, skipping\n");
+        return true;
+    }
+
+    // Two weeks of a result every six seconds, spread over four cameras:
+    // three lines of common words, one of them with a part number
+    const int records = 200000;
+    const qint64 startMs = 1700000000000LL;
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> common(0, 999);
+    auto partNumber = [](int record) {
+        return QString("PN-%1-X").arg(record * 7919 % 1000003, 7, 10, QChar('0'));
+    };
+
+    bool ok = true;
+    {
+        OCRLog log(16 * 1024 * 1024);
+        log.open(folder.path());
+
+        OCRLog::Record record;
+        record.lines.resize(3);
+        for (OcrLine &line : record.lines) {
+            line.box = QRect(10, 10, 400, 32);
+            line.confidence = 90.f;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < records; i++) {
+            record.source = i % 4;
+            record.timestampMs = startMs + qint64(i) * 6000;
+            record.lines[0].text = QString("Station %1 status OK").arg(common(random));
+            record.lines[1].text = QString("Part %1 batch %2").arg(partNumber(i)).arg(common(random));
+            record.lines[2].text = QString("word%1 word%2 word%3")
+                                       .arg(common(random)).arg(common(random)).arg(common(random));
+            log.append(record);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        OCRLog::Stats stats = log.stats();
+        Result result;
+        result.stage = "ocr-log";
+        result.variant = "append";
+        result.resolution = "-";
+        result.nsPerFrame = std::chrono::duration<double, std::nano>(end - start).count() / records;
+        char status[96];
+        std::snprintf(status, sizeof(status), "%llu records, %.1f MiB in %d segments",
+                      (unsigned long long)stats.records, stats.bytes / (1024.0 * 1024.0),
+                      stats.segments);
+        result.status = status;
+        report(result);
+    }
+
+    // Searches in a freshly opened log, as after a restart
+    OCRLog log(16 * 1024 * 1024);
+    auto openStart = std::chrono::steady_clock::now();
+    log.open(folder.path());
+    auto openEnd = std::chrono::steady_clock::now();
+    reportLatency("ocr-log", "open", "-",
+                  {std::chrono::duration<double, std::milli>(openEnd - openStart).count()});
+
+    // One part number on the camera that showed it: exactly one hit
+    std::vector<double> rare;
+    std::uniform_int_distribution<int> anyRecord(0, records - 1);
+    for (int i = 0; i < 200; i++) {
+        const int wanted = anyRecord(random);
+        OCRLog::Query query;
+        query.text = partNumber(wanted).toLower();
+        query.source = wanted % 4;
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<OCRLog::Hit> hits = log.find(query);
+        auto end = std::chrono::steady_clock::now();
+        rare.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+
+        if (hits.size() != 1 || hits[0].timestampMs != startMs + qint64(wanted) * 6000) {
+            std::fprintf(stderr, "ocr-log: MISMATCH for %s\n", qPrintable(query.text));
+            ok = false;
+        }
+    }
+    reportLatency("ocr-log", "rare", "-", rare);
+
+    // A word in every result next to one in a few hundred
+    std::vector<double> frequent;
+    for (int i = 0; i < 20; i++) {
+        OCRLog::Query query;
+        query.text = QString("station %1").arg(common(random));
+
+        auto start = std::chrono::steady_clock::now();
+        log.find(query);
+        auto end = std::chrono::steady_clock::now();
+        frequent.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    reportLatency("ocr-log", "frequent", "-", frequent);
+
+    return ok;
+}
+
+void benchFusion()
+{
+    // Eight noisy frames of the same text, each moved by a few pixels as
+    // by a hand-held camera; the newest one is the reference
+    const int frames = 8;
+    const double sigma = 24.0;
+
+    for (const Resolution &res : kResolutions) {
+        cv::Mat clean = makeRenderedText(res.width, res.height, false);
+        cv::RNG rng(12345);
+
+        std::vector<cv::Mat> noisy;
+        for (int i = 0; i < frames; i++) {
+            const int dx = i == frames - 1 ? 0 : rng.uniform(-3, 4);
+            const int dy = i == frames - 1 ? 0 : rng.uniform(-3, 4);
+            cv::Mat translation = (cv::Mat_<double>(2, 3) << 1, 0, dx, 0, 1, dy);
+            cv::Mat shifted;
+            cv::warpAffine(clean, shifted, translation, clean.size(),
+                           cv::INTER_NEAREST, cv::BORDER_REPLICATE);
+
+            cv::Mat noise(clean.size(), CV_16S);
+            rng.fill(noise, cv::RNG::NORMAL, 0, sigma);
+            cv::Mat frame;
+            cv::add(shifted, noise, frame, cv::noArray(), CV_8U);
+            noisy.push_back(frame);
+        }
+
+        // RMS difference to the clean frame, away from the borders
+        auto residual = [&](const cv::Mat &image) {
+            cv::Rect inner(8, 8, clean.cols - 16, clean.rows - 16);
+            cv::Mat a, b;
+            image(inner).convertTo(a, CV_32F);
+            clean(inner).convertTo(b, CV_32F);
+            return cv::norm(a, b, cv::NORM_L2) / std::sqrt(double(inner.area()));
+        };
+
+        {
+            FrameFusion fusion(frames);
+            size_t i = 0;
+            Result result = makeResult("fusion", "push", res);
+            measure([&] { fusion.push(noisy[i++ % noisy.size()]); }, iterationsFor(res), result);
+            report(result);
+        }
+
+        for (FusionMethod method : {FusionMethod::Average, FusionMethod::Median}) {
+            FrameFusion fusion(frames, method);
+            for (const cv::Mat &frame : noisy) {
+                fusion.push(frame);
+            }
+
+            cv::Mat fused;
+            int used = 0;
+            Result result = makeResult("fusion", fusionMethodName(method), res);
+            measure([&] { used = fusion.fuse(fused); }, iterationsFor(res) / 4, result);
+
+            char status[64];
+            std::snprintf(status, sizeof(status), "%d frames, noise %.1f -> %.1f",
+                          used, residual(noisy.back()), residual(fused));
+            result.status = status;
+            report(result);
+        }
+    }
+}
+
+void benchPrescale()
+{
+    for (const Resolution &res : kResolutions) {
+        for (bool dense : {false, true}) {
+            cv::Mat luma = makeRenderedText(res.width, res.height, dense);
+            cv::Mat binary;
+            OcrPreprocess::binarize(luma, binary, false);
+
+            cv::Mat scaled;
+            double scale = 1.0;
+            Result result = makeResult("prescale", dense ? "dense" : "sparse", res);
+            measure([&] { scale = OcrPrescale::prescale(binary, scaled); },
+                    iterationsFor(res) / 4, result);
+
+            char status[64];
+            std::snprintf(status, sizeof(status), "glyph %d px, x%.2f",
+                          OcrPrescale::estimateGlyphHeight(binary), scale);
+            result.status = status;
+            report(result);
+        }
+    }
+}
+
+bool benchScene()
+{
+    // Two scenes that differ in one reading of one line, each seen for
+    // a while through sensor noise. The detector must fire once per
+    // scene: noise must not count as a change, the reading must
+    const int stableFrames = 10;
+    const int framesPerScene = stableFrames + 4;
+    const double sigma = 12.0;
+
+    bool allFired = true;
+
+    for (const Resolution &res : kResolutions) {
+        const cv::Mat scenes[] = {
+            makeDashboard(res.width, res.height, 0),
+            makeDashboard(res.width, res.height, dashboardLines(res.height)),
+        };
+
+        cv::RNG rng(4711);
+        std::vector<cv::Mat> frames;
+        for (const cv::Mat &scene : scenes) {
+            for (int i = 0; i < framesPerScene; i++) {
+                cv::Mat noise(scene.size(), CV_16S);
+                rng.fill(noise, cv::RNG::NORMAL, 0, sigma);
+                cv::Mat frame;
+                cv::add(scene, noise, frame, cv::noArray(), CV_8U);
+                frames.push_back(frame);
+            }
+        }
+
+        // The change metric at the new reading, and the largest one of
+        // noise alone
+        SceneChangeDetector detector(stableFrames);
+        int fired = 0;
+        double word = 0.0;
+        double noise = 0.0;
+        for (size_t i = 0; i < frames.size(); i++) {
+            fired += detector.update(frames[i]) ? 1 : 0;
+            if (i == size_t(framesPerScene)) {
+                word = detector.lastChange();
+            } else if (i != 0) {
+                noise = std::max(noise, detector.lastChange());
+            }
+        }
+        const bool ok = fired == 2;
+        allFired = allFired && ok;
+
+        size_t i = 0;
+        Result result = makeResult("scene", "update", res);
+        measure([&] { detector.update(frames[i++ % frames.size()]); }, iterationsFor(res), result);
+
+        char status[96];
+        std::snprintf(status, sizeof(status), "word %.3f, noise %.3f, fired %d/2%s",
+                      word, noise, fired, ok ? "" : " MISMATCH");
+        result.status = status;
+        report(result);
+    }
+
+    return allFired;
+}
+
+void benchOCR()
+{
+    OCRWorker worker;
+
+    const int samples = 10;
+
+    for (const Resolution &res : kResolutions) {
+        for (bool dense : {false, true}) {
+            cv::Mat luma = makeRenderedText(res.width, res.height, dense);
+            cv::Mat binary;
+            OcrPreprocess::binarize(luma, binary, false);
+
+            for (int mode = 0; mode < 3; mode++) {
+                // Whole frame, text regions, text regions at the target
+                // glyph height
+                const bool useRegions = mode > 0;
+                const bool prescale = mode > 1;
+                std::string variant = std::string(dense ? "dense" : "sparse")
+                                      + (useRegions ? "+roi" : "") + (prescale ? "+scale" : "");
+                worker.setPrescaleHeight(prescale ? OcrPrescale::kDefaultGlyphHeight : 0);
+                std::vector<double> latencies;
+                std::vector<double> firstLine;
+
+                for (int i = 0; i < samples; i++) {
+                    auto start = std::chrono::steady_clock::now();
+
+                    // Time until the first line would be on screen
+                    bool seen = false;
+                    worker.setLineCallback([&](const OcrLine &) {
+                        if (!seen) {
+                            seen = true;
+                            firstLine.push_back(std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - start).count());
+                        }
+                    });
+
+                    QString text = worker.processOCR(binary, useRegions);
+                    auto end = std::chrono::steady_clock::now();
+
+                    if (text.startsWith("Error:")) {
+                        std::fprintf(stderr, "ocr: %s, skipping\n", qPrintable(text));
+                        return;
+                    }
+                    latencies.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+                }
+
+                reportLatency("ocr", variant, res.name, latencies);
+                if (!firstLine.empty()) {
+                    reportLatency("ocr-first-line", variant, res.name, firstLine);
+                }
+            }
+        }
+    }
+    worker.setLineCallback(nullptr);
+}
+
+void benchOCRSources()
+{
+    // A busy camera keeps the engines saturated while a quiet one asks
+    // for OCR now and then. The quiet camera's latency shows whether the
+    // scheduler keeps it from waiting behind the busy camera's backlog
+    const Resolution &res = kResolutions[1];
+    cv::Mat luma = makeRenderedText(res.width, res.height, false);
+    cv::Mat binary;
+    OcrPreprocess::binarize(luma, binary, false);
+
+    struct Variant {
+        const char *name;
+        int quietPriority;   // Priority of the quiet camera
+        int busyMaxRunning;  // Engine limit of the busy camera, 0 = none
+    };
+    const Variant variants[] = {
+        {"equal", 1, 0},
+        {"quiet-x4", 4, 0},
+        {"busy-quota", 1, 1},
+    };
+
+    const int engines = 2;
+    const int busyJobs = 24;
+    const int quietJobs = 6;
+    enum { Busy, Quiet };
+
+    for (const Variant &variant : variants) {
+        OCREnginePool pool(engines);
+        pool.resultCache()->setLimits(0, 0);  // Every job runs on an engine
+
+        OCREnginePool::SourcePolicy busy;
+        busy.maxRunning = variant.busyMaxRunning;
+        pool.setSourcePolicy(Busy, busy);
+
+        OCREnginePool::SourcePolicy quiet;
+        quiet.priority = variant.quietPriority;
+        pool.setSourcePolicy(Quiet, quiet);
+
+        std::map<quint64, std::chrono::steady_clock::time_point> submitted;
+        std::vector<double> latencies[2];
+        int pending = 0;
+        bool failed = false;
+
+        QObject::connect(&pool, &OCREnginePool::ocrComplete,
+                         [&](int source, quint64 jobId, const QString &text) {
+            failed = failed || text.startsWith("Error:");
+            latencies[source].push_back(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - submitted[jobId]).count());
+            pending--;
+        });
+
+        auto submit = [&](int source) {
+            // Results come back through this thread's event loop, so the
+            // time is in place before the result can arrive
+            quint64 id = pool.submit(binary, false, source);
+            submitted[id] = std::chrono::steady_clock::now();
+            pending++;
+        };
+
+        // The busy camera's backlog first, then one quiet request at a
+        // time while the backlog is worked off
+        for (int i = 0; i < busyJobs; i++) {
+            submit(Busy);
+        }
+        for (int i = 0; i < quietJobs && !failed; i++) {
+            submit(Quiet);
+            while (latencies[Quiet].size() < size_t(i + 1) && !failed) {
+                QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+            }
+        }
+        while (pending > 0) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+
+        if (failed) {
+            std::fprintf(stderr, "ocr-sources: OCR failed, skipping\n");
+            return;
+        }
+
+        reportLatency("ocr-sources", std::string(variant.name) + "/quiet", res.name, latencies[Quiet]);
+        reportLatency("ocr-sources", std::string(variant.name) + "/busy", res.name, latencies[Busy]);
+    }
+}
+
+void benchEngineInit()
+{
+    // Several engines alive at once, as in the pool
+    const int engines = 4;
+
+    for (bool shared : {false, true}) {
+        std::vector<tesseract::TessBaseAPI *> apis;
+        // Private memory: the shared variant's mapped file is not per engine
+        const qint64 rssBefore = OcrModel::privateBytes();
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < engines; i++) {
+            tesseract::TessBaseAPI *api = new tesseract::TessBaseAPI();
+            bool ok = shared ? OcrModel::shared().initEngine(api) : api->Init(nullptr, "eng") == 0;
+            if (!ok) {
+                std::fprintf(stderr, "engine-init: Tesseract could not be initialized, skipping\n");
+                delete api;
+                break;
+            }
+            apis.push_back(api);
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        const qint64 rssAfter = OcrModel::privateBytes();
+
+        if (!apis.empty()) {
+            Result result;
+            result.stage = "engine-init";
+            result.variant = shared ? "shared" : "file";
+            result.resolution = "-";
+            result.nsPerFrame = std::chrono::duration<double, std::nano>(end - start).count() / apis.size();
+
+            char status[64];
+            if (rssBefore >= 0 && rssAfter >= 0) {
+                std::snprintf(status, sizeof(status), "%.1f MiB private/engine",
+                              (rssAfter - rssBefore) / (1024.0 * 1024.0) / apis.size());
+            } else {
+                std::snprintf(status, sizeof(status), "memory unknown");
+            }
+            result.status = status;
+            report(result);
+        }
+
+        for (tesseract::TessBaseAPI *api : apis) {
+            api->End();
+            delete api;
+        }
+    }
+}
+
+bool parseOptions(const QStringList &arguments)
+{
+    for (int i = 1; i < arguments.size(); i++) {
+        const QString &arg = arguments[i];
+        if (arg == "--json") {
+            options.json = true;
+        } else if (arg == "--no-ocr") {
+            options.runOCR = false;
+        } else if (arg == "--filter" && i + 1 < arguments.size()) {
+            options.filter = arguments[++i].toStdString();
+        } else {
+            std::fprintf(stderr, "Usage: videoocr_bench [--json] [--filter <stage>] [--no-ocr]\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // Text rendering needs a GUI application, but no display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+    if (!parseOptions(app.arguments())) {
+        return 2;
+    }
+
+#ifndef BENCH_COUNT_ALLOCATIONS
+    std::fprintf(stderr, "Allocation counting is not supported on this platform (-1)\n");
+#endif
+
+    bool ok = true;
+
+    if (stageEnabled("ingest")) {
+        benchIngest();
+    }
+    if (stageEnabled("threshold")) {
+        ok = benchThreshold() && ok;
+    }
+    if (stageEnabled("colorize")) {
+        ok = benchColorize() && ok;
+        ok = benchColorizeBgrx() && ok;
+    }
+    if (stageEnabled("ocr-prep")) {
+        ok = benchOcrPreprocess() && ok;
+    }
+    if (stageEnabled("prescale")) {
+        benchPrescale();
+    }
+    if (stageEnabled("fusion")) {
+        benchFusion();
+    }
+    if (stageEnabled("scene")) {
+        ok = benchScene() && ok;
+    }
+    if (stageEnabled("process-frame")) {
+        ok = benchProcessFrame() && ok;
+    }
+    if (stageEnabled("regions")) {
+        benchRegions();
+    }
+    if (stageEnabled("tracking")) {
+        benchTracking();
+    }
+    if (stageEnabled("subtitles")) {
+        ok = benchSubtitles() && ok;
+    }
+    if (stageEnabled("cues")) {
+        ok = benchCues() && ok;
+    }
+    if (stageEnabled("ocr-log")) {
+        ok = benchOCRLog() && ok;
+    }
+    if (options.runOCR && stageEnabled("ocr")) {
+        benchOCR();
+    }
+    if (options.runOCR && stageEnabled("ocr-sources")) {
+        benchOCRSources();
+    }
+    if (options.runOCR && stageEnabled("engine-init")) {
+        benchEngineInit();
+    }
+
+    return ok ? 0 : 1;
+}
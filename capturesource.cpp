@@ -0,0 +1,131 @@
+/*
+ * capturesource.cpp - Camera Capture Source Implementation
+ *
+ * Purpose: Implements the per-camera capture chain, from the camera to
+ * its processor and video widget
+ */
+
+#include "capturesource.h"
+#include "videoprocessor.h"
+#include "ocrenginepool.h"
+
+CaptureSource::CaptureSource(const QCameraDevice &device, OCREnginePool *pool,
+                             int sourceId, QObject *parent)
+    : QObject(parent)
+    , sourceId(sourceId)
+    , cameraDevice(device)
+    , camera(nullptr)
+    , captureSession(nullptr)
+    , videoSink(nullptr)
+    , videoProcessor(nullptr)
+    , videoWidget(nullptr)
+    , processedView(true)
+    , active(false)
+    , foreground(Qt::white)
+    , background(Qt::black)
+{
+    // Create camera object; the default camera for a null device
+    camera = device.isNull() ? new QCamera(this) : new QCamera(device, this);
+
+    // Create video sink to receive video frames
+    videoSink = new QVideoSink(this);
+    connect(videoSink, &QVideoSink::videoFrameChanged,
+            this, &CaptureSource::onVideoFrameChanged);
+
+    // The session has a single video output: all frames go to our sink,
+    // and the video widget is fed from onVideoFrameChanged (raw) or by
+    // the video processor (processed view)
+    captureSession = new QMediaCaptureSession(this);
+    captureSession->setCamera(camera);
+    captureSession->setVideoSink(videoSink);
+
+    connect(camera, &QCamera::errorOccurred, this, [this](QCamera::Error error, const QString &errorString) {
+        Q_UNUSED(error);
+        emit cameraError(errorString);
+    });
+
+    // Own frame thread and preprocessing, OCR engines shared
+    videoProcessor = new VideoProcessor(pool, sourceId, this);
+}
+
+CaptureSource::~CaptureSource()
+{
+    camera->stop();
+
+    // Stop frame processing while the video widget's sink still exists
+    delete videoProcessor;
+    videoProcessor = nullptr;
+}
+
+QString CaptureSource::name() const
+{
+    if (!cameraDevice.isNull()) {
+        return cameraDevice.description();
+    }
+    return QString("Camera %1").arg(sourceId + 1);
+}
+
+void CaptureSource::start()
+{
+    // What the camera showed before it stopped must not be captured or
+    // fused with what it shows now. Clearing again here also drops the
+    // frames that were still being processed when stop() cleared
+    lastFrame = QVideoFrame();
+    videoProcessor->clearCaptureFusion();
+
+    camera->start();
+    active = true;
+}
+
+void CaptureSource::stop()
+{
+    camera->stop();
+    active = false;
+
+    videoProcessor->clearCaptureFusion();
+}
+
+void CaptureSource::setVideoWidget(QVideoWidget *widget)
+{
+    videoWidget = widget;
+    setProcessedView(processedView);
+}
+
+void CaptureSource::setProcessedView(bool enabled)
+{
+    processedView = enabled;
+    videoProcessor->setDisplaySink(enabled && videoWidget ? videoWidget->videoSink() : nullptr);
+}
+
+void CaptureSource::setColorScheme(const QColor &fgColor, const QColor &bgColor)
+{
+    foreground = fgColor;
+    background = bgColor;
+    videoProcessor->setColorScheme(fgColor, bgColor);
+}
+
+quint64 CaptureSource::captureOCR()
+{
+    if (!lastFrame.isValid()) {
+        return VideoProcessor::kNoJob;
+    }
+
+    // Create a copy of the frame for OCR processing
+    QVideoFrame frameCopy = lastFrame;
+    return videoProcessor->performOCR(frameCopy, foreground, background);
+}
+
+void CaptureSource::onVideoFrameChanged(const QVideoFrame &frame)
+{
+    // Store the current frame for OCR capture
+    lastFrame = frame;
+
+    // Raw view: show the camera frame as is
+    if (!processedView && videoWidget) {
+        videoWidget->videoSink()->setVideoFrame(frame);
+    }
+
+    // Hand the frame to the processing thread. This never blocks: if the
+    // previous frame is still waiting it is replaced by this one
+    videoProcessor->submitFrame(frame, foreground, background);
+}
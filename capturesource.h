@@ -0,0 +1,106 @@
+/*
+ * capturesource.h - Camera Capture Source Header
+ *
+ * Purpose: Everything one camera needs, bundled so that a station can run
+ * several at once:
+ * - The camera, its capture session and the sink receiving its frames
+ * - A VideoProcessor with its own frame thread and preprocessing, whose
+ *   OCR goes to a pool shared with the other cameras (one source each)
+ * - The video widget showing the camera, raw or processed
+ */
+
+#ifndef CAPTURESOURCE_H
+#define CAPTURESOURCE_H
+
+#include <QObject>
+#include <QCamera>
+#include <QCameraDevice>
+#include <QMediaCaptureSession>
+#include <QVideoSink>
+#include <QVideoWidget>
+#include <QVideoFrame>
+#include <QColor>
+#include <QString>
+
+class OCREnginePool;
+class VideoProcessor;
+
+class CaptureSource : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Capture from device (a null device means the default camera) into
+    // a new processor submitting OCR to pool as sourceId. The pool must
+    // outlive the source
+    CaptureSource(const QCameraDevice &device, OCREnginePool *pool, int sourceId,
+                  QObject *parent = nullptr);
+    ~CaptureSource();
+
+    // Source ID of this camera's OCR jobs in the shared pool
+    int id() const { return sourceId; }
+
+    // Camera name for the user
+    QString name() const;
+
+    // Identity of the camera that stays the same across runs, whatever
+    // the order the cameras are found in; empty for the default camera
+    QByteArray deviceId() const { return cameraDevice.id(); }
+
+    // Frame processing and OCR of this camera
+    VideoProcessor *processor() const { return videoProcessor; }
+
+    // Start or stop capturing
+    void start();
+    void stop();
+    bool isActive() const { return active; }
+
+    // Show the camera on this widget (nullptr for none). The widget must
+    // outlive the source
+    void setVideoWidget(QVideoWidget *widget);
+
+    // Show the monochrome image instead of the raw camera
+    void setProcessedView(bool enabled);
+
+    // Colors frames are processed with
+    void setColorScheme(const QColor &fgColor, const QColor &bgColor);
+
+    // Latest frame of the camera, invalid before the first one
+    QVideoFrame currentFrame() const { return lastFrame; }
+
+    // Interactive OCR of the latest frame (see VideoProcessor::performOCR).
+    // Returns the job ID, or VideoProcessor::kNoJob without a frame
+    quint64 captureOCR();
+
+signals:
+    // Signal: The camera reported an error
+    void cameraError(const QString &message);
+
+private slots:
+    // Slot: Called when the camera delivers a new frame
+    void onVideoFrameChanged(const QVideoFrame &frame);
+
+private:
+    int sourceId;                          // Source ID in the shared pool
+    QCameraDevice cameraDevice;            // Device captured from
+
+    // Camera Components
+    QCamera *camera;                       // Camera object for video capture
+    QMediaCaptureSession *captureSession;  // Session managing camera
+    QVideoSink *videoSink;                 // Sink to receive video frames
+
+    // Processing Components
+    VideoProcessor *videoProcessor;        // Frame processing, OCR submission
+
+    // Display
+    QVideoWidget *videoWidget;             // Where the camera is shown
+    bool processedView;                    // Processed (true) or raw frames
+
+    // State Variables
+    bool active;                           // Camera started
+    QVideoFrame lastFrame;                 // Latest video frame, for OCR
+    QColor foreground;                     // Current color scheme
+    QColor background;
+};
+
+#endif // CAPTURESOURCE_H
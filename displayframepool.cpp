@@ -0,0 +1,35 @@
+/*
+ * displayframepool.cpp - Display Frame Pool Implementation
+ *
+ * Purpose: Implements the reusable ring of display frames
+ */
+
+#include "displayframepool.h"
+#include <QVideoFrameFormat>
+#include <algorithm>
+
+DisplayFramePool::DisplayFramePool(int frameCount)
+    : frames(std::max(2, frameCount))
+    , next(0)
+    , allocationCount(0)
+{
+}
+
+QVideoFrame &DisplayFramePool::nextFrame(const QSize &size)
+{
+    if (size != frameSize) {
+        // Frames still on screen keep their own reference to the old
+        // buffers, replacing ours does not pull memory from under them
+        const QVideoFrameFormat format(size, QVideoFrameFormat::Format_BGRX8888);
+        for (QVideoFrame &frame : frames) {
+            frame = QVideoFrame(format);
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        frameSize = size;
+        next = 0;
+    }
+
+    QVideoFrame &frame = frames[next];
+    next = (next + 1) % frames.size();
+    return frame;
+}
@@ -0,0 +1,44 @@
+/*
+ * displayframepool.h - Display Frame Pool Header
+ *
+ * Purpose: A small ring of BGRX QVideoFrames that the processing thread
+ * renders the monochrome image into for display. The frames are
+ * allocated once per frame size and then reused, so showing the
+ * processed stream costs no image allocations per frame.
+ */
+
+#ifndef DISPLAYFRAMEPOOL_H
+#define DISPLAYFRAMEPOOL_H
+
+#include <QVideoFrame>
+#include <QSize>
+#include <atomic>
+#include <vector>
+
+class DisplayFramePool
+{
+public:
+    // frameCount: frames in the ring. Three covers one frame on screen,
+    // one on its way to the display and one being rendered
+    explicit DisplayFramePool(int frameCount = 3);
+
+    DisplayFramePool(const DisplayFramePool &) = delete;
+    DisplayFramePool &operator=(const DisplayFramePool &) = delete;
+
+    // Get the next frame of the ring, in Format_BGRX8888 and the given
+    // size. All frames are reallocated only when the size changes.
+    // The caller must not have more than frameCount - 1 frames in use.
+    QVideoFrame &nextFrame(const QSize &size);
+
+    // Number of frames allocated so far (grows only on size changes).
+    // Readable from any thread
+    quint64 allocations() const { return allocationCount.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<QVideoFrame> frames;  // The ring
+    QSize frameSize;                  // Size of the frames in the ring
+    size_t next;                      // Index of the frame handed out next
+    std::atomic<quint64> allocationCount;  // Frames allocated so far
+};
+
+#endif // DISPLAYFRAMEPOOL_H
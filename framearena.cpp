@@ -0,0 +1,41 @@
+/*
+ * framearena.cpp - Frame Buffer Arena Implementation
+ *
+ * Purpose: Implements the per-slot buffer reuse and its counters
+ */
+
+#include "framearena.h"
+
+FrameArena::FrameArena()
+    : allocationCount(0)
+    , heldBytes(0)
+{
+}
+
+cv::Mat &FrameArena::acquire(Slot slot, cv::Size size, int type)
+{
+    cv::Mat &buffer = buffers[slot];
+
+    // Reallocate only if the shape changed, or if a Mat handed out
+    // earlier still shares the buffer (writing would change its pixels)
+    const bool shared = buffer.u && buffer.u->refcount > 1;
+    if (buffer.size() != size || buffer.type() != type || shared) {
+        heldBytes.fetch_sub(qint64(buffer.total() * buffer.elemSize()), std::memory_order_relaxed);
+
+        buffer = cv::Mat();
+        buffer.create(size, type);
+
+        heldBytes.fetch_add(qint64(buffer.total() * buffer.elemSize()), std::memory_order_relaxed);
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return buffer;
+}
+
+void FrameArena::release()
+{
+    for (cv::Mat &buffer : buffers) {
+        buffer.release();
+    }
+    heldBytes.store(0, std::memory_order_relaxed);
+}
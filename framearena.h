@@ -0,0 +1,57 @@
+/*
+ * framearena.h - Frame Buffer Arena Header
+ *
+ * Purpose: Owns the intermediate images of the per-frame pipeline (luma,
+ * gray, binary, ...) so they are reused from frame to frame. Each slot
+ * keeps one buffer that is only reallocated when the requested size or
+ * type changes, i.e. when the camera resolution changes. A counter of
+ * reallocations shows that the steady state allocates nothing.
+ */
+
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <QtGlobal>
+#include <opencv2/core.hpp>
+#include <atomic>
+
+// Not thread-safe: one arena per thread that processes frames.
+// The counters may be read from any thread.
+class FrameArena
+{
+public:
+    // Intermediate images of the frame pipeline, one buffer each
+    enum Slot {
+        IngestLuma,  // Luma extracted from packed or RGB frames
+        Gray,        // Luma of color input to convertToMonochrome
+        Binary,      // Thresholded frame
+        OcrBinary,   // Tesseract binary of a tracked frame
+        SlotCount
+    };
+
+    FrameArena();
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    // Get the buffer of a slot with the given size and type. The contents
+    // are whatever the previous frame left there. The returned reference
+    // stays valid until the next acquire() of the same slot.
+    cv::Mat &acquire(Slot slot, cv::Size size, int type);
+
+    // Buffer (re)allocations so far; constant in the steady state
+    quint64 allocations() const { return allocationCount.load(std::memory_order_relaxed); }
+
+    // Bytes currently held by all slots
+    qint64 bytes() const { return heldBytes.load(std::memory_order_relaxed); }
+
+    // Free all buffers (e.g. when the camera stops)
+    void release();
+
+private:
+    cv::Mat buffers[SlotCount];
+    std::atomic<quint64> allocationCount;
+    std::atomic<qint64> heldBytes;
+};
+
+#endif // FRAMEARENA_H
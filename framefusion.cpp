@@ -0,0 +1,208 @@
+/*
+ * framefusion.cpp - Multi-Frame Fusion Implementation
+ *
+ * Purpose: Implements the frame ring buffer, the phase correlation
+ * alignment and the parallel per-pixel average and median
+ */
+
+#include "framefusion.h"
+#include <opencv2/imgproc.hpp>
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+// Frames fused at most; also keeps the 16 bit per-pixel sums exact
+constexpr int kMaxFrames = 16;
+
+// Thumbnail width for alignment. Phase correlation is sub-pixel, so a
+// shift estimated on the thumbnail is still good to a pixel or two at
+// full resolution
+constexpr int kThumbWidth = 320;
+
+// Phase correlation peak below which a frame is taken not to show the
+// same scene as the newest one
+constexpr double kMinResponse = 0.08;
+
+// Largest shift accepted, as a fraction of the thumbnail width
+constexpr double kMaxShift = 0.125;
+
+} // namespace
+
+const char *fusionMethodName(FusionMethod method)
+{
+    switch (method) {
+    case FusionMethod::Average:
+        return "average";
+    case FusionMethod::Median:
+        return "median";
+    }
+    return "unknown";
+}
+
+FrameFusion::FrameFusion(int frames, FusionMethod method)
+    : frameCapacity(0)
+    , fusionMethod(method)
+    , next(0)
+    , count(0)
+    , thumbScale(1.0)
+    , lastUsed(0)
+{
+    configure(frames, method);
+}
+
+void FrameFusion::configure(int frames, FusionMethod method)
+{
+    QMutexLocker locker(&mutex);
+
+    frames = frames > 1 ? std::min(frames, kMaxFrames) : 0;
+    fusionMethod = method;
+    ring.resize(frames);
+    alignedScratch.resize(frames);
+    next = 0;
+    count = 0;
+    frameCapacity.store(frames, std::memory_order_relaxed);
+}
+
+void FrameFusion::clear()
+{
+    QMutexLocker locker(&mutex);
+    next = 0;
+    count = 0;
+}
+
+void FrameFusion::push(const cv::Mat &luma)
+{
+    if (capacity() == 0 || luma.empty() || luma.type() != CV_8UC1) {
+        return;
+    }
+
+    // A capture is being fused: this one frame is not missed
+    if (!mutex.tryLock()) {
+        return;
+    }
+
+    const int size = int(ring.size());
+    if (size > 0) {
+        // A new resolution starts the buffer over
+        if (count > 0 && ring[(next + size - 1) % size].luma.size() != luma.size()) {
+            count = 0;
+            next = 0;
+        }
+
+        // Buffers are reused once the ring has been filled
+        Slot &slot = ring[next];
+        luma.copyTo(slot.luma);
+
+        thumbScale = std::min(1.0, double(kThumbWidth) / luma.cols);
+        cv::resize(luma, thumbGray, cv::Size(), thumbScale, thumbScale, cv::INTER_AREA);
+        thumbGray.convertTo(slot.thumb, CV_32F);
+
+        next = (next + 1) % size;
+        count = std::min(count + 1, size);
+    }
+
+    mutex.unlock();
+}
+
+int FrameFusion::fuse(cv::Mat &fused)
+{
+    QMutexLocker locker(&mutex);
+
+    if (count == 0) {
+        lastUsed.store(0, std::memory_order_relaxed);
+        return 0;
+    }
+
+    const int size = int(ring.size());
+    const Slot &newest = ring[(next + size - 1) % size];
+    std::vector<cv::Mat> frames{newest.luma};
+
+    if (count > 1 && window.size() != newest.thumb.size()) {
+        cv::createHanningWindow(window, newest.thumb.size(), CV_32F);
+    }
+
+    const double maxShift = kMaxShift * newest.thumb.cols;
+    for (int i = 1; i < count; i++) {
+        Slot &slot = ring[(next + size - 1 - i) % size];
+
+        // The older frame is the newest one moved by shift
+        double response = 0.0;
+        cv::Point2d shift = cv::phaseCorrelate(newest.thumb, slot.thumb, window, &response);
+        if (response < kMinResponse || std::abs(shift.x) > maxShift || std::abs(shift.y) > maxShift) {
+            continue;
+        }
+
+        // Move it back, in whole pixels of the full frame
+        const int dx = cvRound(shift.x / thumbScale);
+        const int dy = cvRound(shift.y / thumbScale);
+        if (dx == 0 && dy == 0) {
+            frames.push_back(slot.luma);
+            continue;
+        }
+
+        cv::Mat translation = (cv::Mat_<double>(2, 3) << 1, 0, -dx, 0, 1, -dy);
+        cv::warpAffine(slot.luma, alignedScratch[i], translation, slot.luma.size(),
+                       cv::INTER_NEAREST, cv::BORDER_REPLICATE);
+        frames.push_back(alignedScratch[i]);
+    }
+
+    if (frames.size() == 1) {
+        newest.luma.copyTo(fused);
+    } else {
+        combine(frames, fused);
+    }
+
+    lastUsed.store(int(frames.size()), std::memory_order_relaxed);
+    return int(frames.size());
+}
+
+void FrameFusion::combine(const std::vector<cv::Mat> &frames, cv::Mat &fused) const
+{
+    const int n = int(frames.size());
+    const int width = frames[0].cols;
+    fused.create(frames[0].size(), CV_8UC1);
+
+    if (fusionMethod == FusionMethod::Average) {
+        // Rounded mean; n * 255 fits in 16 bits for n <= kMaxFrames
+        cv::parallel_for_(cv::Range(0, fused.rows), [&](const cv::Range &rows) {
+            std::vector<uint16_t> sum(width);
+            for (int y = rows.start; y < rows.end; y++) {
+                std::fill(sum.begin(), sum.end(), uint16_t(n / 2));
+                for (const cv::Mat &frame : frames) {
+                    const uchar *src = frame.ptr<uchar>(y);
+                    for (int x = 0; x < width; x++) {
+                        sum[x] += src[x];
+                    }
+                }
+
+                uchar *dst = fused.ptr<uchar>(y);
+                for (int x = 0; x < width; x++) {
+                    dst[x] = uchar(sum[x] / n);
+                }
+            }
+        });
+    } else {
+        // Per-pixel median (the upper one for an even count)
+        cv::parallel_for_(cv::Range(0, fused.rows), [&](const cv::Range &rows) {
+            std::vector<const uchar *> src(n);
+            uchar values[kMaxFrames];
+            for (int y = rows.start; y < rows.end; y++) {
+                for (int i = 0; i < n; i++) {
+                    src[i] = frames[i].ptr<uchar>(y);
+                }
+
+                uchar *dst = fused.ptr<uchar>(y);
+                for (int x = 0; x < width; x++) {
+                    for (int i = 0; i < n; i++) {
+                        values[i] = src[i][x];
+                    }
+                    std::nth_element(values, values + n / 2, values + n);
+                    dst[x] = values[n / 2];
+                }
+            }
+        });
+    }
+}
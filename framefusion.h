@@ -0,0 +1,89 @@
+/*
+ * framefusion.h - Multi-Frame Fusion Header
+ *
+ * Purpose: Denoises a capture by combining the last few camera frames
+ * instead of reading a single noisy one:
+ * - A ring buffer keeps the luma of the last N frames, with a small
+ *   thumbnail of each
+ * - On capture, every frame is aligned to the newest one by a global
+ *   shift estimated with phase correlation on the thumbnails
+ * - The aligned frames are averaged or median-filtered per pixel
+ *
+ * Averaging N frames divides sensor noise by about sqrt(N), which matters
+ * most in low light where a single frame thresholds into speckle. Frames
+ * that do not match the newest one (the camera moved too far, the scene
+ * changed) are left out rather than smeared in.
+ */
+
+#ifndef FRAMEFUSION_H
+#define FRAMEFUSION_H
+
+#include <QMutex>
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <vector>
+
+// How aligned frames are combined per pixel
+enum class FusionMethod {
+    Average,  // Mean: best against sensor noise
+    Median    // Median: also drops outliers (a hand moving through)
+};
+
+// Short lowercase name of a method ("average", "median")
+const char *fusionMethodName(FusionMethod method);
+
+// push is meant for the frame thread and fuse for any other thread; the
+// two never wait for each other long (see push)
+class FrameFusion
+{
+public:
+    // frames: ring buffer capacity, 0 or 1 disables fusion
+    explicit FrameFusion(int frames = 0, FusionMethod method = FusionMethod::Average);
+
+    FrameFusion(const FrameFusion &) = delete;
+    FrameFusion &operator=(const FrameFusion &) = delete;
+
+    // Change the capacity and method; drops the buffered frames
+    void configure(int frames, FusionMethod method);
+
+    // Frames fused at most, 0 if disabled. Lock-free
+    int capacity() const { return frameCapacity.load(std::memory_order_relaxed); }
+
+    // Remember a CV_8UC1 luma frame (copied into reused buffers). Never
+    // blocks: the frame is skipped while a fuse is running
+    void push(const cv::Mat &luma);
+
+    // Fuse the buffered frames into a CV_8UC1 image aligned with the
+    // newest one. Returns the number of frames used, 0 if none is buffered
+    int fuse(cv::Mat &fused);
+
+    // Forget the buffered frames
+    void clear();
+
+    // Frames used by the last fuse. Lock-free
+    int lastFused() const { return lastUsed.load(std::memory_order_relaxed); }
+
+private:
+    // One buffered frame
+    struct Slot {
+        cv::Mat luma;   // Full resolution copy
+        cv::Mat thumb;  // CV_32FC1 thumbnail for alignment
+    };
+
+    // Fusion of the given aligned frames into fused
+    void combine(const std::vector<cv::Mat> &frames, cv::Mat &fused) const;
+
+    QMutex mutex;                         // Guards everything below
+    std::atomic<int> frameCapacity;       // Ring size, 0 = disabled
+    FusionMethod fusionMethod;
+    std::vector<Slot> ring;               // Buffered frames
+    int next;                             // Slot the next frame goes into
+    int count;                            // Valid slots
+    double thumbScale;                    // Thumbnail size / frame size
+    cv::Mat thumbGray;                    // Scratch for thumbnails
+    cv::Mat window;                       // Hanning window of the thumbnails
+    std::vector<cv::Mat> alignedScratch;  // Shifted copies, reused
+    std::atomic<int> lastUsed;            // Frames in the last fuse
+};
+
+#endif // FRAMEFUSION_H
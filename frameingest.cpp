@@ -0,0 +1,179 @@
+/*
+ * frameingest.cpp - Video Frame Ingestion Implementation
+ *
+ * Purpose: Implements the format-aware QVideoFrame to luma conversion
+ */
+
+#include "frameingest.h"
+#include "pipelinestats.h"
+#include "framearena.h"
+#include <QDebug>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+FrameIngest::FrameIngest(const QVideoFrame &videoFrame, FrameArena *frameArena)
+    : frame(videoFrame)
+    , arena(frameArena)
+    , mapped(false)
+    , zeroCopy(false)
+{
+    if (!frame.isValid()) {
+        return;
+    }
+
+    QVideoFrameFormat::PixelFormat format = frame.pixelFormat();
+
+    if (isNativeFormat(format)) {
+        // Ensure frame is mapped to memory for reading
+        if (!frame.map(QVideoFrame::ReadOnly)) {
+            qWarning() << "Failed to map video frame";
+            return;
+        }
+        mapped = true;
+
+        if (ingestNative(format)) {
+            return;
+        }
+
+        // Unexpected plane layout, release the mapping and go generic
+        frame.unmap();
+        mapped = false;
+    }
+
+    ingestFallback();
+}
+
+FrameIngest::~FrameIngest()
+{
+    // Drop our view before the memory behind it goes away
+    lumaMat.release();
+
+    if (mapped) {
+        frame.unmap();
+    }
+}
+
+bool FrameIngest::isNativeFormat(QVideoFrameFormat::PixelFormat format)
+{
+    switch (format) {
+    case QVideoFrameFormat::Format_Y8:
+    case QVideoFrameFormat::Format_NV12:
+    case QVideoFrameFormat::Format_NV21:
+    case QVideoFrameFormat::Format_YUV420P:
+    case QVideoFrameFormat::Format_YV12:
+    case QVideoFrameFormat::Format_YUV422P:
+    case QVideoFrameFormat::Format_YUYV:
+    case QVideoFrameFormat::Format_UYVY:
+    case QVideoFrameFormat::Format_BGRA8888:
+    case QVideoFrameFormat::Format_BGRX8888:
+    case QVideoFrameFormat::Format_RGBA8888:
+    case QVideoFrameFormat::Format_RGBX8888:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool FrameIngest::ingestNative(QVideoFrameFormat::PixelFormat format)
+{
+    const int width = frame.width();
+    const int height = frame.height();
+
+    // Luma is always plane 0 for the formats we handle
+    uchar *bits = frame.bits(0);
+    const int stride = frame.bytesPerLine(0);
+
+    if (!bits || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    switch (format) {
+    case QVideoFrameFormat::Format_YUYV:
+    case QVideoFrameFormat::Format_UYVY: {
+        // Packed 4:2:2: Y0 U Y1 V (YUYV) or U Y0 V Y1 (UYVY).
+        // cv::Mat cannot express a 2-byte pixel stride, so pull the luma
+        // bytes out in a single pass into a half-size buffer.
+        if (stride < width * 2) {
+            return false;
+        }
+        cv::Mat packed(height, width, CV_8UC2, bits, stride);
+        int lumaChannel = (format == QVideoFrameFormat::Format_YUYV) ? 0 : 1;
+        lumaMat = lumaBuffer(width, height);
+        cv::extractChannel(packed, lumaMat, lumaChannel);
+        zeroCopy = false;
+        return true;
+    }
+
+    case QVideoFrameFormat::Format_BGRA8888:
+    case QVideoFrameFormat::Format_BGRX8888:
+    case QVideoFrameFormat::Format_RGBA8888:
+    case QVideoFrameFormat::Format_RGBX8888: {
+        // 32-bit RGB (e.g. screen capture, some webcams): weighted gray
+        // straight from the mapped frame, no QImage round trip
+        if (stride < width * 4) {
+            return false;
+        }
+        cv::Mat packed(height, width, CV_8UC4, bits, stride);
+        const bool bgr = format == QVideoFrameFormat::Format_BGRA8888
+                         || format == QVideoFrameFormat::Format_BGRX8888;
+        lumaMat = lumaBuffer(width, height);
+        cv::cvtColor(packed, lumaMat, bgr ? cv::COLOR_BGRA2GRAY : cv::COLOR_RGBA2GRAY);
+        zeroCopy = false;
+        return true;
+    }
+
+    default:
+        // Planar and semi-planar formats: plane 0 is a plain 8-bit image
+        if (stride < width) {
+            return false;
+        }
+        lumaMat = cv::Mat(height, width, CV_8UC1, bits, stride);
+        zeroCopy = true;
+        return true;
+    }
+}
+
+bool FrameIngest::ingestFallback()
+{
+    ScopedStageTimer timer(PipelineStats::ToImage);
+
+    // Convert QVideoFrame to QImage (maps the frame internally)
+    QImage image = frame.toImage();
+
+    // Check if conversion was successful
+    if (image.isNull()) {
+        qWarning() << "Failed to convert video frame to image";
+        return false;
+    }
+
+    // 32-bit images (the usual result) go to gray through the arena,
+    // anything else through a QImage conversion
+    if (image.format() == QImage::Format_RGB32
+        || image.format() == QImage::Format_ARGB32
+        || image.format() == QImage::Format_ARGB32_Premultiplied) {
+        cv::Mat packed(image.height(), image.width(), CV_8UC4,
+                       const_cast<uchar *>(image.constBits()), image.bytesPerLine());
+        lumaMat = lumaBuffer(image.width(), image.height());
+        cv::cvtColor(packed, lumaMat, cv::COLOR_BGRA2GRAY);
+        zeroCopy = false;
+        return true;
+    }
+
+    // Go straight to 8-bit gray: the pipeline only ever needs luma
+    fallbackImage = image.convertToFormat(QImage::Format_Grayscale8);
+
+    // Wrap the QImage pixels, fallbackImage keeps them alive
+    lumaMat = cv::Mat(fallbackImage.height(), fallbackImage.width(), CV_8UC1,
+                      const_cast<uchar *>(fallbackImage.constBits()),
+                      fallbackImage.bytesPerLine());
+    zeroCopy = false;
+    return true;
+}
+
+cv::Mat FrameIngest::lumaBuffer(int width, int height)
+{
+    if (arena) {
+        return arena->acquire(FrameArena::IngestLuma, cv::Size(width, height), CV_8UC1);
+    }
+    return cv::Mat(height, width, CV_8UC1);
+}
@@ -0,0 +1,71 @@
+/*
+ * frameingest.h - Video Frame Ingestion Header
+ *
+ * Purpose: Turns a QVideoFrame into the 8-bit luma image the processing
+ * pipeline works on, avoiding copies where the pixel format allows it:
+ * - Y8, NV12/NV21, YUV420P/YV12, YUV422P: the mapped luma plane is
+ *   wrapped directly as a CV_8UC1 Mat (zero copy)
+ * - YUYV/UYVY: the luma bytes are extracted in one pass
+ * - BGRA/BGRX/RGBA/RGBX: converted to gray in one pass
+ * - Anything else: falls back to QVideoFrame::toImage()
+ *
+ * Luma that has to be computed goes into a FrameArena buffer when one is
+ * given, so ingesting a stream does not allocate per frame.
+ */
+
+#ifndef FRAMEINGEST_H
+#define FRAMEINGEST_H
+
+#include <QVideoFrame>
+#include <QVideoFrameFormat>
+#include <QImage>
+#include <opencv2/core.hpp>
+
+class FrameArena;
+
+// Maps a video frame and exposes its luma plane for the lifetime of the
+// object. The frame stays mapped until the FrameIngest is destroyed, so
+// luma() must not be used after that (clone it if it has to outlive us).
+class FrameIngest
+{
+public:
+    // arena: where computed luma is stored; nullptr allocates per frame.
+    // The arena's luma buffer is overwritten by the next FrameIngest
+    // using the same arena
+    explicit FrameIngest(const QVideoFrame &frame, FrameArena *arena = nullptr);
+    ~FrameIngest();
+
+    FrameIngest(const FrameIngest &) = delete;
+    FrameIngest &operator=(const FrameIngest &) = delete;
+
+    // True if luma() holds a valid image
+    bool isValid() const { return !lumaMat.empty(); }
+
+    // 8-bit luma image (CV_8UC1), possibly pointing into the mapped frame
+    const cv::Mat &luma() const { return lumaMat; }
+
+    // True if luma() wraps the frame memory without any copy
+    bool isZeroCopy() const { return zeroCopy; }
+
+    // Check if a pixel format is ingested without going through QImage
+    static bool isNativeFormat(QVideoFrameFormat::PixelFormat format);
+
+private:
+    // Ingest one of the native formats from the mapped frame
+    bool ingestNative(QVideoFrameFormat::PixelFormat format);
+
+    // Generic path through QVideoFrame::toImage()
+    bool ingestFallback();
+
+    // Buffer for computed luma: from the arena, or newly allocated
+    cv::Mat lumaBuffer(int width, int height);
+
+    QVideoFrame frame;     // Our (shared) handle on the frame
+    FrameArena *arena;     // Buffer source for computed luma, may be null
+    bool mapped;           // Whether we hold a mapping on the frame
+    bool zeroCopy;         // Whether lumaMat points into the frame
+    QImage fallbackImage;  // Owns the pixels for the fallback path
+    cv::Mat lumaMat;       // The luma image handed to the pipeline
+};
+
+#endif // FRAMEINGEST_H
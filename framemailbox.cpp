@@ -0,0 +1,45 @@
+/*
+ * framemailbox.cpp - Latest-Frame Mailbox Implementation
+ *
+ * Purpose: Implements the lock-free single-slot frame handoff
+ */
+
+#include "framemailbox.h"
+#include "pipelinestats.h"
+#include <QDateTime>
+
+FrameMailbox::FrameMailbox()
+    : slot(nullptr)
+    , receivedCount(0)
+    , droppedCount(0)
+{
+}
+
+FrameMailbox::~FrameMailbox()
+{
+    delete slot.exchange(nullptr);
+}
+
+bool FrameMailbox::post(const QVideoFrame &frame, const QColor &fg, const QColor &bg)
+{
+    Item *item = new Item{frame, fg, bg, PipelineStats::now(), QDateTime::currentMSecsSinceEpoch()};
+
+    // Swap in the new frame; release publishes the item to the consumer
+    Item *previous = slot.exchange(item, std::memory_order_acq_rel);
+    receivedCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (previous) {
+        // The consumer is already due to wake up for the previous frame,
+        // it will find this one instead
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        delete previous;
+        return false;
+    }
+
+    return true;
+}
+
+FrameMailbox::Item *FrameMailbox::take()
+{
+    return slot.exchange(nullptr, std::memory_order_acq_rel);
+}
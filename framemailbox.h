@@ -0,0 +1,55 @@
+/*
+ * framemailbox.h - Latest-Frame Mailbox Header
+ *
+ * Purpose: Single-slot, lock-free handoff of video frames from the GUI
+ * thread to the frame processing thread. A new frame replaces any frame
+ * that has not been picked up yet ("latest wins"), so the processing
+ * thread never works through a backlog of stale frames.
+ */
+
+#ifndef FRAMEMAILBOX_H
+#define FRAMEMAILBOX_H
+
+#include <QVideoFrame>
+#include <QColor>
+#include <atomic>
+
+class FrameMailbox
+{
+public:
+    // One frame waiting to be processed, with the scheme it was taken with
+    struct Item {
+        QVideoFrame frame;
+        QColor foreground;
+        QColor background;
+        qint64 postedAt;  // PipelineStats::now() when posted
+        qint64 capturedMs;  // Wall clock when posted, ms since the epoch
+    };
+
+    FrameMailbox();
+    ~FrameMailbox();
+
+    FrameMailbox(const FrameMailbox &) = delete;
+    FrameMailbox &operator=(const FrameMailbox &) = delete;
+
+    // Producer: put a frame in the slot, dropping the one already there.
+    // Returns true if the slot was empty, i.e. the consumer must be woken.
+    bool post(const QVideoFrame &frame, const QColor &fg, const QColor &bg);
+
+    // Consumer: take the frame out of the slot, or nullptr if empty.
+    // The caller owns the returned item.
+    Item *take();
+
+    // Frames posted so far
+    quint64 received() const { return receivedCount.load(std::memory_order_relaxed); }
+
+    // Frames replaced before the consumer picked them up
+    quint64 dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<Item *> slot;              // The pending frame, if any
+    std::atomic<quint64> receivedCount;    // Frames posted
+    std::atomic<quint64> droppedCount;     // Frames overwritten unprocessed
+};
+
+#endif // FRAMEMAILBOX_H
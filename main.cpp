@@ -6,10 +6,32 @@
  */
 
 #include <QApplication>
+#include <QTimer>
 #include "mainwindow.h"
+#include "batchrunner.h"
 
 int main(int argc, char *argv[])
 {
+    // Headless batch mode: no window and no camera, so a plain core
+    // application is enough (and works without a display)
+    if (BatchRunner::isBatchInvocation(argc, argv)) {
+        BatchRunner::attachConsole();
+
+        QCoreApplication app(argc, argv);
+        app.setApplicationName("Video OCR");
+        app.setApplicationVersion("1.0.0");
+        app.setOrganizationName("YourOrganization");
+
+        BatchRunner runner;
+        if (!runner.parseArguments(app.arguments())) {
+            return 1;
+        }
+
+        // Start once the event loop runs, OCR results arrive through it
+        QTimer::singleShot(0, &runner, &BatchRunner::start);
+        return app.exec();
+    }
+
     // Create the Qt application object
     // This manages application-wide resources and event loop
     QApplication app(argc, argv);
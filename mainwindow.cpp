@@ -6,48 +6,75 @@
 
 #include "mainwindow.h"
 #include "videoprocessor.h"
+#include "capturesource.h"
+#include "ocrenginepool.h"
 #include "colorselectdialog.h"
 #include "ocrresultdialog.h"
+#include "ocrlog.h"
+#include "ocrlogdialog.h"
+#include "ocrresultcache.h"
+#include "pipelinestats.h"
 #include <QMessageBox>
+#include <QFileDialog>
+#include <QFile>
+#include <QFontDatabase>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QMediaDevices>
+#include <QStandardPaths>
+#include <algorithm>
 #include <QDebug>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
-    , camera(nullptr)
-    , captureSession(nullptr)
-    , videoSink(nullptr)
-    , videoProcessor(nullptr)
+    , ocrPool(nullptr)
+    , activeSource(0)
+    , ocrLog(nullptr)
     , colorDialog(nullptr)
     , ocrDialog(nullptr)
+    , logDialog(nullptr)
     , isCameraActive(false)
+    , pendingOCRSource(-1)
+    , pendingOCRJob(VideoProcessor::kNoJob)
+    , pendingOCRLines(0)
     , currentColorSchemeIndex(0)
 {
     // Initialize color schemes as specified in requirements
-    colorSchemes.append({"White on Black", QColor("#ffffff"), QColor("#000000")});
-    colorSchemes.append({"Black on White", QColor("#000000"), QColor("#ffffff")});
-    colorSchemes.append({"Green on Black", QColor("#11c70e"), QColor("#000000")});
-    colorSchemes.append({"Yellow on Black", QColor("#f4d81e"), QColor("#000000")});
+    colorSchemes.append({"White on Black", QColor("#ffffff"), QColor("#000000"), ThresholdMethod::Otsu});
+    colorSchemes.append({"Black on White", QColor("#000000"), QColor("#ffffff"), ThresholdMethod::Otsu});
+    colorSchemes.append({"Green on Black", QColor("#11c70e"), QColor("#000000"), ThresholdMethod::Otsu});
+    colorSchemes.append({"Yellow on Black", QColor("#f4d81e"), QColor("#000000"), ThresholdMethod::Otsu});
 
     // Set up the user interface
     setupUI();
 
-    // Initialize camera and video capture
-    setupCamera();
+    // Initialize the cameras, their processing and the shared OCR pool
+    setupCameras();
 
-    // Create video processor for frame processing and OCR
-    videoProcessor = new VideoProcessor(this);
+    // Keep every result on disk, searchable later
+    setupOCRLog();
 
-    // Connect signal from video processor when OCR completes
-    connect(videoProcessor, &VideoProcessor::ocrComplete,
-            this, &MainWindow::onOCRComplete);
+    // A capture nobody sees for 15 seconds is stale; F4 again starts over
+    ocrPool->setDeadline(15000);
+
+    // Show the processed stream in the video widgets
+    onProcessedViewToggled(processedViewCheck->isChecked());
 }
 
 MainWindow::~MainWindow()
 {
-    // Stop camera before destruction
-    if (camera) {
-        camera->stop();
-    }
+    // Stop the cameras and their frame processing while the video
+    // widgets' sinks still exist, then the pool they submit to
+    qDeleteAll(sources);
+    sources.clear();
+    delete ocrPool;
+    ocrPool = nullptr;
+
+    // Results of jobs still running are not logged
+    delete logDialog;
+    logDialog = nullptr;
+    delete ocrLog;
+    ocrLog = nullptr;
 
     // Qt's parent-child relationship will automatically delete child objects
 }
@@ -62,10 +89,9 @@ void MainWindow::setupUI()
     centralWidget = new QWidget(this);
     mainLayout = new QVBoxLayout(centralWidget);
 
-    // Create video widget for displaying camera feed
-    videoWidget = new QVideoWidget(this);
-    videoWidget->setMinimumSize(640, 480);
-    mainLayout->addWidget(videoWidget);
+    // Video widgets for the camera feeds, added by setupCameras
+    videoLayout = new QGridLayout();
+    mainLayout->addLayout(videoLayout, 1);
 
     // Create control panel layout (horizontal)
     QHBoxLayout *controlLayout = new QHBoxLayout();
@@ -76,6 +102,11 @@ void MainWindow::setupUI()
             this, &MainWindow::onStartStopClicked);
     controlLayout->addWidget(startStopButton);
 
+    // Camera selector, filled by setupCameras; hidden with one camera
+    sourceCombo = new QComboBox(this);
+    sourceCombo->setToolTip("Camera captured by F4, it also gets OCR first");
+    controlLayout->addWidget(sourceCombo);
+
     // Color scheme selector
     QLabel *colorLabel = new QLabel("Color Scheme:", this);
     controlLayout->addWidget(colorLabel);
@@ -88,10 +119,76 @@ void MainWindow::setupUI()
             this, &MainWindow::onColorSchemeChanged);
     controlLayout->addWidget(colorSchemeCombo);
 
+    // Threshold method, remembered per color scheme. Local thresholds
+    // cope with uneven lighting that a single global one cannot
+    thresholdCombo = new QComboBox(this);
+    thresholdCombo->setToolTip("How the image is split into text and background");
+    thresholdCombo->addItem("Global (Otsu)", int(ThresholdMethod::Otsu));
+    thresholdCombo->addItem("Local (Sauvola)", int(ThresholdMethod::Sauvola));
+    thresholdCombo->addItem("Local (Niblack)", int(ThresholdMethod::Niblack));
+    connect(thresholdCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onThresholdChanged);
+    controlLayout->addWidget(thresholdCombo);
+
+    // Continuous OCR: read the screen whenever it changes, no F4 needed
+    autoOCRCheck = new QCheckBox("Auto OCR", this);
+    autoOCRCheck->setToolTip("Perform OCR automatically when the scene changes and settles");
+    connect(autoOCRCheck, &QCheckBox::toggled,
+            this, &MainWindow::onAutoOCRToggled);
+    controlLayout->addWidget(autoOCRCheck);
+
+    // Text tracking: keep reading, but only the text that changed
+    trackTextCheck = new QCheckBox("Track Text", this);
+    trackTextCheck->setToolTip("Follow the text on screen and read only new or changed lines "
+                               "(tickers, dashboards)");
+    connect(trackTextCheck, &QCheckBox::toggled,
+            this, &MainWindow::onTrackTextToggled);
+    controlLayout->addWidget(trackTextCheck);
+
+    // Processed view: show the monochrome image instead of the raw camera
+    processedViewCheck = new QCheckBox("Processed View", this);
+    processedViewCheck->setToolTip("Show the monochrome image in the selected color scheme");
+    processedViewCheck->setChecked(true);
+    connect(processedViewCheck, &QCheckBox::toggled,
+            this, &MainWindow::onProcessedViewToggled);
+    controlLayout->addWidget(processedViewCheck);
+
     controlLayout->addStretch();  // Push controls to the left
 
+    // Pipeline statistics: live panel and JSON snapshot
+    statsCheck = new QCheckBox("Stats", this);
+    statsCheck->setToolTip("Show per-stage latencies and frame counters");
+    connect(statsCheck, &QCheckBox::toggled,
+            this, &MainWindow::onStatsToggled);
+    controlLayout->addWidget(statsCheck);
+
+    dumpStatsButton = new QPushButton("Save Stats...", this);
+    dumpStatsButton->setToolTip("Save the pipeline statistics as JSON");
+    connect(dumpStatsButton, &QPushButton::clicked,
+            this, &MainWindow::onDumpStatsClicked);
+    controlLayout->addWidget(dumpStatsButton);
+
+    // Persistent OCR log: when was some text on which camera
+    searchLogButton = new QPushButton("Search Log...", this);
+    searchLogButton->setToolTip("Find text in everything recognized so far");
+    connect(searchLogButton, &QPushButton::clicked,
+            this, &MainWindow::onSearchLogClicked);
+    controlLayout->addWidget(searchLogButton);
+
     mainLayout->addLayout(controlLayout);
 
+    // Statistics panel, hidden until enabled
+    statsLabel = new QLabel(this);
+    statsLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    statsLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    statsLabel->setVisible(false);
+    mainLayout->addWidget(statsLabel);
+
+    statsTimer = new QTimer(this);
+    statsTimer->setInterval(500);
+    connect(statsTimer, &QTimer::timeout,
+            this, &MainWindow::updateStatsPanel);
+
     // Status label for displaying information
     statusLabel = new QLabel("Press F4 to capture and perform OCR", this);
     statusLabel->setStyleSheet("QLabel { background-color: #f0f0f0; padding: 5px; }");
@@ -101,47 +198,153 @@ void MainWindow::setupUI()
     setCentralWidget(centralWidget);
 }
 
-void MainWindow::setupCamera()
+void MainWindow::setupCameras()
 {
-    // Create camera object (default camera)
-    camera = new QCamera(this);
+    // One OCR pool for all cameras: the engines are the scarce resource,
+    // and one pool schedules them fairly between the cameras
+    ocrPool = new OCREnginePool(0, nullptr);
 
-    // Create video sink to receive video frames
-    videoSink = new QVideoSink(this);
+    QList<QCameraDevice> devices = QMediaDevices::videoInputs();
+    if (devices.size() > kMaxCameras) {
+        devices = devices.mid(0, kMaxCameras);
+    }
+    if (devices.isEmpty()) {
+        // Let the default camera report what is wrong
+        devices.append(QCameraDevice());
+    }
 
-    // Connect video sink's videoFrameChanged signal to our slot
-    // This is called every time a new video frame is available
-    connect(videoSink, &QVideoSink::videoFrameChanged,
-            this, &MainWindow::onVideoFrameChanged);
+    // Two columns from two cameras on, each view a little smaller
+    const int columns = devices.size() > 1 ? 2 : 1;
+
+    for (int i = 0; i < devices.size(); i++) {
+        CaptureSource *source = new CaptureSource(devices[i], ocrPool, i, this);
+        sources.append(source);
+
+        // Create video widget for displaying camera feed
+        QVideoWidget *widget = new QVideoWidget(this);
+        widget->setMinimumSize(columns > 1 ? QSize(320, 240) : QSize(640, 480));
+        videoLayout->addWidget(widget, i / columns, i % columns);
+        videoWidgets.append(widget);
+        source->setVideoWidget(widget);
+
+        // Initial scheme and threshold method
+        const ColorScheme &scheme = colorSchemes[currentColorSchemeIndex];
+        source->setColorScheme(scheme.foreground, scheme.background);
+        source->processor()->setThresholdMethod(scheme.threshold);
+
+        // F4 reads the last 8 frames fused, not one noisy frame
+        source->processor()->setCaptureFusion(8);
+
+        // Results and lines of this camera, tagged with its index
+        connect(source->processor(), &VideoProcessor::ocrComplete, this, [this, i](const QString &text) {
+            onOCRComplete(i, text);
+        });
+        connect(source->processor(), &VideoProcessor::ocrLine, this, [this, i](quint64 jobId, const OcrLine &line) {
+            onOCRLine(i, jobId, line);
+        });
+
+        // Check for camera errors
+        connect(source, &CaptureSource::cameraError, this, [this, source](const QString &errorString) {
+            QMessageBox::critical(this, "Camera Error",
+                                  QString("Camera error (%1): %2").arg(source->name(), errorString));
+            statusLabel->setText("Camera error occurred");
+        });
+
+        sourceCombo->addItem(source->name());
+    }
 
-    // Create capture session to manage camera and outputs
-    captureSession = new QMediaCaptureSession(this);
-    captureSession->setCamera(camera);
-    captureSession->setVideoOutput(videoWidget);  // Display on video widget
-    captureSession->setVideoSink(videoSink);       // Also send to our sink for processing
+    sourceCombo->setVisible(sources.size() > 1);
+    connect(sourceCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onSourceChanged);
 
-    // Check for camera errors
-    connect(camera, &QCamera::errorOccurred, this, [this](QCamera::Error error, const QString &errorString) {
-        QMessageBox::critical(this, "Camera Error",
-                              QString("Camera error: %1").arg(errorString));
-        statusLabel->setText("Camera error occurred");
-    });
+    applySourcePolicies();
+}
+
+void MainWindow::setupOCRLog()
+{
+    const QString folder = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+                           + "/ocrlog";
+
+    ocrLog = new OCRLog(64 * 1024 * 1024, kOCRLogMaxBytes);
+    if (!ocrLog->open(folder)) {
+        delete ocrLog;
+        ocrLog = nullptr;
+        searchLogButton->setEnabled(false);
+        searchLogButton->setToolTip(QString("Error: Could not open the OCR log in %1").arg(folder));
+        return;
+    }
+
+    // Records name their camera by its device, not by where it is in this
+    // run's camera list
+    for (CaptureSource *source : sources) {
+        const QByteArray id = source->deviceId();
+        const int number = ocrLog->sourceFor(id.isEmpty() ? QString("default") : QString::fromUtf8(id),
+                                             source->name());
+        if (number >= 0) {
+            logSources.insert(source->id(), number);
+        }
+    }
+
+    // Lines come from the engine threads, queued ahead of their job's result
+    connect(ocrPool, &OCREnginePool::ocrLine, this, &MainWindow::onLogLine);
+    connect(ocrPool, &OCREnginePool::ocrComplete, this, &MainWindow::onLogResult);
+}
+
+void MainWindow::applySourcePolicies()
+{
+    const int cameras = sources.size();
+    const int engines = ocrPool->engineCount();
+
+    for (int i = 0; i < cameras; i++) {
+        OCREnginePool::SourcePolicy policy;
+
+        // The camera the user works with gets twice the engine time
+        policy.priority = i == activeSource ? 2 : 1;
+
+        // Whatever one camera does, an engine is left for each other one
+        policy.maxRunning = std::max(1, engines - (cameras - 1));
+
+        // Auto OCR of a busy camera must not pile up stale frames
+        policy.maxQueued = 2 * engines;
+
+        ocrPool->setSourcePolicy(sources[i]->id(), policy);
+    }
 }
 
 void MainWindow::onStartStopClicked()
 {
     if (!isCameraActive) {
-        // Start the camera
-        camera->start();
+        // Start the cameras
+        for (CaptureSource *source : sources) {
+            source->start();
+        }
         isCameraActive = true;
-        startStopButton->setText("Stop Camera");
+        startStopButton->setText(sources.size() > 1 ? "Stop Cameras" : "Stop Camera");
         statusLabel->setText("Camera active - Press F4 to capture and perform OCR");
     } else {
-        // Stop the camera
-        camera->stop();
+        // Stop the cameras
+        VideoProcessor::FrameCounters total{};
+        for (CaptureSource *source : sources) {
+            source->stop();
+
+            VideoProcessor::FrameCounters counters = source->processor()->frameCounters();
+            total.received += counters.received;
+            total.processed += counters.processed;
+            total.dropped += counters.dropped;
+            total.displayed += counters.displayed;
+            total.autoOCR += counters.autoOCR;
+        }
         isCameraActive = false;
-        startStopButton->setText("Start Camera");
-        statusLabel->setText("Camera stopped");
+        startStopButton->setText(sources.size() > 1 ? "Start Cameras" : "Start Camera");
+
+        // Report how the processing threads kept up with the cameras
+        statusLabel->setText(QString("Camera stopped - frames received: %1, processed: %2, "
+                                     "dropped: %3, displayed: %4, auto OCR passes: %5")
+                                 .arg(total.received)
+                                 .arg(total.processed)
+                                 .arg(total.dropped)
+                                 .arg(total.displayed)
+                                 .arg(total.autoOCR));
     }
 }
 
@@ -150,28 +353,179 @@ void MainWindow::onColorSchemeChanged(int index)
     // Update current color scheme index
     currentColorSchemeIndex = index;
 
-    // If video processor exists, update its color scheme
-    if (videoProcessor) {
-        const auto &scheme = colorSchemes[index];
-        videoProcessor->setColorScheme(scheme.foreground, scheme.background);
+    // Update the color scheme of every camera
+    const ColorScheme scheme = colorSchemes[index];
+    for (CaptureSource *source : sources) {
+        source->setColorScheme(scheme.foreground, scheme.background);
+        source->processor()->setThresholdMethod(scheme.threshold);
     }
 
+    // Show the threshold method this scheme uses
+    thresholdCombo->setCurrentIndex(thresholdCombo->findData(int(scheme.threshold)));
+
     statusLabel->setText(QString("Color scheme changed to: %1").arg(colorSchemes[index].name));
 }
 
-void MainWindow::onVideoFrameChanged(const QVideoFrame &frame)
+void MainWindow::onThresholdChanged(int index)
+{
+    if (index < 0) {
+        return;
+    }
+
+    auto method = ThresholdMethod(thresholdCombo->itemData(index).toInt());
+    colorSchemes[currentColorSchemeIndex].threshold = method;
+
+    for (CaptureSource *source : sources) {
+        source->processor()->setThresholdMethod(method);
+    }
+
+    statusLabel->setText(QString("Threshold changed to: %1").arg(thresholdCombo->itemText(index)));
+}
+
+void MainWindow::onSourceChanged(int index)
+{
+    if (index < 0 || index >= sources.size()) {
+        return;
+    }
+
+    activeSource = index;
+    applySourcePolicies();
+
+    statusLabel->setText(QString("F4 captures %1").arg(sources[index]->name()));
+}
+
+void MainWindow::onAutoOCRToggled(bool enabled)
+{
+    for (CaptureSource *source : sources) {
+        source->processor()->setContinuousMode(enabled);
+    }
+
+    statusLabel->setText(enabled ? "Auto OCR on - text is read when the scene changes"
+                                 : "Auto OCR off - Press F4 to capture and perform OCR");
+}
+
+void MainWindow::onTrackTextToggled(bool enabled)
+{
+    for (CaptureSource *source : sources) {
+        source->processor()->setTextTracking(enabled);
+    }
+
+    statusLabel->setText(enabled ? "Text tracking on - new and changed text is read as it appears"
+                                 : "Text tracking off - Press F4 to capture and perform OCR");
+}
+
+void MainWindow::onProcessedViewToggled(bool enabled)
+{
+    for (CaptureSource *source : sources) {
+        source->setProcessedView(enabled);
+    }
+}
+
+void MainWindow::onStatsToggled(bool visible)
+{
+    statsLabel->setVisible(visible);
+
+    if (visible) {
+        updateStatsPanel();
+        statsTimer->start();
+    } else {
+        statsTimer->stop();
+    }
+}
+
+void MainWindow::updateStatsPanel()
 {
-    // Store the current frame for OCR capture
-    currentFrame = frame;
+    if (sources.isEmpty()) {
+        return;
+    }
+
+    OCRResultCache::Stats cacheStats = ocrPool->resultCache()->stats();
+    const double seconds = std::max(PipelineStats::instance().elapsedSeconds(), 1e-9);
+
+    QString text = PipelineStats::instance().toText();
+
+    // Per camera: frames, and its share of the OCR engines
+    for (CaptureSource *source : sources) {
+        VideoProcessor::FrameCounters counters = source->processor()->frameCounters();
+        OCREnginePool::SourceStats ocr = ocrPool->sourceStats(source->id());
+        text += QString("%1: frames received %2, processed %3 (%4/s), dropped %5, displayed %6 "
+                        "(%7 skipped) | OCR %8 done (%9/s), p50 %10 ms, p99 %11 ms, "
+                        "%12 queued, %13 running, %14 dropped\n")
+                    .arg(source->name())
+                    .arg(counters.received)
+                    .arg(counters.processed)
+                    .arg(counters.processed / seconds, 0, 'f', 1)
+                    .arg(counters.dropped)
+                    .arg(counters.displayed)
+                    .arg(counters.displayDropped)
+                    .arg(ocr.completed)
+                    .arg(ocr.completed / seconds, 0, 'f', 2)
+                    .arg(ocr.latency.p50 / 1e6, 0, 'f', 0)
+                    .arg(ocr.latency.p99 / 1e6, 0, 'f', 0)
+                    .arg(ocr.queued)
+                    .arg(ocr.running)
+                    .arg(ocr.dropped);
+
+        // Tracking: how much of the text did not need reading again
+        if (source->processor()->isTextTracking()) {
+            TextTracker::Counters tracking = source->processor()->textTrackingCounters();
+            text += QString("    tracking %1 regions, %2 re-read, %3 of %4 unchanged\n")
+                        .arg(tracking.tracks)
+                        .arg(tracking.requests)
+                        .arg(tracking.unchanged)
+                        .arg(tracking.followed);
+        }
+    }
 
-    // Process the frame if video processor is ready
-    if (videoProcessor) {
-        // Create a copy since QVideoFrame may be modified
-        QVideoFrame frameCopy = frame;
-        videoProcessor->processFrame(frameCopy,
-                                     colorSchemes[currentColorSchemeIndex].foreground,
-                                     colorSchemes[currentColorSchemeIndex].background);
+    text += QString("OCR cache hits %1, misses %2 | engines %3")
+                .arg(cacheStats.hits)
+                .arg(cacheStats.misses)
+                .arg(ocrPool->engineCount());
+
+    if (ocrLog) {
+        OCRLog::Stats logStats = ocrLog->stats();
+        text += QString(" | log %1 results, %2 MB in %3 segments")
+                    .arg(logStats.records)
+                    .arg(logStats.bytes / (1024.0 * 1024.0), 0, 'f', 1)
+                    .arg(logStats.segments);
     }
+
+    statsLabel->setText(text);
+}
+
+void MainWindow::onDumpStatsClicked()
+{
+    if (sources.isEmpty()) {
+        return;
+    }
+
+    // Take the snapshot first, so it reflects the moment of the click.
+    // Stages and pool figures are process-wide; frames and OCR per camera
+    QJsonObject snapshot = sources[activeSource]->processor()->statsSnapshot();
+    QJsonArray cameras;
+    for (CaptureSource *source : sources) {
+        QJsonObject camera = source->processor()->sourceSnapshot();
+        camera["name"] = source->name();
+        cameras.append(camera);
+    }
+    snapshot["sources"] = cameras;
+    QByteArray json = QJsonDocument(snapshot).toJson();
+
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Statistics",
+                                                    "videoocr-stats.json",
+                                                    "JSON files (*.json)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+        QMessageBox::warning(this, "Save Statistics",
+                             QString("Error: Could not write %1").arg(fileName));
+        return;
+    }
+
+    statusLabel->setText(QString("Statistics saved to %1").arg(fileName));
 }
 
 void MainWindow::keyPressEvent(QKeyEvent *event)
@@ -192,36 +546,125 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
 
 void MainWindow::captureAndPerformOCR()
 {
+    CaptureSource *source = sources.value(activeSource);
+
     // Check if we have a valid frame
-    if (!currentFrame.isValid()) {
+    if (!source || !source->currentFrame().isValid()) {
         statusLabel->setText("No frame available for OCR");
         return;
     }
 
     statusLabel->setText("Performing OCR...");
 
-    // Create a copy of the frame for OCR processing
-    QVideoFrame frameCopy = currentFrame;
+    // Process OCR in video processor (runs in separate thread).
+    // Pressing F4 again replaces this capture if it is not done yet
+    pendingOCRSource = activeSource;
+    pendingOCRJob = source->captureOCR();
+    pendingOCRLines = 0;
+}
+
+void MainWindow::onOCRLine(int sourceIndex, quint64 jobId, const OcrLine &line)
+{
+    // Lines of auto OCR and of replaced captures are not shown
+    if (sourceIndex != pendingOCRSource || jobId != pendingOCRJob) {
+        return;
+    }
+
+    if (!ocrDialog) {
+        ocrDialog = new OCRResultDialog(this);
+    }
+
+    // The first line replaces the previous result
+    if (pendingOCRLines == 0) {
+        ocrDialog->beginOCRLines();
+        ocrDialog->show();
+        ocrDialog->raise();
+        ocrDialog->activateWindow();
+    }
+    pendingOCRLines++;
 
-    // Process OCR in video processor (runs in separate thread)
-    videoProcessor->performOCR(frameCopy,
-                               colorSchemes[currentColorSchemeIndex].foreground,
-                               colorSchemes[currentColorSchemeIndex].background);
+    ocrDialog->appendOCRLine(line);
+    statusLabel->setText(QString("Performing OCR... %1 lines").arg(pendingOCRLines));
 }
 
-void MainWindow::onOCRComplete(const QString &text)
+void MainWindow::onOCRComplete(int sourceIndex, const QString &text)
 {
-    // Update status
-    statusLabel->setText("OCR complete");
+    // Update status; repeated captures of the same screen are cache hits
+    OCRResultCache::Stats cacheStats = ocrPool->resultCache()->stats();
+    QString status = QString("OCR complete (cache hits: %1, misses: %2)")
+                         .arg(cacheStats.hits)
+                         .arg(cacheStats.misses);
+    if (sources.size() > 1) {
+        status = sources[sourceIndex]->name() + ": " + status;
+    }
+    statusLabel->setText(status);
 
     // Create or update OCR result dialog
     if (!ocrDialog) {
         ocrDialog = new OCRResultDialog(this);
     }
 
-    // Display the recognized text
+    // Display the recognized text. This also replaces the lines shown so
+    // far, with the result as Tesseract formats it as a whole
     ocrDialog->setOCRText(text);
     ocrDialog->show();
-    ocrDialog->raise();      // Bring to front
-    ocrDialog->activateWindow();  // Give focus
+
+    // Auto OCR and tracking update in the background, don't steal the
+    // focus each time
+    if (!autoOCRCheck->isChecked() && !trackTextCheck->isChecked()) {
+        ocrDialog->raise();      // Bring to front
+        ocrDialog->activateWindow();  // Give focus
+    }
+}
+
+void MainWindow::onLogLine(int source, quint64 jobId, const OcrLine &line)
+{
+    loggedLines[std::make_pair(source, jobId)].push_back(line);
+}
+
+void MainWindow::onLogResult(int source, quint64 jobId, const QString &text, qint64 capturedMs)
+{
+    OCRLog::Record record;
+    record.source = logSources.value(source, -1);
+    record.timestampMs = capturedMs;
+
+    auto it = loggedLines.find({source, jobId});
+    if (it != loggedLines.end()) {
+        record.lines = std::move(it->second);
+        loggedLines.erase(it);
+    }
+
+    // Failed, replaced and expired jobs and empty frames read nothing,
+    // and a camera that could not be registered is not logged
+    if (!OCREnginePool::hasText(text) || record.source < 0) {
+        return;
+    }
+
+    // Answered from the cache: the text without lines, so no boxes and
+    // no confidence
+    if (record.lines.empty()) {
+        for (const QString &part : text.split('\n', Qt::SkipEmptyParts)) {
+            OcrLine line;
+            line.text = part;
+            line.confidence = -1.f;
+            record.lines.push_back(line);
+        }
+    }
+
+    ocrLog->append(record);
+}
+
+void MainWindow::onSearchLogClicked()
+{
+    if (!ocrLog) {
+        return;
+    }
+
+    if (!logDialog) {
+        logDialog = new OCRLogDialog(ocrLog, this);
+    }
+
+    logDialog->show();
+    logDialog->raise();
+    logDialog->activateWindow();
 }
@@ -2,31 +2,43 @@
  * mainwindow.h - Main Window Header
  *
  * Purpose: Defines the main application window that contains:
- * - Video display area
+ * - Video display area, one view per camera (up to kMaxCameras)
  * - Camera controls (start/stop)
- * - Color scheme selection
- * - Capture functionality (F4 key)
+ * - Color scheme selection, with a threshold method per scheme
+ * - Capture functionality (F4 key, on the selected camera)
+ * - Live pipeline statistics panel, with per-camera OCR figures
+ * - Search of the OCR log, which keeps every recognition of every camera
  */
 
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QCamera>
-#include <QMediaCaptureSession>
 #include <QVideoWidget>
-#include <QVideoSink>
 #include <QPushButton>
 #include <QComboBox>
+#include <QCheckBox>
 #include <QLabel>
+#include <QTimer>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
+#include <QGridLayout>
 #include <QKeyEvent>
+#include <QHash>
+#include <map>
+#include <utility>
+#include <vector>
+#include "adaptivebinarizer.h"
+#include "ocrline.h"
 
 // Forward declarations to avoid circular dependencies
 class VideoProcessor;
+class CaptureSource;
+class OCREnginePool;
 class ColorSelectDialog;
 class OCRResultDialog;
+class OCRLog;
+class OCRLogDialog;
 
 class MainWindow : public QMainWindow
 {
@@ -39,6 +51,12 @@ public:
     // Destructor: Clean up resources
     ~MainWindow();
 
+    // Most cameras opened at once
+    static constexpr int kMaxCameras = 4;
+
+    // The oldest recognitions are dropped from the OCR log beyond this
+    static constexpr qint64 kOCRLogMaxBytes = qint64(4) * 1024 * 1024 * 1024;
+
 protected:
     // Override keyPressEvent to capture F4 key for OCR
     void keyPressEvent(QKeyEvent *event) override;
@@ -50,51 +68,109 @@ private slots:
     // Slot: Called when color scheme is changed
     void onColorSchemeChanged(int index);
 
-    // Slot: Called when a new video frame is available
-    void onVideoFrameChanged(const QVideoFrame &frame);
+    // Slot: Called when the threshold method of the current scheme changes
+    void onThresholdChanged(int index);
+
+    // Slot: Called when another camera is selected for F4
+    void onSourceChanged(int index);
+
+    // Slot: Called when continuous (auto) OCR is switched on or off
+    void onAutoOCRToggled(bool enabled);
+
+    // Slot: Called when text tracking is switched on or off
+    void onTrackTextToggled(bool enabled);
+
+    // Slot: Called when the processed (monochrome) view is switched on or off
+    void onProcessedViewToggled(bool enabled);
+
+    // Slot: Called when the statistics panel is shown or hidden
+    void onStatsToggled(bool visible);
+
+    // Slot: Refresh the statistics panel (timer driven)
+    void updateStatsPanel();
 
-    // Slot: Called when OCR processing is complete
-    void onOCRComplete(const QString &text);
+    // Slot: Save a JSON snapshot of the pipeline statistics
+    void onDumpStatsClicked();
+
+    // Slot: Called when OCR processing of a camera is complete
+    void onOCRComplete(int sourceIndex, const QString &text);
+
+    // Slot: Called for each line of a capture while it is being recognized
+    void onOCRLine(int sourceIndex, quint64 jobId, const OcrLine &line);
+
+    // Slot: Collect a line of any camera's job for the OCR log
+    void onLogLine(int source, quint64 jobId, const OcrLine &line);
+
+    // Slot: Append a finished job of any camera to the OCR log, at the
+    // time its frame was captured
+    void onLogResult(int source, quint64 jobId, const QString &text, qint64 capturedMs);
+
+    // Slot: Open the OCR log search
+    void onSearchLogClicked();
 
 private:
     // Private method: Set up the user interface
     void setupUI();
 
-    // Private method: Initialize camera and capture session
-    void setupCamera();
+    // Private method: Open the cameras, sharing one OCR pool
+    void setupCameras();
+
+    // Private method: Open the OCR log and record every result into it
+    void setupOCRLog();
+
+    // Private method: Give the selected camera a larger share of the OCR
+    // engines and keep every camera from taking all of them
+    void applySourcePolicies();
 
-    // Private method: Perform OCR on current frame
+    // Private method: Perform OCR on the selected camera's current frame
     void captureAndPerformOCR();
 
     // UI Components
     QWidget *centralWidget;           // Central widget container
     QVBoxLayout *mainLayout;          // Main vertical layout
-    QVideoWidget *videoWidget;        // Widget to display video
+    QGridLayout *videoLayout;         // One video widget per camera
+    QList<QVideoWidget *> videoWidgets;  // Widgets to display video
     QPushButton *startStopButton;     // Button to start/stop camera
+    QComboBox *sourceCombo;           // Camera that F4 captures
     QComboBox *colorSchemeCombo;      // Dropdown for color schemes
+    QComboBox *thresholdCombo;        // Threshold method of the scheme
+    QCheckBox *autoOCRCheck;          // Continuous OCR on scene changes
+    QCheckBox *trackTextCheck;        // Continuous OCR of changed regions
+    QCheckBox *processedViewCheck;    // Show monochrome instead of raw video
+    QCheckBox *statsCheck;            // Show/hide the statistics panel
+    QPushButton *dumpStatsButton;     // Save statistics as JSON
+    QPushButton *searchLogButton;     // Search the OCR log
+    QLabel *statsLabel;               // Live per-stage latency table
+    QTimer *statsTimer;               // Refreshes statsLabel while shown
     QLabel *statusLabel;              // Status information display
 
-    // Camera Components
-    QCamera *camera;                  // Camera object for video capture
-    QMediaCaptureSession *captureSession;  // Session managing camera
-    QVideoSink *videoSink;           // Sink to receive video frames
+    // Camera and Processing Components
+    OCREnginePool *ocrPool;           // OCR engines shared by all cameras
+    QList<CaptureSource *> sources;   // One per camera: capture, processing
+    int activeSource;                 // Index of the camera F4 captures
 
-    // Processing Components
-    VideoProcessor *videoProcessor;   // Handles frame processing and OCR
+    // OCR log: every result of every camera, with its lines
+    OCRLog *ocrLog;                   // nullptr if it could not be opened
+    QHash<int, int> logSources;       // Pool source ID -> source in the log
+    std::map<std::pair<int, quint64>, std::vector<OcrLine>> loggedLines;  // By source, job
 
     // Dialog Windows
     ColorSelectDialog *colorDialog;   // Dialog for color selection
     OCRResultDialog *ocrDialog;       // Dialog to display OCR results
+    OCRLogDialog *logDialog;          // Dialog to search the OCR log
 
     // State Variables
     bool isCameraActive;              // Track camera state
-    QVideoFrame currentFrame;         // Store latest video frame for OCR
+    int pendingOCRSource;             // Camera of the latest F4 capture
+    quint64 pendingOCRJob;            // Job of the latest F4 capture
+    int pendingOCRLines;              // Lines of that job shown so far
 
-    // Color Schemes (foreground, background)
+    // Color Schemes (foreground, background, how to threshold)
     struct ColorScheme {
         QString name;
         QColor foreground;
         QColor background;
+        ThresholdMethod threshold;
     };
     QList<ColorScheme> colorSchemes;  // List of available color schemes
     int currentColorSchemeIndex;      // Currently selected scheme
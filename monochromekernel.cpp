@@ -0,0 +1,357 @@
+/*
+ * monochromekernel.cpp - Binary to Two-Color Kernel Implementation
+ *
+ * Purpose: Implements the scalar, SSSE3 and AVX2 colorization kernels
+ * (3- and 4-channel output) and the runtime dispatch between them
+ */
+
+#include "monochromekernel.h"
+#include <opencv2/core/utility.hpp>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MONOCHROME_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+// GCC and Clang need a per-function target to emit SSSE3/AVX2 code
+// without raising the baseline of the whole build. MSVC does not.
+#if defined(MONOCHROME_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MONOCHROME_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MONOCHROME_TARGET(isa)
+#endif
+
+namespace MonochromeKernel {
+
+namespace {
+
+// Number of output bytes covered by one AVX2 iteration (32 pixels * 3)
+constexpr int kPatternBytes = 96;
+
+// Per-call constants shared by the SIMD kernels
+struct ColorPatterns {
+    // bgPattern[k] = bg[k % 3], diffPattern[k] = (fg ^ bg)[k % 3]
+    alignas(32) uchar bgPattern[kPatternBytes];
+    alignas(32) uchar diffPattern[kPatternBytes];
+};
+
+// Shuffle control that triplicates mask bytes into BGR triplets.
+// Output byte k belongs to pixel k / 3. AVX2 shuffles within 128-bit
+// lanes, so pixels of the upper source half are indexed from 0 again.
+struct alignas(32) ShuffleTable {
+    uchar index[kPatternBytes];
+
+    ShuffleTable()
+    {
+        for (int k = 0; k < kPatternBytes; k++) {
+            int pixel = k / 3;
+            index[k] = static_cast<uchar>(k < 48 ? pixel : pixel - 16);
+        }
+    }
+};
+
+const ShuffleTable kShuffle;
+
+// Scalar reference kernel, also used for the row tails of the SIMD kernels
+void colorizeRowScalar(const uchar *src, uchar *dst, int begin, int width,
+                       const cv::Vec3b &fg, const cv::Vec3b &bg)
+{
+    dst += begin * 3;
+    for (int x = begin; x < width; x++) {
+        const cv::Vec3b &color = src[x] > 128 ? fg : bg;
+        dst[0] = color[0];
+        dst[1] = color[1];
+        dst[2] = color[2];
+        dst += 3;
+    }
+}
+
+// Pack a color into one BGRX pixel as it is laid out in memory
+inline uint32_t packBgrx(const cv::Vec3b &color)
+{
+    return uint32_t(color[0]) | (uint32_t(color[1]) << 8) | (uint32_t(color[2]) << 16)
+           | 0xff000000u;
+}
+
+// Scalar 4-channel kernel, also used for the row tails
+void colorizeRowBgrxScalar(const uchar *src, uchar *dst, int begin, int width,
+                           uint32_t fg, uint32_t bg)
+{
+    for (int x = begin; x < width; x++) {
+        const uint32_t pixel = src[x] > 128 ? fg : bg;
+        std::memcpy(dst + x * 4, &pixel, sizeof(pixel));
+    }
+}
+
+#ifdef MONOCHROME_KERNEL_X86
+
+// Processes 16 pixels per iteration, returns the number of pixels done
+MONOCHROME_TARGET("ssse3")
+int colorizeRowSSSE3(const uchar *src, uchar *dst, int width,
+                     const ColorPatterns &patterns)
+{
+    // Unsigned "x > 128" is a signed "(x ^ 0x80) > 0"
+    const __m128i sign = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i zero = _mm_setzero_si128();
+
+    const __m128i c0 = _mm_load_si128(reinterpret_cast<const __m128i *>(kShuffle.index));
+    const __m128i c1 = _mm_load_si128(reinterpret_cast<const __m128i *>(kShuffle.index + 16));
+    const __m128i c2 = _mm_load_si128(reinterpret_cast<const __m128i *>(kShuffle.index + 32));
+
+    const __m128i bg0 = _mm_load_si128(reinterpret_cast<const __m128i *>(patterns.bgPattern));
+    const __m128i bg1 = _mm_load_si128(reinterpret_cast<const __m128i *>(patterns.bgPattern + 16));
+    const __m128i bg2 = _mm_load_si128(reinterpret_cast<const __m128i *>(patterns.bgPattern + 32));
+    const __m128i d0 = _mm_load_si128(reinterpret_cast<const __m128i *>(patterns.diffPattern));
+    const __m128i d1 = _mm_load_si128(reinterpret_cast<const __m128i *>(patterns.diffPattern + 16));
+    const __m128i d2 = _mm_load_si128(reinterpret_cast<const __m128i *>(patterns.diffPattern + 32));
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x));
+        __m128i mask = _mm_cmpgt_epi8(_mm_xor_si128(v, sign), zero);
+
+        // out = bg ^ ((fg ^ bg) & mask), one mask byte per channel
+        __m128i o0 = _mm_xor_si128(bg0, _mm_and_si128(d0, _mm_shuffle_epi8(mask, c0)));
+        __m128i o1 = _mm_xor_si128(bg1, _mm_and_si128(d1, _mm_shuffle_epi8(mask, c1)));
+        __m128i o2 = _mm_xor_si128(bg2, _mm_and_si128(d2, _mm_shuffle_epi8(mask, c2)));
+
+        __m128i *out = reinterpret_cast<__m128i *>(dst + x * 3);
+        _mm_storeu_si128(out, o0);
+        _mm_storeu_si128(out + 1, o1);
+        _mm_storeu_si128(out + 2, o2);
+    }
+    return x;
+}
+
+// Processes 32 pixels per iteration, returns the number of pixels done
+MONOCHROME_TARGET("avx2")
+int colorizeRowAVX2(const uchar *src, uchar *dst, int width,
+                    const ColorPatterns &patterns)
+{
+    const __m256i sign = _mm256_set1_epi8(static_cast<char>(0x80));
+    const __m256i zero = _mm256_setzero_si256();
+
+    const __m256i c0 = _mm256_load_si256(reinterpret_cast<const __m256i *>(kShuffle.index));
+    const __m256i c1 = _mm256_load_si256(reinterpret_cast<const __m256i *>(kShuffle.index + 32));
+    const __m256i c2 = _mm256_load_si256(reinterpret_cast<const __m256i *>(kShuffle.index + 64));
+
+    const __m256i bg0 = _mm256_load_si256(reinterpret_cast<const __m256i *>(patterns.bgPattern));
+    const __m256i bg1 = _mm256_load_si256(reinterpret_cast<const __m256i *>(patterns.bgPattern + 32));
+    const __m256i bg2 = _mm256_load_si256(reinterpret_cast<const __m256i *>(patterns.bgPattern + 64));
+    const __m256i d0 = _mm256_load_si256(reinterpret_cast<const __m256i *>(patterns.diffPattern));
+    const __m256i d1 = _mm256_load_si256(reinterpret_cast<const __m256i *>(patterns.diffPattern + 32));
+    const __m256i d2 = _mm256_load_si256(reinterpret_cast<const __m256i *>(patterns.diffPattern + 64));
+
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + x));
+        __m256i mask = _mm256_cmpgt_epi8(_mm256_xor_si256(v, sign), zero);
+
+        // Output bytes 0..31 come from pixels 0..10, bytes 32..63 from
+        // pixels 10..21 (straddling both lanes), bytes 64..95 from 21..31
+        __m256i lo = _mm256_broadcastsi128_si256(_mm256_castsi256_si128(mask));
+        __m256i hi = _mm256_broadcastsi128_si256(_mm256_extracti128_si256(mask, 1));
+
+        __m256i o0 = _mm256_xor_si256(bg0, _mm256_and_si256(d0, _mm256_shuffle_epi8(lo, c0)));
+        __m256i o1 = _mm256_xor_si256(bg1, _mm256_and_si256(d1, _mm256_shuffle_epi8(mask, c1)));
+        __m256i o2 = _mm256_xor_si256(bg2, _mm256_and_si256(d2, _mm256_shuffle_epi8(hi, c2)));
+
+        __m256i *out = reinterpret_cast<__m256i *>(dst + x * 3);
+        _mm256_storeu_si256(out, o0);
+        _mm256_storeu_si256(out + 1, o1);
+        _mm256_storeu_si256(out + 2, o2);
+    }
+    return x;
+}
+
+// 4-channel output needs no shuffle: each mask byte is widened to a
+// whole pixel by unpacking it with itself twice
+MONOCHROME_TARGET("ssse3")
+int colorizeRowBgrxSSSE3(const uchar *src, uchar *dst, int width,
+                         uint32_t fg, uint32_t bg)
+{
+    const __m128i sign = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bgv = _mm_set1_epi32(static_cast<int>(bg));
+    const __m128i diff = _mm_set1_epi32(static_cast<int>(fg ^ bg));
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x));
+        __m128i mask = _mm_cmpgt_epi8(_mm_xor_si128(v, sign), zero);
+
+        __m128i lo = _mm_unpacklo_epi8(mask, mask);
+        __m128i hi = _mm_unpackhi_epi8(mask, mask);
+
+        __m128i *out = reinterpret_cast<__m128i *>(dst + x * 4);
+        _mm_storeu_si128(out, _mm_xor_si128(bgv, _mm_and_si128(diff, _mm_unpacklo_epi16(lo, lo))));
+        _mm_storeu_si128(out + 1, _mm_xor_si128(bgv, _mm_and_si128(diff, _mm_unpackhi_epi16(lo, lo))));
+        _mm_storeu_si128(out + 2, _mm_xor_si128(bgv, _mm_and_si128(diff, _mm_unpacklo_epi16(hi, hi))));
+        _mm_storeu_si128(out + 3, _mm_xor_si128(bgv, _mm_and_si128(diff, _mm_unpackhi_epi16(hi, hi))));
+    }
+    return x;
+}
+
+// Sign extension turns each 0x00/0xff mask byte into a 32-bit pixel mask
+MONOCHROME_TARGET("avx2")
+int colorizeRowBgrxAVX2(const uchar *src, uchar *dst, int width,
+                        uint32_t fg, uint32_t bg)
+{
+    const __m256i sign = _mm256_set1_epi8(static_cast<char>(0x80));
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i bgv = _mm256_set1_epi32(static_cast<int>(bg));
+    const __m256i diff = _mm256_set1_epi32(static_cast<int>(fg ^ bg));
+
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + x));
+        __m256i mask = _mm256_cmpgt_epi8(_mm256_xor_si256(v, sign), zero);
+
+        __m128i lo = _mm256_castsi256_si128(mask);
+        __m128i hi = _mm256_extracti128_si256(mask, 1);
+
+        __m256i m0 = _mm256_cvtepi8_epi32(lo);
+        __m256i m1 = _mm256_cvtepi8_epi32(_mm_srli_si128(lo, 8));
+        __m256i m2 = _mm256_cvtepi8_epi32(hi);
+        __m256i m3 = _mm256_cvtepi8_epi32(_mm_srli_si128(hi, 8));
+
+        __m256i *out = reinterpret_cast<__m256i *>(dst + x * 4);
+        _mm256_storeu_si256(out, _mm256_xor_si256(bgv, _mm256_and_si256(diff, m0)));
+        _mm256_storeu_si256(out + 1, _mm256_xor_si256(bgv, _mm256_and_si256(diff, m1)));
+        _mm256_storeu_si256(out + 2, _mm256_xor_si256(bgv, _mm256_and_si256(diff, m2)));
+        _mm256_storeu_si256(out + 3, _mm256_xor_si256(bgv, _mm256_and_si256(diff, m3)));
+    }
+    return x;
+}
+
+#endif // MONOCHROME_KERNEL_X86
+
+} // namespace
+
+const char *isaName(Isa isa)
+{
+    switch (isa) {
+    case Isa::SSSE3:
+        return "ssse3";
+    case Isa::AVX2:
+        return "avx2";
+    case Isa::Scalar:
+    default:
+        return "scalar";
+    }
+}
+
+bool isIsaAvailable(Isa isa)
+{
+    switch (isa) {
+    case Isa::Scalar:
+        return true;
+#ifdef MONOCHROME_KERNEL_X86
+    case Isa::SSSE3:
+        return cv::checkHardwareSupport(CV_CPU_SSSE3);
+    case Isa::AVX2:
+        return cv::checkHardwareSupport(CV_CPU_AVX2);
+#endif
+    default:
+        return false;
+    }
+}
+
+Isa bestAvailableIsa()
+{
+    // Detected once, the CPU does not change while we run
+    static const Isa best = isIsaAvailable(Isa::AVX2)  ? Isa::AVX2
+                            : isIsaAvailable(Isa::SSSE3) ? Isa::SSSE3
+                                                         : Isa::Scalar;
+    return best;
+}
+
+void colorize(const cv::Mat &binary, cv::Mat &dst,
+              const cv::Vec3b &fg, const cv::Vec3b &bg)
+{
+    colorize(binary, dst, fg, bg, bestAvailableIsa());
+}
+
+void colorize(const cv::Mat &binary, cv::Mat &dst,
+              const cv::Vec3b &fg, const cv::Vec3b &bg, Isa isa)
+{
+    CV_Assert(binary.type() == CV_8UC1);
+
+    // No-op if dst already has the right size and type
+    dst.create(binary.size(), CV_8UC3);
+
+    if (!isIsaAvailable(isa)) {
+        isa = Isa::Scalar;
+    }
+
+    ColorPatterns patterns;
+    for (int k = 0; k < kPatternBytes; k++) {
+        patterns.bgPattern[k] = bg[k % 3];
+        patterns.diffPattern[k] = static_cast<uchar>(fg[k % 3] ^ bg[k % 3]);
+    }
+
+    const int width = binary.cols;
+
+    // Split the frame into horizontal bands, one per parallel stripe
+    cv::parallel_for_(cv::Range(0, binary.rows), [&](const cv::Range &rows) {
+        for (int y = rows.start; y < rows.end; y++) {
+            const uchar *src = binary.ptr<uchar>(y);
+            uchar *out = dst.ptr<uchar>(y);
+
+            int done = 0;
+#ifdef MONOCHROME_KERNEL_X86
+            if (isa == Isa::AVX2) {
+                done = colorizeRowAVX2(src, out, width, patterns);
+            } else if (isa == Isa::SSSE3) {
+                done = colorizeRowSSSE3(src, out, width, patterns);
+            }
+#endif
+            colorizeRowScalar(src, out, done, width, fg, bg);
+        }
+    });
+}
+
+void colorizeBgrx(const cv::Mat &binary, cv::Mat &dst,
+                  const cv::Vec3b &fg, const cv::Vec3b &bg)
+{
+    colorizeBgrx(binary, dst, fg, bg, bestAvailableIsa());
+}
+
+void colorizeBgrx(const cv::Mat &binary, cv::Mat &dst,
+                  const cv::Vec3b &fg, const cv::Vec3b &bg, Isa isa)
+{
+    CV_Assert(binary.type() == CV_8UC1);
+
+    // No-op if dst already has the right size and type, so a Mat wrapping
+    // a video frame keeps pointing at the frame
+    dst.create(binary.size(), CV_8UC4);
+
+    if (!isIsaAvailable(isa)) {
+        isa = Isa::Scalar;
+    }
+
+    const uint32_t fgPixel = packBgrx(fg);
+    const uint32_t bgPixel = packBgrx(bg);
+    const int width = binary.cols;
+
+    cv::parallel_for_(cv::Range(0, binary.rows), [&](const cv::Range &rows) {
+        for (int y = rows.start; y < rows.end; y++) {
+            const uchar *src = binary.ptr<uchar>(y);
+            uchar *out = dst.ptr<uchar>(y);
+
+            int done = 0;
+#ifdef MONOCHROME_KERNEL_X86
+            if (isa == Isa::AVX2) {
+                done = colorizeRowBgrxAVX2(src, out, width, fgPixel, bgPixel);
+            } else if (isa == Isa::SSSE3) {
+                done = colorizeRowBgrxSSSE3(src, out, width, fgPixel, bgPixel);
+            }
+#endif
+            colorizeRowBgrxScalar(src, out, done, width, fgPixel, bgPixel);
+        }
+    });
+}
+
+} // namespace MonochromeKernel
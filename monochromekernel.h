@@ -0,0 +1,61 @@
+/*
+ * monochromekernel.h - Binary to Two-Color Kernel Header
+ *
+ * Purpose: Paints a thresholded binary image into a 3-channel BGR image
+ * using a foreground and a background color. This is the per-frame
+ * colorization step of VideoProcessor::convertToMonochrome. A 4-channel
+ * variant writes straight into BGRX video frames for display.
+ *
+ * The kernel is vectorized for SSSE3 and AVX2 and picks the best
+ * instruction set at runtime; a scalar fallback is used everywhere else.
+ * Rows are processed in parallel with cv::parallel_for_.
+ */
+
+#ifndef MONOCHROMEKERNEL_H
+#define MONOCHROMEKERNEL_H
+
+#include <opencv2/core.hpp>
+
+namespace MonochromeKernel {
+
+// Instruction sets the kernel can run on
+enum class Isa {
+    Scalar,
+    SSSE3,
+    AVX2
+};
+
+// Get a printable name for an instruction set ("scalar", "ssse3", "avx2")
+const char *isaName(Isa isa);
+
+// Check if the CPU (and this build) can run the given instruction set
+bool isIsaAvailable(Isa isa);
+
+// Get the fastest instruction set available on this CPU
+Isa bestAvailableIsa();
+
+// Colorize a CV_8UC1 binary image into a CV_8UC3 BGR image.
+// Pixels greater than 128 get the foreground color, all others the
+// background color. dst is (re)allocated only if its size or type differ.
+void colorize(const cv::Mat &binary, cv::Mat &dst,
+              const cv::Vec3b &fg, const cv::Vec3b &bg);
+
+// Same as above, forcing a specific instruction set (used for benchmarks).
+// Falls back to the scalar kernel if the instruction set is unavailable.
+void colorize(const cv::Mat &binary, cv::Mat &dst,
+              const cv::Vec3b &fg, const cv::Vec3b &bg, Isa isa);
+
+// Colorize a CV_8UC1 binary image into a CV_8UC4 BGRX image (the fourth
+// byte is 255, so the result is also valid BGRA). dst may wrap external
+// memory, e.g. a mapped QVideoFrame: it is only reallocated if its size
+// or type differ.
+void colorizeBgrx(const cv::Mat &binary, cv::Mat &dst,
+                  const cv::Vec3b &fg, const cv::Vec3b &bg);
+
+// Same as above, forcing a specific instruction set
+void colorizeBgrx(const cv::Mat &binary, cv::Mat &dst,
+                  const cv::Vec3b &fg, const cv::Vec3b &bg, Isa isa);
+
+} // namespace MonochromeKernel
+
+#endif // MONOCHROMEKERNEL_H
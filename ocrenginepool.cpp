@@ -0,0 +1,702 @@
+/*
+ * ocrenginepool.cpp - OCR Engine Pool Implementation
+ *
+ * Purpose: Implements the Tesseract engine wrapper and the thread pool
+ * that runs several engines over the job queues of its sources
+ */
+
+#include "ocrenginepool.h"
+#include "textregions.h"
+#include "ocrprescale.h"
+#include "ocrmodel.h"
+#include "pipelinestats.h"
+#include <QDebug>
+#include <QStringList>
+#include <QFile>
+#include <QSet>
+#include <QPair>
+#include <QJsonObject>
+#include <QDateTime>
+#include <tesseract/ocrclass.h>
+#include <tesseract/resultiterator.h>
+#include <algorithm>
+#include <iterator>
+
+#ifdef VIDEOOCR_HAVE_OPENMP
+#include <omp.h>
+#endif
+
+// OCRWorker Implementation
+OCRWorker::OCRWorker()
+    : tessApi(nullptr)
+    , prescaleHeight(0)
+    , appliedScale(1.0)
+    , cancelled(false)
+{
+    // Initialize Tesseract API
+    tessApi = new tesseract::TessBaseAPI();
+
+    // Initialize with English language, from the traineddata loaded
+    // once for all engines (see OcrModel)
+    // Make sure tessdata folder exists in application directory
+    // or set TESSDATA_PREFIX environment variable
+    if (!OcrModel::shared("eng").initEngine(tessApi)) {
+        qWarning() << "Could not initialize Tesseract API";
+        qWarning() << "Make sure tessdata folder is in the application directory";
+        delete tessApi;
+        tessApi = nullptr;
+    } else {
+        // Set page segmentation mode for better OCR results
+        // PSM_AUTO: Fully automatic page segmentation
+        tessApi->SetPageSegMode(tesseract::PSM_AUTO);
+    }
+}
+
+OCRWorker::~OCRWorker()
+{
+    // Clean up Tesseract API
+    if (tessApi) {
+        tessApi->End();
+        delete tessApi;
+    }
+}
+
+QString OCRWorker::processOCR(const cv::Mat &image, bool useRegions, bool singleLine)
+{
+    QString result;
+
+    // Check if Tesseract is initialized
+    if (!tessApi) {
+        return "Error: Tesseract not initialized";
+    }
+
+    // Check if image is valid
+    if (image.empty()) {
+        return "Error: Invalid image";
+    }
+
+    cancelled = false;
+
+    try {
+        // Bring the text to the glyph height Tesseract reads best.
+        // input must outlive the recognition, Tesseract does not copy it
+        cv::Mat input = image;
+        sourceSize = image.size();
+        appliedScale = 1.0;
+        if (prescaleHeight > 0 && image.type() == CV_8UC1) {
+            ScopedStageTimer timer(PipelineStats::OcrPrescale);
+            appliedScale = OcrPrescale::prescale(image, input, prescaleHeight);
+        }
+
+        // Set the image for OCR processing
+        // Tesseract expects grayscale or color image
+        tessApi->SetImage(input.data, input.cols, input.rows,
+                          input.channels(), input.step);
+
+        // Find the text first, so that only those parts get recognized
+        std::vector<TextRegions::Region> regions;
+        if (useRegions && !singleLine && input.type() == CV_8UC1) {
+            ScopedStageTimer timer(PipelineStats::OcrRegions);
+            regions = TextRegions::propose(input);
+        }
+
+        if (singleLine) {
+            // A line found before (e.g. by text tracking): proposals would
+            // only reject it as too tall for a line of the image
+            tessApi->SetPageSegMode(tesseract::PSM_SINGLE_LINE);
+            result = recognizeText().simplified();
+        } else if (regions.empty()) {
+            // No usable proposals: fully automatic page segmentation in
+            // one pass, which keeps the context of the whole page. Its
+            // lines are reported once the page is recognized
+            tessApi->SetPageSegMode(tesseract::PSM_AUTO);
+            result = recognizeText();
+        } else {
+            // Proposals are mostly single lines; taller boxes are
+            // paragraphs that got merged and need block segmentation
+            std::vector<int> heights;
+            for (const TextRegions::Region &region : regions) {
+                heights.push_back(region.box.height);
+            }
+            std::nth_element(heights.begin(), heights.begin() + heights.size() / 2, heights.end());
+            const int medianHeight = heights[heights.size() / 2];
+
+            QStringList lines;
+            int currentLine = -1;
+
+            for (const TextRegions::Region &region : regions) {
+                if (cancelled) {
+                    break;
+                }
+
+                tessApi->SetPageSegMode(region.box.height > 2 * medianHeight
+                                            ? tesseract::PSM_SINGLE_BLOCK
+                                            : tesseract::PSM_SINGLE_LINE);
+                tessApi->SetRectangle(region.box.x, region.box.y,
+                                      region.box.width, region.box.height);
+
+                QString text = recognizeText().simplified();
+                if (text.isEmpty()) {
+                    continue;
+                }
+
+                // Boxes on the same reading line are joined with a space
+                if (region.line == currentLine && !lines.isEmpty()) {
+                    lines.last() += ' ' + text;
+                } else {
+                    lines.append(text);
+                    currentLine = region.line;
+                }
+            }
+
+            result = lines.join('\n');
+        }
+
+        if (cancelled) {
+            // Partial text is of no use to anyone, the caller decides
+            // what to report
+            result.clear();
+        } else if (result.trimmed().isEmpty()) {
+            result = OCREnginePool::kNoTextText;
+        }
+
+    } catch (const std::exception &e) {
+        result = QString("OCR Error: %1").arg(e.what());
+        qWarning() << result;
+    }
+
+    return result;
+}
+
+QString OCRWorker::recognizeText()
+{
+    QString text;
+    ScopedStageTimer timer(PipelineStats::OcrRecognize);
+
+    // Recognize under a monitor so that Tesseract polls the cancel check
+    // while it works through the words
+    ETEXT_DESC monitor;
+    monitor.cancel = &OCRWorker::cancelCallback;
+    monitor.cancel_this = this;
+    if (tessApi->Recognize(&monitor) != 0 || cancelled) {
+        return text;
+    }
+
+    // Walk the recognized lines: report each one, and collect the text
+    QStringList lines;
+    tesseract::ResultIterator *it = tessApi->GetIterator();
+    if (it && !it->Empty(tesseract::RIL_TEXTLINE)) {
+        do {
+            char *outText = it->GetUTF8Text(tesseract::RIL_TEXTLINE);
+            if (!outText) {
+                continue;
+            }
+            OcrLine line;
+            line.text = QString::fromUtf8(outText).trimmed();
+            delete[] outText;  // Free memory allocated by Tesseract
+            if (line.text.isEmpty()) {
+                continue;
+            }
+
+            int left = 0, top = 0, right = 0, bottom = 0;
+            it->BoundingBox(tesseract::RIL_TEXTLINE, &left, &top, &right, &bottom);
+            cv::Rect box = OcrPrescale::toSource(cv::Rect(left, top, right - left, bottom - top),
+                                                 appliedScale, sourceSize);
+            line.box = QRect(box.x, box.y, box.width, box.height);
+            line.confidence = it->Confidence(tesseract::RIL_TEXTLINE);
+
+            if (lineCallback) {
+                lineCallback(line);
+            }
+            lines.append(line.text);
+        } while (it->Next(tesseract::RIL_TEXTLINE));
+    }
+    delete it;
+
+    return lines.join('\n');
+}
+
+bool OCRWorker::cancelCallback(void *worker, int words)
+{
+    Q_UNUSED(words);
+
+    OCRWorker *self = static_cast<OCRWorker *>(worker);
+    if (!self->cancelled && self->cancelCheck && self->cancelCheck()) {
+        self->cancelled = true;
+    }
+    return self->cancelled;
+}
+
+// OCREnginePool Implementation
+const char *const OCREnginePool::kSupersededText = "Error: OCR superseded by a newer request";
+const char *const OCREnginePool::kDeadlineText = "Error: OCR deadline exceeded";
+const char *const OCREnginePool::kDroppedText = "Error: OCR dropped, too many requests from this source";
+const char *const OCREnginePool::kNoTextText = "No text recognized";
+
+bool OCREnginePool::isErrorResult(const QString &text)
+{
+    return text.startsWith("Error:") || text.startsWith("OCR Error:");
+}
+
+bool OCREnginePool::hasText(const QString &text)
+{
+    return !isErrorResult(text) && text != QLatin1String(kNoTextText) && !text.trimmed().isEmpty();
+}
+
+OCREnginePool::OCREnginePool(int engineCount, QObject *parent)
+    : QObject(parent)
+    , stopping(false)
+    , nextJobId(0)
+    , regionProposals(true)
+    , prescaleHeight(OcrPrescale::kDefaultGlyphHeight)
+    , deadlineMsecs(0)
+    , cancelledCount(0)
+{
+    // OcrLine travels through queued connections
+    qRegisterMetaType<OcrLine>();
+
+    const int cores = physicalCoreCount();
+
+    if (engineCount <= 0) {
+        engineCount = cores;
+    }
+
+    // Split the cores between the engines for Tesseract's OpenMP loops.
+    // With one engine per core every engine runs single-threaded.
+    const int ompThreads = std::max(1, cores / engineCount);
+
+    for (int i = 0; i < engineCount; i++) {
+        QThread *thread = QThread::create([this, ompThreads]() { engineLoop(ompThreads); });
+        thread->setObjectName(QString("OCR engine %1").arg(i));
+        engines.append(thread);
+        thread->start();
+    }
+}
+
+OCREnginePool::~OCREnginePool()
+{
+    // Wake every engine and let them exit once their current job is done
+    {
+        QMutexLocker locker(&queueMutex);
+        stopping = true;
+        for (auto &entry : sources) {
+            entry.second->queue.clear();
+        }
+    }
+    queueNotEmpty.wakeAll();
+
+    for (QThread *thread : engines) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+quint64 OCREnginePool::submit(const cv::Mat &image, bool interactive, int source, Layout layout,
+                              qint64 capturedMs)
+{
+    Source *state;
+    {
+        QMutexLocker locker(&queueMutex);
+        state = sourceLocked(source);
+    }
+
+    const quint64 id = nextJobId.fetch_add(1);
+    Job job{id, state, state->nextSequence.fetch_add(1), image, OCRResultCache::Key{0, 0},
+            false, PipelineStats::now(), interactive, 0, layout,
+            capturedMs >= 0 ? capturedMs : QDateTime::currentMSecsSinceEpoch()};
+    state->submitted.fetch_add(1, std::memory_order_relaxed);
+
+    std::vector<Job> removed;
+    std::vector<const char *> reasons;
+
+    if (interactive) {
+        // From now on, running interactive jobs of this source see that
+        // they are stale
+        state->latestInteractive.store(id);
+
+        // Queued ones are dropped right away
+        QMutexLocker locker(&queueMutex);
+        auto stale = std::stable_partition(state->queue.begin(), state->queue.end(),
+                                           [](const Job &queued) { return !queued.interactive; });
+        std::move(stale, state->queue.end(), std::back_inserter(removed));
+        state->queue.erase(stale, state->queue.end());
+        reasons.assign(removed.size(), kSupersededText);
+    }
+
+    // Binary images are looked up by content; a hit never reaches an engine
+    bool cached = false;
+    QString cachedText;
+    if (!image.empty() && image.type() == CV_8UC1) {
+        job.key = OCRResultCache::computeKey(image);
+        job.cacheable = true;
+
+        // A line is read differently than a page of the same pixels
+        if (layout == Layout::SingleLine) {
+            job.key.exact ^= 0x9e3779b97f4a7c15ULL;
+            job.key.perceptual ^= 0x9e3779b97f4a7c15ULL;
+        }
+        cached = cache.lookup(job.key, cachedText);
+    }
+
+    if (cached) {
+        // Still delivered through the reorder buffer, in order
+        deliver(job, cachedText, true);
+    } else {
+        QMutexLocker locker(&queueMutex);
+
+        // A source that was idle joins at the current virtual time of the
+        // busy ones, it does not get to spend the time it did not use
+        if (state->queue.empty() && state->running == 0) {
+            for (const auto &entry : sources) {
+                const Source *other = entry.second.get();
+                if (other != state && (!other->queue.empty() || other->running > 0)) {
+                    state->virtualTime = std::max(state->virtualTime, other->virtualTime);
+                }
+            }
+        }
+
+        // Bounded queue: the oldest automatic job makes room
+        const int maxQueued = state->policy.maxQueued;
+        if (maxQueued > 0 && int(state->queue.size()) >= maxQueued) {
+            auto oldest = std::find_if(state->queue.begin(), state->queue.end(),
+                                       [](const Job &queued) { return !queued.interactive; });
+            if (oldest != state->queue.end()) {
+                removed.push_back(std::move(*oldest));
+                reasons.push_back(kDroppedText);
+                state->queue.erase(oldest);
+            }
+        }
+
+        state->queue.push_back(std::move(job));
+    }
+    if (!cached) {
+        queueNotEmpty.wakeOne();
+    }
+
+    for (size_t i = 0; i < removed.size(); i++) {
+        reportCancelled(removed[i], reasons[i]);
+    }
+
+    return id;
+}
+
+void OCREnginePool::setSourcePolicy(int source, const SourcePolicy &policy)
+{
+    {
+        QMutexLocker locker(&queueMutex);
+        Source *state = sourceLocked(source);
+        state->policy = policy;
+        state->policy.priority = std::max(1, policy.priority);
+    }
+
+    // A raised engine limit may let a waiting job start
+    queueNotEmpty.wakeAll();
+}
+
+OCREnginePool::SourceStats OCREnginePool::sourceStats(int source) const
+{
+    SourceStats stats{};
+
+    QMutexLocker locker(&queueMutex);
+    auto it = sources.find(source);
+    if (it == sources.end()) {
+        return stats;
+    }
+
+    const Source *state = it->second.get();
+    stats.submitted = state->submitted.load(std::memory_order_relaxed);
+    stats.completed = state->completed.load(std::memory_order_relaxed);
+    stats.cancelled = state->cancelled.load(std::memory_order_relaxed);
+    stats.dropped = state->dropped.load(std::memory_order_relaxed);
+    stats.queued = int(state->queue.size());
+    stats.running = state->running;
+    stats.engineSeconds = state->engineNs.load(std::memory_order_relaxed) / 1e9;
+    stats.latency = state->latency.summary();
+    return stats;
+}
+
+QJsonObject OCREnginePool::sourceStatsJson(int source) const
+{
+    const SourceStats stats = sourceStats(source);
+    const double seconds = std::max(PipelineStats::instance().elapsedSeconds(), 1e-9);
+
+    SourcePolicy policy;
+    {
+        QMutexLocker locker(&queueMutex);
+        auto it = sources.find(source);
+        if (it != sources.end()) {
+            policy = it->second->policy;
+        }
+    }
+
+    QJsonObject json;
+    json["source"] = source;
+    json["priority"] = policy.priority;
+    json["max_running"] = policy.maxRunning;
+    json["max_queued"] = policy.maxQueued;
+    json["submitted"] = double(stats.submitted);
+    json["completed"] = double(stats.completed);
+    json["cancelled"] = double(stats.cancelled);
+    json["dropped"] = double(stats.dropped);
+    json["queued"] = stats.queued;
+    json["running"] = stats.running;
+    json["completed_per_s"] = stats.completed / seconds;
+    json["engine_s"] = stats.engineSeconds;
+    json["engine_share"] = stats.engineSeconds / (seconds * engineCount());
+    json["latency_mean_ms"] = stats.latency.mean / 1e6;
+    json["latency_p50_ms"] = stats.latency.p50 / 1e6;
+    json["latency_p90_ms"] = stats.latency.p90 / 1e6;
+    json["latency_p99_ms"] = stats.latency.p99 / 1e6;
+    json["latency_max_ms"] = stats.latency.max / 1e6;
+    return json;
+}
+
+OCREnginePool::Source *OCREnginePool::sourceLocked(int source)
+{
+    std::unique_ptr<Source> &state = sources[source];
+    if (!state) {
+        state.reset(new Source(source));
+    }
+    return state.get();
+}
+
+OCREnginePool::Source *OCREnginePool::nextSourceLocked() const
+{
+    // Least engine time for its priority first; ties go to the source
+    // with fewer running jobs
+    Source *best = nullptr;
+    for (const auto &entry : sources) {
+        Source *candidate = entry.second.get();
+        if (candidate->queue.empty()) {
+            continue;
+        }
+        if (candidate->policy.maxRunning > 0 && candidate->running >= candidate->policy.maxRunning) {
+            continue;
+        }
+        if (!best || candidate->virtualTime < best->virtualTime
+            || (candidate->virtualTime == best->virtualTime && candidate->running < best->running)) {
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+void OCREnginePool::setRegionProposals(bool enabled)
+{
+    // Results of the other mode must not be served from the cache
+    if (regionProposals.exchange(enabled) != enabled) {
+        cache.clear();
+    }
+}
+
+void OCREnginePool::setDeadline(int msecs)
+{
+    deadlineMsecs.store(std::max(0, msecs));
+}
+
+const char *OCREnginePool::cancelReason(const Job &job, qint64 deadlineNs) const
+{
+    if (job.interactive && job.source->latestInteractive.load() != job.id) {
+        return kSupersededText;
+    }
+    if (deadlineNs > 0 && PipelineStats::now() > deadlineNs) {
+        return kDeadlineText;
+    }
+    return nullptr;
+}
+
+void OCREnginePool::reportCancelled(const Job &job, const char *reason)
+{
+    if (reason == kDroppedText) {
+        job.source->dropped.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        cancelledCount.fetch_add(1, std::memory_order_relaxed);
+        job.source->cancelled.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    deliver(job, QString::fromLatin1(reason), false);
+}
+
+void OCREnginePool::deliver(const Job &job, const QString &text, bool recognized)
+{
+    Source *source = job.source;
+    quint64 sequence = job.sequence;
+    quint64 id = job.id;
+    qint64 submittedAt = job.submittedAt;
+    qint64 capturedMs = job.capturedMs;
+    QMetaObject::invokeMethod(this, [this, source, sequence, id, text, submittedAt, capturedMs,
+                                     recognized]() {
+        onJobFinished(source, sequence, id, text, submittedAt, capturedMs, recognized);
+    }, Qt::QueuedConnection);
+}
+
+void OCREnginePool::setPrescaleHeight(int pixels)
+{
+    // Results at another scale must not be served from the cache
+    if (prescaleHeight.exchange(pixels) != pixels) {
+        cache.clear();
+    }
+}
+
+void OCREnginePool::engineLoop(int ompThreads)
+{
+#ifdef VIDEOOCR_HAVE_OPENMP
+    // Applies to parallel regions started from this thread only
+    omp_set_num_threads(ompThreads);
+#else
+    Q_UNUSED(ompThreads);
+#endif
+
+    // The engine is created and used on this thread only
+    OCRWorker worker;
+
+    for (;;) {
+        Job job;
+        {
+            QMutexLocker locker(&queueMutex);
+            Source *source = nullptr;
+            while (!stopping && !(source = nextSourceLocked())) {
+                queueNotEmpty.wait(&queueMutex);
+            }
+            if (stopping) {
+                return;
+            }
+            job = std::move(source->queue.front());
+            source->queue.pop_front();
+
+            // Charge the expected cost now, so that the other engines see
+            // it while this job runs; corrected once it is done
+            job.charged = qint64(source->costEstimate);
+            source->virtualTime += source->costEstimate / source->policy.priority;
+            source->running++;
+        }
+
+        const qint64 startedAt = PipelineStats::now();
+        PipelineStats::instance().record(PipelineStats::OcrQueueWait,
+                                         quint64(startedAt - job.submittedAt));
+
+        // Jobs that went stale or ran out of time while queued are not
+        // started; running ones are stopped from Tesseract's monitor
+        const int deadline = deadlineMsecs.load();
+        const qint64 deadlineNs = deadline > 0 ? job.submittedAt + qint64(deadline) * 1000000 : 0;
+        if (const char *reason = cancelReason(job, deadlineNs)) {
+            {
+                QMutexLocker locker(&queueMutex);
+                job.source->running--;
+                job.source->virtualTime -= double(job.charged) / job.source->policy.priority;
+            }
+            queueNotEmpty.wakeOne();
+            reportCancelled(job, reason);
+            continue;
+        }
+        worker.setCancelCheck([this, &job, deadlineNs]() {
+            return cancelReason(job, deadlineNs) != nullptr;
+        });
+
+        // Lines go out right away, straight from this thread
+        bool firstLine = true;
+        worker.setLineCallback([this, &job, &firstLine](const OcrLine &line) {
+            if (firstLine) {
+                PipelineStats::instance().record(PipelineStats::OcrFirstLine,
+                                                 quint64(PipelineStats::now() - job.submittedAt));
+                firstLine = false;
+            }
+            emit ocrLine(job.source->id, job.id, line);
+        });
+
+        worker.setPrescaleHeight(prescaleHeight.load());
+        QString text = worker.processOCR(job.image, regionProposals.load(),
+                                         job.layout == Layout::SingleLine);
+        worker.setCancelCheck({});
+        worker.setLineCallback({});
+        const qint64 engineNs = PipelineStats::now() - startedAt;
+        PipelineStats::instance().record(PipelineStats::OcrEngine, quint64(engineNs));
+
+        // Charge the real engine time and let the next job of the source in
+        {
+            QMutexLocker locker(&queueMutex);
+            Source *source = job.source;
+            source->running--;
+            source->virtualTime += double(engineNs - job.charged) / source->policy.priority;
+            source->costEstimate = source->costEstimate > 0.0
+                                       ? 0.8 * source->costEstimate + 0.2 * engineNs
+                                       : double(engineNs);
+        }
+        job.source->engineNs.fetch_add(quint64(engineNs), std::memory_order_relaxed);
+        queueNotEmpty.wakeOne();
+
+        if (worker.wasCancelled()) {
+            const char *reason = cancelReason(job, deadlineNs);
+            reportCancelled(job, reason ? reason : kSupersededText);
+            continue;
+        }
+
+        // Remember real results only, errors may go away on a retry
+        if (job.cacheable && !isErrorResult(text)) {
+            cache.insert(job.key, text);
+        }
+
+        // Hand the result to the pool's thread for in-order delivery
+        deliver(job, text, true);
+    }
+}
+
+void OCREnginePool::onJobFinished(Source *source, quint64 sequence, quint64 jobId,
+                                  const QString &text, qint64 submittedAt, qint64 capturedMs,
+                                  bool recognized)
+{
+    const quint64 latency = quint64(PipelineStats::now() - submittedAt);
+    PipelineStats::instance().record(PipelineStats::OcrTotal, latency);
+
+    // Per source, only jobs that produced a result count
+    if (recognized) {
+        source->completed.fetch_add(1, std::memory_order_relaxed);
+        source->latency.record(latency);
+    }
+
+    source->finished[sequence] = Source::Finished{jobId, text, capturedMs};
+
+    // Release every result whose predecessors have all been reported
+    auto it = source->finished.begin();
+    while (it != source->finished.end() && it->first == source->nextToEmit) {
+        emit ocrComplete(source->id, it->second.jobId, it->second.text, it->second.capturedMs);
+        it = source->finished.erase(it);
+        source->nextToEmit++;
+    }
+}
+
+int OCREnginePool::physicalCoreCount()
+{
+    const int logical = std::max(1, QThread::idealThreadCount());
+
+#ifdef Q_OS_LINUX
+    // Count distinct (package, core) pairs, hyperthreads share a core id
+    QFile cpuinfo("/proc/cpuinfo");
+    if (cpuinfo.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QSet<QPair<int, int>> cores;
+        int physicalId = 0;
+
+        const QList<QByteArray> lines = cpuinfo.readAll().split('\n');
+        for (const QByteArray &line : lines) {
+            int colon = line.indexOf(':');
+            if (colon < 0) {
+                continue;
+            }
+            QByteArray key = line.left(colon).trimmed();
+            int value = line.mid(colon + 1).trimmed().toInt();
+
+            if (key == "physical id") {
+                physicalId = value;
+            } else if (key == "core id") {
+                cores.insert(qMakePair(physicalId, value));
+            }
+        }
+
+        if (!cores.isEmpty()) {
+            return std::min(logical, int(cores.size()));
+        }
+    }
+#endif
+
+    return logical;
+}
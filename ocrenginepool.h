@@ -0,0 +1,304 @@
+/*
+ * ocrenginepool.h - OCR Engine Pool Header
+ *
+ * Purpose: Runs several Tesseract engines in parallel, one per thread,
+ * shared by one or more capture sources (cameras):
+ * - Every submitted image gets a job ID and belongs to a source
+ * - Each source has its own queue; engines take the next job from the
+ *   source that has used the least engine time for its priority, so one
+ *   busy camera cannot starve the others. Sources can be limited in the
+ *   engines they occupy and the jobs they keep queued
+ * - Results are emitted in submission order per source, whichever engine
+ *   finishes first, and counted per source (throughput, latency)
+ * - Each text line is also reported on its own as soon as it is recognized
+ * - Tesseract's own OpenMP threads are capped so that the pool does not
+ *   oversubscribe the machine
+ * - Images recognized recently are answered from a result cache
+ * - Input is rescaled to a fixed glyph height first (see OcrPrescale), so
+ *   the OCR latency does not depend on the camera resolution
+ * - Interactive requests coalesce: a new one replaces older ones of the
+ *   same source that are still queued and cancels those already running
+ *   (through Tesseract's ETEXT_DESC monitor), and jobs can be given a
+ *   deadline
+ */
+
+#ifndef OCRENGINEPOOL_H
+#define OCRENGINEPOOL_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <opencv2/core.hpp>
+#include <tesseract/baseapi.h>
+#include <QJsonObject>
+#include "ocrresultcache.h"
+#include "ocrline.h"
+#include "pipelinestats.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+
+// One Tesseract engine. Not thread-safe: each pool thread owns its own
+class OCRWorker
+{
+public:
+    OCRWorker();
+    ~OCRWorker();
+
+    OCRWorker(const OCRWorker &) = delete;
+    OCRWorker &operator=(const OCRWorker &) = delete;
+
+    // Run OCR on the given image and return the recognized text,
+    // OCREnginePool::kNoTextText if there is none, or an error message.
+    // With useRegions, only proposed text regions of a binary image are
+    // recognized, one Tesseract pass per region. With singleLine, the
+    // image is one line of text, read in one pass without proposals
+    QString processOCR(const cv::Mat &image, bool useRegions = false, bool singleLine = false);
+
+    // Rescale binary input to this glyph height before recognition,
+    // 0 to recognize it at its own size (see OcrPrescale)
+    void setPrescaleHeight(int pixels) { prescaleHeight = pixels; }
+
+    // Factor the last image was scaled by; divide boxes found on the
+    // recognized image by it (OcrPrescale::toSource)
+    double lastScale() const { return appliedScale; }
+
+    // Polled while Tesseract recognizes; returning true stops the current
+    // processOCR early. Empty to never cancel
+    void setCancelCheck(std::function<bool()> check) { cancelCheck = std::move(check); }
+
+    // True if the last processOCR was stopped by the cancel check
+    bool wasCancelled() const { return cancelled; }
+
+    // Called from processOCR for every line as soon as it is recognized,
+    // in reading order: after each text region, or after the whole image
+    // without region proposals. Empty for no per-line reports
+    void setLineCallback(std::function<void(const OcrLine &)> callback) { lineCallback = std::move(callback); }
+
+private:
+    // Recognize the image/rectangle set on tessApi, report its lines and
+    // return its text
+    QString recognizeText();
+
+    // ETEXT_DESC cancel callback, asks cancelCheck
+    static bool cancelCallback(void *worker, int words);
+
+    tesseract::TessBaseAPI *tessApi;  // Tesseract OCR API instance
+    int prescaleHeight;               // Target glyph height, 0 = off
+    double appliedScale;              // Scale of the last processed image
+    cv::Size sourceSize;              // Size of the image before scaling
+    std::function<void(const OcrLine &)> lineCallback;  // Per-line reports
+    std::function<bool()> cancelCheck;  // Stop request, may be empty
+    bool cancelled;                   // Last processOCR was stopped
+};
+
+class OCREnginePool : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Create a pool of engineCount engines; 0 means one per physical core
+    explicit OCREnginePool(int engineCount = 0, QObject *parent = nullptr);
+    ~OCREnginePool();
+
+    // Number of engines (threads) in the pool
+    int engineCount() const { return engines.size(); }
+
+    // Result text of jobs that were replaced by a newer interactive job,
+    // of jobs that missed their deadline, and of jobs dropped because
+    // their source had too many queued
+    static const char *const kSupersededText;
+    static const char *const kDeadlineText;
+    static const char *const kDroppedText;
+
+    // Result text of jobs that found no text in their image
+    static const char *const kNoTextText;
+
+    // Check if a result reports a failure (including the texts above for
+    // replaced, late and dropped jobs) rather than what was read
+    static bool isErrorResult(const QString &text);
+
+    // Check if a result holds recognized text: neither an error nor
+    // kNoTextText
+    static bool hasText(const QString &text);
+
+    // What the image of a job shows
+    enum class Layout {
+        Page,        // Anything: region proposals or full page segmentation
+        SingleLine   // Exactly one line of text (e.g. a tracked region)
+    };
+
+    // How engines are shared with one capture source
+    struct SourcePolicy {
+        int priority = 1;    // Share of engine time relative to other sources
+        int maxRunning = 0;  // Engines the source may occupy at once, 0 = all
+        int maxQueued = 0;   // Queued jobs kept, 0 = no limit. Beyond it the
+                             // oldest non-interactive job is dropped
+    };
+
+    // Counters of one capture source
+    struct SourceStats {
+        quint64 submitted;    // Jobs submitted, including cache hits
+        quint64 completed;    // Jobs recognized (or answered from the cache)
+        quint64 cancelled;    // Superseded or past their deadline
+        quint64 dropped;      // Dropped from a full queue
+        int queued;           // Jobs waiting for an engine now
+        int running;          // Jobs on an engine now
+        double engineSeconds; // Engine time used
+        LatencyHistogram::Summary latency;  // Submitted -> result of completed jobs, in ns
+    };
+
+    // Queue an image for OCR and return its job ID. Thread-safe.
+    // The image is shared, not copied: do not modify it afterwards.
+    // An interactive job (e.g. F4) replaces all earlier interactive jobs
+    // of its source: queued ones are dropped and a running one is
+    // cancelled. Every job is still reported, replaced ones with
+    // kSupersededText. Sources need not be registered, an unknown source
+    // gets the default SourcePolicy. layout tells what the image shows,
+    // capturedMs when it was taken (ms since the epoch, -1 = now); both
+    // come back with the result.
+    quint64 submit(const cv::Mat &image, bool interactive = false, int source = 0,
+                   Layout layout = Layout::Page, qint64 capturedMs = -1);
+
+    // Set how a source shares the engines. Thread-safe
+    void setSourcePolicy(int source, const SourcePolicy &policy);
+
+    // Counters of a source (zero for a source that never submitted).
+    // Thread-safe
+    SourceStats sourceStats(int source) const;
+
+    // Counters of a source as JSON, with throughput and latency
+    // percentiles (in milliseconds). Thread-safe
+    QJsonObject sourceStatsJson(int source) const;
+
+    // Cancel jobs not finished within msecs of their submission, whether
+    // queued or running (reported with kDeadlineText). 0 = no deadline,
+    // the default. Thread-safe.
+    void setDeadline(int msecs);
+
+    // Jobs superseded or past their deadline so far
+    quint64 cancelledJobs() const { return cancelledCount.load(std::memory_order_relaxed); }
+
+    // Only send proposed text regions to Tesseract instead of the whole
+    // frame (see TextRegions). Enabled by default. Thread-safe.
+    void setRegionProposals(bool enabled);
+
+    // Glyph height the engines rescale input to, 0 to disable.
+    // Default OcrPrescale::kDefaultGlyphHeight. Thread-safe.
+    void setPrescaleHeight(int pixels);
+
+    // Cache of recent results, answered in submit() without an engine.
+    // Use it to change limits or read the hit/miss counters
+    OCRResultCache *resultCache() { return &cache; }
+
+    // Number of physical CPU cores (logical count if it cannot be told)
+    static int physicalCoreCount();
+
+signals:
+    // Signal: Emitted for every job, strictly in submission order within
+    // its source, with the capture time given to submit
+    void ocrComplete(int source, quint64 jobId, const QString &text, qint64 capturedMs);
+
+    // Signal: A line of a job was recognized (emitted from the engine
+    // thread, before the job's ocrComplete). Lines of one job come in
+    // reading order; jobs answered from the cache report no lines
+    void ocrLine(int source, quint64 jobId, const OcrLine &line);
+
+private:
+    struct Source;
+
+    // A queued OCR request
+    struct Job {
+        quint64 id;
+        Source *source;           // Owning source, lives as long as the pool
+        quint64 sequence;         // Submission order within the source
+        cv::Mat image;
+        OCRResultCache::Key key;  // Content key, valid if cacheable
+        bool cacheable;           // Store the result in the cache
+        qint64 submittedAt;       // PipelineStats::now() at submit
+        bool interactive;         // Replaced by newer interactive jobs
+        qint64 charged;           // Engine time charged when it was picked
+        Layout layout;            // Read as a page or as one line
+        qint64 capturedMs;        // When the image was taken, ms since the epoch
+    };
+
+    // Scheduling state, counters and reorder buffer of a capture source
+    struct Source {
+        explicit Source(int id) : id(id) {}
+
+        int id;
+
+        // Guarded by queueMutex
+        SourcePolicy policy;
+        std::deque<Job> queue;     // Jobs not picked up yet
+        int running = 0;           // Jobs on an engine
+        double virtualTime = 0.0;  // Engine ns used, divided by priority
+        double costEstimate = 0.0; // Recent engine ns per job
+
+        // Lock-free
+        std::atomic<quint64> nextSequence{0};
+        std::atomic<quint64> latestInteractive{0};  // ID of the newest interactive job
+        std::atomic<quint64> submitted{0};
+        std::atomic<quint64> completed{0};
+        std::atomic<quint64> cancelled{0};
+        std::atomic<quint64> dropped{0};
+        std::atomic<quint64> engineNs{0};
+        LatencyHistogram latency;  // Submitted -> result
+
+        // Reorder buffer, only touched in the pool's thread
+        quint64 nextToEmit = 0;                                     // Next sequence to report
+        struct Finished {
+            quint64 jobId;
+            QString text;
+            qint64 capturedMs;
+        };
+        std::map<quint64, Finished> finished;                       // Early results by sequence
+    };
+
+    // The state of a source, created on first use. Caller holds queueMutex
+    Source *sourceLocked(int source);
+
+    // Source whose next job an engine should run now, nullptr if none may
+    // run. Caller holds queueMutex
+    Source *nextSourceLocked() const;
+
+    // Why a job should stop now: nullptr to go on, else its result text
+    const char *cancelReason(const Job &job, qint64 deadlineNs) const;
+
+    // Report a job that will not be recognized
+    void reportCancelled(const Job &job, const char *reason);
+
+    // Body of each engine thread
+    void engineLoop(int ompThreads);
+
+    // Collect a finished job and emit everything of its source that is
+    // now in order (runs in the pool's own thread). recognized is false
+    // for cancelled and dropped jobs
+    void onJobFinished(Source *source, quint64 sequence, quint64 jobId, const QString &text,
+                       qint64 submittedAt, qint64 capturedMs, bool recognized);
+
+    // Hand a result to the pool's thread for in-order delivery
+    void deliver(const Job &job, const QString &text, bool recognized);
+
+    QList<QThread *> engines;         // One thread per Tesseract engine
+
+    // Per-source job queues
+    mutable QMutex queueMutex;        // Guards sources, their queues and stopping
+    QWaitCondition queueNotEmpty;     // Wakes idle engines
+    std::map<int, std::unique_ptr<Source>> sources;  // By source ID
+    bool stopping;                    // Set when the pool shuts down
+
+    std::atomic<quint64> nextJobId;   // ID for the next submitted job
+    std::atomic<bool> regionProposals;  // Recognize text regions only
+    std::atomic<int> prescaleHeight;    // Target glyph height, 0 = off
+    std::atomic<int> deadlineMsecs;     // Per-job deadline, 0 = none
+    std::atomic<quint64> cancelledCount;  // Jobs superseded or timed out
+    OCRResultCache cache;             // Results by image content
+};
+
+#endif // OCRENGINEPOOL_H
@@ -0,0 +1,24 @@
+/*
+ * ocrline.h - Recognized Text Line
+ *
+ * Purpose: One line of OCR output with its position and confidence,
+ * reported as soon as the line is recognized so that results can be
+ * shown while the rest of the frame is still being read
+ */
+
+#ifndef OCRLINE_H
+#define OCRLINE_H
+
+#include <QString>
+#include <QRect>
+#include <QMetaType>
+
+struct OcrLine {
+    QString text;            // Recognized text, without the line break
+    QRect box;               // Bounding box in source image coordinates
+    float confidence = 0.f;  // Tesseract's line confidence, 0..100
+};
+
+Q_DECLARE_METATYPE(OcrLine)
+
+#endif // OCRLINE_H
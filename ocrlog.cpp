@@ -0,0 +1,838 @@
+/*
+ * ocrlog.cpp - Persistent OCR Result Log Implementation
+ *
+ * Purpose: Implements the segment files and their word indexes
+ *
+ * A segment file (00000001.seg, ...) starts with a 64-byte header (magic,
+ * version, end of the last record, time span, record count, sources) and
+ * holds records back to back:
+ *   u32 length of the rest, i64 timestamp, i32 source, u32 line count,
+ *   per line: i32 x, y, width, height, f32 confidence, u32 UTF-8 length,
+ *   UTF-8 text
+ * The header is updated after each record, so a record torn by a crash is
+ * simply not part of the segment. The index of a full segment (.idx) has
+ * a 64-byte header, a table of words (64-bit hash, first posting, count)
+ * sorted by hash, and the postings (record offset, source, timestamp),
+ * sorted by offset per word. All numbers are little-endian.
+ *
+ * sources.json lists the registered sources (device ID and name); a
+ * record's source is the position in that list.
+ */
+
+#include "ocrlog.h"
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+const char kSegmentMagic[8] = {'V', 'O', 'C', 'R', 'S', 'E', 'G', '1'};
+const char kIndexMagic[8] = {'V', 'O', 'C', 'R', 'I', 'D', 'X', '1'};
+constexpr quint32 kVersion = 1;
+constexpr qint64 kHeaderBytes = 64;
+constexpr qint64 kWordEntryBytes = 16;
+constexpr qint64 kPostingBytes = 16;
+constexpr qint64 kRecordHeaderBytes = 20;  // Length, timestamp, source, lines
+constexpr qint64 kLineHeaderBytes = 24;    // Box, confidence, text length
+
+// Offsets are 32-bit, and a segment must hold at least a few records
+constexpr qint64 kMinSegmentBytes = 64 * 1024;
+constexpr qint64 kMaxSegmentBytes = qint64(1) << 31;
+
+template <typename T>
+void put(uchar *&p, T value)
+{
+    qToLittleEndian<T>(value, p);
+    p += sizeof(T);
+}
+
+template <typename T>
+T get(const uchar *&p)
+{
+    T value = qFromLittleEndian<T>(p);
+    p += sizeof(T);
+    return value;
+}
+
+quint32 floatBits(float value)
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float bitsFloat(quint32 bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// FNV-1a over the UTF-16 code units of a case-folded word
+quint64 wordHash(const QString &word)
+{
+    quint64 hash = 14695981039346656037ULL;
+    for (QChar c : word) {
+        hash = (hash ^ c.unicode()) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Bit of a source in a segment's source mask; sources from 63 on share one
+quint64 sourceBit(int source)
+{
+    return quint64(1) << std::clamp(source, 0, 63);
+}
+
+QString segmentName(int number, const char *suffix)
+{
+    return QString("%1.%2").arg(number, 8, 10, QChar('0')).arg(suffix);
+}
+
+// Check if words holds query as a consecutive run
+bool containsRun(const std::vector<QString> &words, const std::vector<QString> &query)
+{
+    return std::search(words.begin(), words.end(), query.begin(), query.end()) != words.end();
+}
+
+} // namespace
+
+// A record containing a word
+struct OCRLog::Posting {
+    quint32 offset;       // Record position in the segment file
+    qint32 source;
+    qint64 timestampMs;
+};
+
+// A segment file and its index. While open for appending, the file is
+// mapped at full capacity and the index is kept in words
+struct OCRLog::Segment {
+    int number = 0;
+    QFile file;
+    uchar *data = nullptr;       // Mapped segment, nullptr if unusable
+    qint64 capacity = 0;         // Bytes mapped
+    QFile indexFile;
+    const uchar *index = nullptr; // Mapped index of a sealed segment
+    qint64 indexBytes = 0;
+    quint32 wordCount = 0;       // Entries in the index's word table
+
+    quint64 used = kHeaderBytes; // End of the last record
+    qint64 firstMs = std::numeric_limits<qint64>::max();
+    qint64 lastMs = std::numeric_limits<qint64>::min();
+    quint64 records = 0;
+    quint64 sourceMask = 0;
+    bool sealed = false;
+
+    std::unordered_map<quint64, std::vector<Posting>> words;  // Open segment only
+
+    // Write the header fields that change with every record
+    void writeHeader()
+    {
+        uchar *p = data;
+        std::memcpy(p, kSegmentMagic, sizeof(kSegmentMagic));
+        p += sizeof(kSegmentMagic);
+        put<quint32>(p, kVersion);
+        put<quint32>(p, 0);
+        put<quint64>(p, used);
+        put<qint64>(p, firstMs);
+        put<qint64>(p, lastMs);
+        put<quint64>(p, records);
+        put<quint64>(p, sourceMask);
+    }
+
+    // Count a record in the time span, sources and word index
+    void indexRecord(quint32 offset, const Record &record)
+    {
+        firstMs = std::min(firstMs, record.timestampMs);
+        lastMs = std::max(lastMs, record.timestampMs);
+        records++;
+        sourceMask |= sourceBit(record.source);
+
+        std::vector<quint64> hashes;
+        for (const OcrLine &line : record.lines) {
+            for (const QString &word : OCRLog::words(line.text)) {
+                hashes.push_back(wordHash(word));
+            }
+        }
+        std::sort(hashes.begin(), hashes.end());
+        hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+        const Posting posting{offset, record.source, record.timestampMs};
+        for (quint64 hash : hashes) {
+            words[hash].push_back(posting);
+        }
+    }
+
+    void unmap()
+    {
+        if (data) {
+            file.unmap(data);
+            data = nullptr;
+        }
+        if (index) {
+            indexFile.unmap(const_cast<uchar *>(index));
+            index = nullptr;
+        }
+        file.close();
+        indexFile.close();
+    }
+
+    qint64 diskBytes() const
+    {
+        return qint64(used) + indexBytes;
+    }
+};
+
+namespace {
+
+// Decode the record at offset of a segment mapped up to end. Returns
+// false if it is incomplete or malformed; next is where the next one starts
+bool decodeRecord(const uchar *data, quint64 end, quint64 offset,
+                  OCRLog::Record &record, quint64 &next)
+{
+    if (offset + kRecordHeaderBytes > end) {
+        return false;
+    }
+    const uchar *p = data + offset;
+    const quint32 length = get<quint32>(p);
+    next = offset + 4 + length;
+    if (length < kRecordHeaderBytes - 4 || next > end) {
+        return false;
+    }
+
+    record.timestampMs = get<qint64>(p);
+    record.source = get<qint32>(p);
+    const quint32 lineCount = get<quint32>(p);
+    record.lines.clear();
+    record.lines.reserve(std::min<quint32>(lineCount, 256));
+
+    const uchar *recordEnd = data + next;
+    for (quint32 i = 0; i < lineCount; i++) {
+        if (recordEnd - p < kLineHeaderBytes) {
+            return false;
+        }
+        OcrLine line;
+        const qint32 x = get<qint32>(p);
+        const qint32 y = get<qint32>(p);
+        const qint32 width = get<qint32>(p);
+        const qint32 height = get<qint32>(p);
+        line.box = QRect(x, y, width, height);
+        line.confidence = bitsFloat(get<quint32>(p));
+        const quint32 textBytes = get<quint32>(p);
+        if (quint64(recordEnd - p) < textBytes) {
+            return false;
+        }
+        line.text = QString::fromUtf8(reinterpret_cast<const char *>(p), textBytes);
+        p += textBytes;
+        record.lines.push_back(line);
+    }
+    return true;
+}
+
+} // namespace
+
+OCRLog::OCRLog(qint64 segmentBytes, qint64 maxBytes)
+    : segmentBytes(std::clamp(segmentBytes, kMinSegmentBytes, kMaxSegmentBytes))
+    , maxBytes(std::max<qint64>(0, maxBytes))
+{
+}
+
+OCRLog::~OCRLog()
+{
+    close();
+}
+
+bool OCRLog::open(const QString &directory)
+{
+    close();
+
+    QMutexLocker locker(&mutex);
+
+    if (!QDir().mkpath(directory)) {
+        qWarning() << "Error: Could not create the OCR log folder" << directory;
+        return false;
+    }
+    this->directory = directory;
+
+    // Segments in the order they were written
+    std::vector<int> numbers;
+    const QStringList names = QDir(directory).entryList({"*.seg"}, QDir::Files, QDir::Name);
+    for (const QString &name : names) {
+        bool ok = false;
+        const int number = name.section('.', 0, 0).toInt(&ok);
+        if (ok && number > 0) {
+            numbers.push_back(number);
+        }
+    }
+    std::sort(numbers.begin(), numbers.end());
+
+    loadSources();
+
+    for (size_t i = 0; i < numbers.size(); i++) {
+        openSegment(numbers[i], i + 1 == numbers.size());
+    }
+
+    // Appending goes to an unsealed segment
+    if ((segments.empty() || segments.back()->sealed) && !startSegment()) {
+        for (auto &segment : segments) {
+            segment->unmap();
+        }
+        segments.clear();
+        return false;
+    }
+
+    enforceLimit();
+    return true;
+}
+
+void OCRLog::close()
+{
+    QMutexLocker locker(&mutex);
+
+    // The header of the open segment is current after every append, it
+    // carries on from there when the log is opened again
+    for (auto &segment : segments) {
+        segment->unmap();
+    }
+    segments.clear();
+    sources.clear();
+}
+
+bool OCRLog::isOpen() const
+{
+    QMutexLocker locker(&mutex);
+    return !segments.empty();
+}
+
+int OCRLog::sourceFor(const QString &identity, const QString &name)
+{
+    QMutexLocker locker(&mutex);
+
+    if (segments.empty()) {
+        qWarning() << "Error: The OCR log is not open";
+        return -1;
+    }
+
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (sources[i].identity == identity) {
+            if (sources[i].name != name) {
+                sources[i].name = name;
+                saveSources();
+            }
+            return int(i);
+        }
+    }
+
+    // A new source must be on disk before records refer to it
+    sources.push_back({identity, name});
+    if (!saveSources()) {
+        sources.pop_back();
+        return -1;
+    }
+    return int(sources.size() - 1);
+}
+
+QStringList OCRLog::sourceNames() const
+{
+    QMutexLocker locker(&mutex);
+
+    QStringList names;
+    for (const Source &source : sources) {
+        names.append(source.name);
+    }
+    return names;
+}
+
+void OCRLog::loadSources()
+{
+    sources.clear();
+
+    QFile file(QDir(directory).filePath("sources.json"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const QJsonArray entries = QJsonDocument::fromJson(file.readAll()).object()["sources"].toArray();
+    for (const QJsonValue &entry : entries) {
+        const QJsonObject object = entry.toObject();
+        sources.push_back({object["id"].toString(), object["name"].toString()});
+    }
+}
+
+bool OCRLog::saveSources()
+{
+    QJsonArray entries;
+    for (const Source &source : sources) {
+        QJsonObject object;
+        object["id"] = source.identity;
+        object["name"] = source.name;
+        entries.append(object);
+    }
+    QJsonObject json;
+    json["sources"] = entries;
+
+    QSaveFile file(QDir(directory).filePath("sources.json"));
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(QJsonDocument(json).toJson()) < 0
+        || !file.commit()) {
+        qWarning() << "Error: Could not write" << file.fileName();
+        return false;
+    }
+    return true;
+}
+
+bool OCRLog::openSegment(int number, bool last)
+{
+    std::unique_ptr<Segment> segment(new Segment);
+    segment->number = number;
+    const QDir dir(directory);
+    segment->file.setFileName(dir.filePath(segmentName(number, "seg")));
+    segment->indexFile.setFileName(dir.filePath(segmentName(number, "idx")));
+
+    // A sealed segment with its index: map both, read nothing
+    if (segment->indexFile.exists() && segment->file.open(QIODevice::ReadOnly)) {
+        const qint64 size = segment->file.size();
+        segment->data = size >= kHeaderBytes ? segment->file.map(0, size) : nullptr;
+
+        bool valid = false;
+        if (segment->data && std::memcmp(segment->data, kSegmentMagic, sizeof(kSegmentMagic)) == 0
+            && segment->indexFile.open(QIODevice::ReadOnly)) {
+            segment->indexBytes = segment->indexFile.size();
+            segment->index = segment->indexBytes >= kHeaderBytes
+                                 ? segment->indexFile.map(0, segment->indexBytes)
+                                 : nullptr;
+        }
+        if (segment->index && std::memcmp(segment->index, kIndexMagic, sizeof(kIndexMagic)) == 0) {
+            const uchar *p = segment->index + sizeof(kIndexMagic);
+            const quint32 version = get<quint32>(p);
+            segment->wordCount = get<quint32>(p);
+            const quint64 postingCount = get<quint64>(p);
+            segment->firstMs = get<qint64>(p);
+            segment->lastMs = get<qint64>(p);
+            segment->records = get<quint64>(p);
+            segment->sourceMask = get<quint64>(p);
+
+            const uchar *h = segment->data + sizeof(kSegmentMagic) + 8;
+            segment->used = get<quint64>(h);
+            segment->capacity = size;
+
+            valid = version == kVersion
+                    && segment->indexBytes == kHeaderBytes + segment->wordCount * kWordEntryBytes
+                                                  + qint64(postingCount) * kPostingBytes
+                    && segment->used >= quint64(kHeaderBytes) && segment->used <= quint64(size);
+        }
+
+        if (valid) {
+            segment->sealed = true;
+            segments.push_back(std::move(segment));
+            return true;
+        }
+
+        // Index it again below
+        qWarning() << "Error: OCR log index" << segment->indexFile.fileName()
+                   << "is damaged, rebuilding it";
+        segment->unmap();
+        segment->indexBytes = 0;
+        segment->wordCount = 0;
+    }
+
+    // Open for appending (or to index after a crash) at full capacity
+    if (!segment->file.open(QIODevice::ReadWrite)) {
+        qWarning() << "Error: Could not open OCR log segment" << segment->file.fileName();
+        return false;
+    }
+    const qint64 size = segment->file.size();
+    segment->capacity = std::max(size, segmentBytes);
+    if (size < segment->capacity && !segment->file.resize(segment->capacity)) {
+        qWarning() << "Error: Could not grow OCR log segment" << segment->file.fileName();
+        return false;
+    }
+    segment->data = segment->file.map(0, segment->capacity);
+    if (!segment->data) {
+        qWarning() << "Error: Could not map OCR log segment" << segment->file.fileName();
+        return false;
+    }
+
+    quint64 end = kHeaderBytes;
+    if (size >= kHeaderBytes && std::memcmp(segment->data, kSegmentMagic, sizeof(kSegmentMagic)) == 0) {
+        const uchar *h = segment->data + sizeof(kSegmentMagic) + 8;
+        end = std::min<quint64>(get<quint64>(h), quint64(segment->capacity));
+    } else if (size > 0) {
+        qWarning() << "Error:" << segment->file.fileName() << "is not an OCR log segment";
+        segment->unmap();
+        return false;
+    }
+
+    // Rebuild the index from the records, up to the first damaged one
+    quint64 offset = kHeaderBytes;
+    Record record;
+    quint64 next = 0;
+    while (offset < end && decodeRecord(segment->data, end, offset, record, next)) {
+        segment->indexRecord(quint32(offset), record);
+        offset = next;
+    }
+    segment->used = offset;
+    segment->writeHeader();
+
+    Segment &opened = *segment;
+    segments.push_back(std::move(segment));
+
+    // Only the newest segment is appended to, older ones were left
+    // unindexed by a crash
+    return last || sealSegment(opened);
+}
+
+bool OCRLog::startSegment()
+{
+    // After the newest one, and after files that could not be opened
+    const QDir dir(directory);
+    int number = segments.empty() ? 1 : segments.back()->number + 1;
+    while (dir.exists(segmentName(number, "seg"))) {
+        number++;
+    }
+
+    std::unique_ptr<Segment> segment(new Segment);
+    segment->number = number;
+    segment->file.setFileName(dir.filePath(segmentName(number, "seg")));
+    segment->indexFile.setFileName(dir.filePath(segmentName(number, "idx")));
+    QFile::remove(segment->indexFile.fileName());
+
+    if (!segment->file.open(QIODevice::ReadWrite | QIODevice::Truncate)
+        || !segment->file.resize(segmentBytes)) {
+        qWarning() << "Error: Could not create OCR log segment" << segment->file.fileName();
+        return false;
+    }
+    segment->capacity = segmentBytes;
+    segment->data = segment->file.map(0, segment->capacity);
+    if (!segment->data) {
+        qWarning() << "Error: Could not map OCR log segment" << segment->file.fileName();
+        segment->file.close();
+        segment->file.remove();
+        return false;
+    }
+    segment->writeHeader();
+
+    segments.push_back(std::move(segment));
+    return true;
+}
+
+bool OCRLog::sealSegment(Segment &segment)
+{
+    // Word table sorted by hash, postings of each word in record order
+    std::vector<quint64> hashes;
+    hashes.reserve(segment.words.size());
+    size_t postingCount = 0;
+    for (const auto &entry : segment.words) {
+        hashes.push_back(entry.first);
+        postingCount += entry.second.size();
+    }
+    std::sort(hashes.begin(), hashes.end());
+
+    QByteArray index(kHeaderBytes + qint64(hashes.size()) * kWordEntryBytes
+                         + qint64(postingCount) * kPostingBytes, '\0');
+    uchar *p = reinterpret_cast<uchar *>(index.data());
+    std::memcpy(p, kIndexMagic, sizeof(kIndexMagic));
+    p += sizeof(kIndexMagic);
+    put<quint32>(p, kVersion);
+    put<quint32>(p, quint32(hashes.size()));
+    put<quint64>(p, quint64(postingCount));
+    put<qint64>(p, segment.firstMs);
+    put<qint64>(p, segment.lastMs);
+    put<quint64>(p, segment.records);
+    put<quint64>(p, segment.sourceMask);
+
+    uchar *table = reinterpret_cast<uchar *>(index.data()) + kHeaderBytes;
+    uchar *posting = table + qint64(hashes.size()) * kWordEntryBytes;
+    quint32 first = 0;
+    for (quint64 hash : hashes) {
+        const std::vector<Posting> &list = segment.words[hash];
+        put<quint64>(table, hash);
+        put<quint32>(table, first);
+        put<quint32>(table, quint32(list.size()));
+        for (const Posting &entry : list) {
+            put<quint32>(posting, entry.offset);
+            put<qint32>(posting, entry.source);
+            put<qint64>(posting, entry.timestampMs);
+        }
+        first += quint32(list.size());
+    }
+
+    // The index appears complete or not at all
+    QSaveFile indexOut(segment.indexFile.fileName());
+    if (!indexOut.open(QIODevice::WriteOnly) || indexOut.write(index) != index.size()
+        || !indexOut.commit()) {
+        qWarning() << "Error: Could not write OCR log index" << segment.indexFile.fileName();
+        return false;
+    }
+
+    // Shrink the segment to its records and map both read-only
+    segment.unmap();
+    segment.words.clear();
+    segment.sealed = true;
+    segment.wordCount = quint32(hashes.size());
+    segment.indexBytes = index.size();
+    segment.capacity = qint64(segment.used);
+
+    if (!segment.file.resize(segment.capacity)
+        || !segment.file.open(QIODevice::ReadOnly)
+        || !(segment.data = segment.file.map(0, segment.capacity))
+        || !segment.indexFile.open(QIODevice::ReadOnly)
+        || !(segment.index = segment.indexFile.map(0, segment.indexBytes))) {
+        // Still on disk, it is searched again after the next open
+        qWarning() << "Error: Could not map OCR log segment" << segment.file.fileName();
+        segment.unmap();
+    }
+    return true;
+}
+
+void OCRLog::enforceLimit()
+{
+    if (maxBytes <= 0) {
+        return;
+    }
+
+    qint64 total = 0;
+    for (const auto &segment : segments) {
+        total += segment->diskBytes();
+    }
+
+    // The open segment is never deleted
+    while (total > maxBytes && segments.size() > 1) {
+        Segment &oldest = *segments.front();
+        total -= oldest.diskBytes();
+        oldest.unmap();
+        oldest.file.remove();
+        oldest.indexFile.remove();
+        segments.erase(segments.begin());
+    }
+}
+
+bool OCRLog::append(const Record &record)
+{
+    // Size of the record, lines without text left out
+    std::vector<QByteArray> texts;
+    std::vector<const OcrLine *> lines;
+    qint64 bytes = kRecordHeaderBytes;
+    for (const OcrLine &line : record.lines) {
+        if (line.text.trimmed().isEmpty()) {
+            continue;
+        }
+        texts.push_back(line.text.toUtf8());
+        lines.push_back(&line);
+        bytes += kLineHeaderBytes + texts.back().size();
+    }
+    if (lines.empty()) {
+        return true;
+    }
+
+    QMutexLocker locker(&mutex);
+
+    if (segments.empty()) {
+        qWarning() << "Error: The OCR log is not open";
+        return false;
+    }
+    if (bytes > segmentBytes - kHeaderBytes) {
+        qWarning() << "Error: OCR result of" << bytes << "bytes does not fit an OCR log segment";
+        return false;
+    }
+
+    // Start the next segment when this one is full (or was sealed, but
+    // the next one could not be started then)
+    Segment *last = segments.back().get();
+    if (last->sealed || qint64(last->used) + bytes > last->capacity) {
+        if ((!last->sealed && !sealSegment(*last)) || !startSegment()) {
+            return false;
+        }
+        enforceLimit();
+    }
+
+    Segment &segment = *segments.back();
+    const quint32 offset = quint32(segment.used);
+    uchar *p = segment.data + offset;
+    put<quint32>(p, quint32(bytes - 4));
+    put<qint64>(p, record.timestampMs);
+    put<qint32>(p, record.source);
+    put<quint32>(p, quint32(lines.size()));
+    for (size_t i = 0; i < lines.size(); i++) {
+        const QRect &box = lines[i]->box;
+        put<qint32>(p, box.x());
+        put<qint32>(p, box.y());
+        put<qint32>(p, box.width());
+        put<qint32>(p, box.height());
+        put<quint32>(p, floatBits(lines[i]->confidence));
+        put<quint32>(p, quint32(texts[i].size()));
+        std::memcpy(p, texts[i].constData(), texts[i].size());
+        p += texts[i].size();
+    }
+
+    // Index what was written, then publish it in the header
+    Record written;
+    written.source = record.source;
+    written.timestampMs = record.timestampMs;
+    for (const OcrLine *line : lines) {
+        written.lines.push_back(*line);
+    }
+    segment.indexRecord(offset, written);
+    segment.used += quint64(bytes);
+    segment.writeHeader();
+    return true;
+}
+
+std::vector<OCRLog::Posting> OCRLog::postings(const Segment &segment, quint64 word) const
+{
+    if (!segment.sealed) {
+        auto it = segment.words.find(word);
+        return it != segment.words.end() ? it->second : std::vector<Posting>();
+    }
+
+    // Binary search of the word table in the mapped index
+    const uchar *table = segment.index + kHeaderBytes;
+    quint32 low = 0;
+    quint32 high = segment.wordCount;
+    while (low < high) {
+        const quint32 middle = low + (high - low) / 2;
+        if (qFromLittleEndian<quint64>(table + qint64(middle) * kWordEntryBytes) < word) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == segment.wordCount
+        || qFromLittleEndian<quint64>(table + qint64(low) * kWordEntryBytes) != word) {
+        return {};
+    }
+
+    const uchar *entry = table + qint64(low) * kWordEntryBytes + 8;
+    const quint32 first = get<quint32>(entry);
+    const quint32 count = get<quint32>(entry);
+    const uchar *p = table + qint64(segment.wordCount) * kWordEntryBytes
+                     + qint64(first) * kPostingBytes;
+    if (p + qint64(count) * kPostingBytes > segment.index + segment.indexBytes) {
+        return {};
+    }
+
+    std::vector<Posting> list(count);
+    for (Posting &posting : list) {
+        posting.offset = get<quint32>(p);
+        posting.source = get<qint32>(p);
+        posting.timestampMs = get<qint64>(p);
+    }
+    return list;
+}
+
+OCRLog::Record OCRLog::readRecord(const Segment &segment, quint32 offset) const
+{
+    Record record;
+    quint64 next = 0;
+    if (!decodeRecord(segment.data, segment.used, offset, record, next)) {
+        record.lines.clear();
+    }
+    return record;
+}
+
+std::vector<OCRLog::Hit> OCRLog::find(const Query &query) const
+{
+    std::vector<Hit> hits;
+    const std::vector<QString> queryWords = words(query.text);
+    if (queryWords.empty() || query.limit <= 0) {
+        return hits;
+    }
+
+    std::vector<quint64> hashes;
+    for (const QString &word : queryWords) {
+        hashes.push_back(wordHash(word));
+    }
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+    auto wanted = [&](const Posting &posting) {
+        return (query.source < 0 || posting.source == query.source)
+               && posting.timestampMs >= query.fromMs && posting.timestampMs <= query.toMs;
+    };
+
+    QMutexLocker locker(&mutex);
+
+    for (const auto &entry : segments) {
+        const Segment &segment = *entry;
+        if (!segment.data || (segment.sealed && !segment.index) || segment.records == 0
+            || segment.lastMs < query.fromMs || segment.firstMs > query.toMs
+            || (query.source >= 0 && !(segment.sourceMask & sourceBit(query.source)))) {
+            continue;
+        }
+
+        // Records containing every word
+        std::vector<quint32> candidates;
+        bool first = true;
+        for (quint64 hash : hashes) {
+            std::vector<quint32> offsets;
+            for (const Posting &posting : postings(segment, hash)) {
+                if (wanted(posting)) {
+                    offsets.push_back(posting.offset);
+                }
+            }
+            if (first) {
+                candidates.swap(offsets);
+                first = false;
+            } else {
+                std::vector<quint32> both;
+                std::set_intersection(candidates.begin(), candidates.end(),
+                                      offsets.begin(), offsets.end(), std::back_inserter(both));
+                candidates.swap(both);
+            }
+            if (candidates.empty()) {
+                break;
+            }
+        }
+
+        // Lines holding the words in order (the hashes may also collide)
+        for (quint32 offset : candidates) {
+            const Record record = readRecord(segment, offset);
+            for (const OcrLine &line : record.lines) {
+                if (containsRun(words(line.text), queryWords)) {
+                    hits.push_back({record.source, record.timestampMs, line});
+                    if (int(hits.size()) >= query.limit) {
+                        return hits;
+                    }
+                }
+            }
+        }
+    }
+    return hits;
+}
+
+OCRLog::Stats OCRLog::stats() const
+{
+    QMutexLocker locker(&mutex);
+
+    Stats stats{int(segments.size()), 0, 0};
+    for (const auto &segment : segments) {
+        stats.records += segment->records;
+        stats.bytes += segment->diskBytes();
+    }
+    return stats;
+}
+
+std::vector<QString> OCRLog::words(const QString &text)
+{
+    std::vector<QString> result;
+    QString word;
+    for (QChar c : text) {
+        if (c.isLetterOrNumber()) {
+            word += c;
+        } else if (!word.isEmpty()) {
+            result.push_back(word.toCaseFolded());
+            word.clear();
+        }
+    }
+    if (!word.isEmpty()) {
+        result.push_back(word.toCaseFolded());
+    }
+    return result;
+}
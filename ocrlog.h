@@ -0,0 +1,157 @@
+/*
+ * ocrlog.h - Persistent OCR Result Log Header
+ *
+ * Purpose: Keeps every recognition on disk and finds text in it again:
+ * - Records (source, time, and the lines with their boxes, text and
+ *   confidence) are appended to segment files of fixed capacity, written
+ *   and read through memory maps
+ * - Each segment has an inverted index from word to the records that
+ *   contain it. The index of the segment being written lives in memory
+ *   and grows with every record; when the segment is full it is written
+ *   next to it as a sorted table, searched in place through a map
+ * - A query looks up its words in each segment whose time span and
+ *   sources can match, intersects the records and checks their lines
+ * - Sources are numbered by a stable identity (a camera's device ID),
+ *   kept in sources.json next to the segments, so records stay with
+ *   their camera when cameras are added, removed or reordered
+ *
+ * Only the index pages a query touches and the records it returns are
+ * read, so a search over weeks of recordings takes milliseconds and the
+ * log never has to fit in memory.
+ */
+
+#ifndef OCRLOG_H
+#define OCRLOG_H
+
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "ocrline.h"
+
+// All methods are thread-safe
+class OCRLog
+{
+public:
+    // One recognition
+    struct Record {
+        int source = 0;             // Source (camera) it came from, see sourceFor()
+        qint64 timestampMs = 0;     // Milliseconds since the epoch
+        std::vector<OcrLine> lines; // Boxes in the image sent to OCR; a
+                                    // negative confidence means unknown
+    };
+
+    // What to look for
+    struct Query {
+        QString text;               // Words that must appear in one line,
+                                    // in this order (case-insensitive)
+        int source = -1;            // Only this source, -1 = any
+        qint64 fromMs = 0;          // Time span searched, inclusive
+        qint64 toMs = std::numeric_limits<qint64>::max();
+        int limit = 1000;           // Hits returned at most
+    };
+
+    // A line matching a query
+    struct Hit {
+        int source;
+        qint64 timestampMs;
+        OcrLine line;
+    };
+
+    // Size of the log
+    struct Stats {
+        int segments;               // Segment files, including the open one
+        quint64 records;            // Records in all of them
+        qint64 bytes;               // Records and indexes on disk
+    };
+
+    // segmentBytes: capacity of a segment file. maxBytes: the oldest
+    // segments are deleted once the log is larger, 0 = keep everything
+    explicit OCRLog(qint64 segmentBytes = 64 * 1024 * 1024, qint64 maxBytes = 0);
+    ~OCRLog();
+
+    OCRLog(const OCRLog &) = delete;
+    OCRLog &operator=(const OCRLog &) = delete;
+
+    // Open (or create) the log in a directory and index what is not
+    // indexed yet. Returns false (after a warning) if it cannot be used
+    bool open(const QString &directory);
+
+    // Write everything out and unmap the segments
+    void close();
+
+    bool isOpen() const;
+
+    // Number of the source with the given stable identity in this log,
+    // registered under name on first use (the name is updated if it
+    // changed). Returns -1 (after a warning) if the log is not open or
+    // the source could not be saved
+    int sourceFor(const QString &identity, const QString &name);
+
+    // Names of the registered sources, by number
+    QStringList sourceNames() const;
+
+    // Append a recognition. Lines without text are left out, a record
+    // without any is not written. Returns false (after a warning) if the
+    // record could not be written
+    bool append(const Record &record);
+
+    // Lines matching a query, oldest first
+    std::vector<Hit> find(const Query &query) const;
+
+    Stats stats() const;
+
+    // Words of a text as they are indexed: runs of letters and digits,
+    // case-folded ("AB-1234x" -> "ab", "1234x")
+    static std::vector<QString> words(const QString &text);
+
+private:
+    struct Posting;
+    struct Segment;
+
+    // Map a segment and its index; the newest unindexed one stays open
+    // for appending. Caller holds mutex
+    bool openSegment(int number, bool last);
+
+    // Start an empty segment after the newest one. Caller holds mutex
+    bool startSegment();
+
+    // Write the index of the open segment, shrink the file to its
+    // records and map both read-only. Caller holds mutex
+    bool sealSegment(Segment &segment);
+
+    // Delete the oldest segments while the log is too large. Caller
+    // holds mutex
+    void enforceLimit();
+
+    // Read or write sources.json. Caller holds mutex
+    void loadSources();
+    bool saveSources();
+
+    // Postings of a word in a segment, sorted by record offset
+    std::vector<Posting> postings(const Segment &segment, quint64 word) const;
+
+    // Decode the record at offset of a segment
+    Record readRecord(const Segment &segment, quint32 offset) const;
+
+    QString directory;
+    qint64 segmentBytes;
+    qint64 maxBytes;
+
+    // A registered source
+    struct Source {
+        QString identity;
+        QString name;
+    };
+
+    mutable QMutex mutex;                          // Guards everything below
+    std::vector<std::unique_ptr<Segment>> segments; // Oldest first, the last
+                                                    // one is open for appending
+    std::vector<Source> sources;                   // By source number
+};
+
+#endif // OCRLOG_H
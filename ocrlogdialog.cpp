@@ -0,0 +1,173 @@
+/*
+ * ocrlogdialog.cpp - OCR Log Search Dialog Implementation
+ *
+ * Purpose: Implements the search dialog of the OCR log
+ */
+
+#include "ocrlogdialog.h"
+#include "ocrlog.h"
+#include <QApplication>
+#include <QClipboard>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHeaderView>
+
+#include <QHBoxLayout>
+
+namespace {
+
+// Hits shown at most; a search finding more should be narrowed down
+constexpr int kMaxHits = 1000;
+
+} // namespace
+
+OCRLogDialog::OCRLogDialog(const OCRLog *log, QWidget *parent)
+    : QDialog(parent)
+    , log(log)
+    , sourceNames(log->sourceNames())
+{
+    // Two cameras of the same model: tell them apart by number
+    const QStringList registered = sourceNames;
+    for (int i = 0; i < sourceNames.size(); i++) {
+        if (registered.count(registered[i]) > 1) {
+            sourceNames[i] += QString(" (%1)").arg(i + 1);
+        }
+    }
+
+    setupUI();
+}
+
+void OCRLogDialog::setupUI()
+{
+    // Set dialog properties
+    setWindowTitle("Search OCR Log");
+    resize(700, 450);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    // Query row: words, camera, period
+    QHBoxLayout *queryLayout = new QHBoxLayout();
+
+    queryEdit = new QLineEdit(this);
+    queryEdit->setPlaceholderText("Text to find, e.g. a part number");
+    connect(queryEdit, &QLineEdit::returnPressed, this, &OCRLogDialog::onSearchClicked);
+    queryLayout->addWidget(queryEdit, 1);
+
+    sourceCombo = new QComboBox(this);
+    sourceCombo->addItem("All cameras", -1);
+    for (int i = 0; i < sourceNames.size(); i++) {
+        sourceCombo->addItem(sourceNames[i], i);
+    }
+    sourceCombo->setVisible(sourceNames.size() > 1);
+    queryLayout->addWidget(sourceCombo);
+
+    // Period, in hours back from now (0 = everything)
+    periodCombo = new QComboBox(this);
+    periodCombo->addItem("Last hour", 1);
+    periodCombo->addItem("Last day", 24);
+    periodCombo->addItem("Last week", 24 * 7);
+    periodCombo->addItem("Everything", 0);
+    periodCombo->setCurrentIndex(3);
+    queryLayout->addWidget(periodCombo);
+
+    searchButton = new QPushButton("Search", this);
+    searchButton->setDefault(true);
+    connect(searchButton, &QPushButton::clicked, this, &OCRLogDialog::onSearchClicked);
+    queryLayout->addWidget(searchButton);
+
+    mainLayout->addLayout(queryLayout);
+
+    // Hits, oldest first
+    resultTree = new QTreeWidget(this);
+    resultTree->setHeaderLabels({"Time", "Camera", "Text", "Confidence"});
+    resultTree->setRootIsDecorated(false);
+    resultTree->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    resultTree->header()->setSectionResizeMode(2, QHeaderView::Stretch);
+    resultTree->header()->setStretchLastSection(false);
+    resultTree->setColumnHidden(1, sourceNames.size() <= 1);
+    mainLayout->addWidget(resultTree);
+
+    // Status label
+    statusLabel = new QLabel(this);
+    statusLabel->setStyleSheet("QLabel { color: gray; font-size: 10px; }");
+    mainLayout->addWidget(statusLabel);
+
+    // Create button layout
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+
+    copyButton = new QPushButton("Copy Selected", this);
+    copyButton->setToolTip("Copy the selected hits to clipboard");
+    connect(copyButton, &QPushButton::clicked, this, &OCRLogDialog::onCopyClicked);
+    buttonLayout->addWidget(copyButton);
+
+    buttonLayout->addStretch();
+
+    closeButton = new QPushButton("Close", this);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::close);
+    buttonLayout->addWidget(closeButton);
+
+    mainLayout->addLayout(buttonLayout);
+
+    setLayout(mainLayout);
+}
+
+void OCRLogDialog::onSearchClicked()
+{
+    OCRLog::Query query;
+    query.text = queryEdit->text();
+    query.source = sourceCombo->currentData().toInt();
+    query.limit = kMaxHits;
+
+    const int hours = periodCombo->currentData().toInt();
+    if (hours > 0) {
+        query.fromMs = QDateTime::currentMSecsSinceEpoch() - qint64(hours) * 3600 * 1000;
+    }
+
+    if (OCRLog::words(query.text).empty()) {
+        statusLabel->setText("Enter a word or number to search for");
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const std::vector<OCRLog::Hit> hits = log->find(query);
+    const double ms = timer.nsecsElapsed() / 1e6;
+
+    resultTree->clear();
+    QList<QTreeWidgetItem *> items;
+    for (const OCRLog::Hit &hit : hits) {
+        QTreeWidgetItem *item = new QTreeWidgetItem();
+        item->setText(0, QDateTime::fromMSecsSinceEpoch(hit.timestampMs).toString("yyyy-MM-dd hh:mm:ss"));
+        item->setText(1, sourceNames.value(hit.source, QString("Source %1").arg(hit.source)));
+        item->setText(2, hit.line.text);
+        // Results answered from the cache have no line confidence
+        item->setText(3, hit.line.confidence >= 0.f
+                             ? QString("%1%").arg(hit.line.confidence, 0, 'f', 0)
+                             : QString("-"));
+        items.append(item);
+    }
+    resultTree->addTopLevelItems(items);
+    resultTree->resizeColumnToContents(0);
+
+    QString status = QString("%1 hits in %2 ms").arg(hits.size()).arg(ms, 0, 'f', 1);
+    if (int(hits.size()) >= kMaxHits) {
+        status += QString(" (first %1 shown, narrow the search)").arg(kMaxHits);
+    }
+    statusLabel->setText(status);
+}
+
+void OCRLogDialog::onCopyClicked()
+{
+    QStringList rows;
+    for (QTreeWidgetItem *item : resultTree->selectedItems()) {
+        rows.append(item->text(0) + '\t' + item->text(1) + '\t' + item->text(2));
+    }
+
+    if (rows.isEmpty()) {
+        statusLabel->setText("Select hits to copy");
+        return;
+    }
+
+    QApplication::clipboard()->setText(rows.join('\n'));
+    statusLabel->setText(QString("%1 hits copied to clipboard").arg(rows.size()));
+}
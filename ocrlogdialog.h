@@ -0,0 +1,57 @@
+/*
+ * ocrlogdialog.h - OCR Log Search Dialog Header
+ *
+ * Purpose: Dialog window for searching the persistent OCR log
+ * Finds the lines in which some text was read, by camera and time span,
+ * with when and how confidently each was recognized
+ */
+
+#ifndef OCRLOGDIALOG_H
+#define OCRLOGDIALOG_H
+
+#include <QDialog>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+#include <QLabel>
+#include <QStringList>
+
+class OCRLog;
+
+class OCRLogDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    // Constructor: search log, with its cameras named as registered in
+    // it. The log must outlive the dialog
+    explicit OCRLogDialog(const OCRLog *log, QWidget *parent = nullptr);
+
+private slots:
+    // Slot: Run the search and show its hits
+    void onSearchClicked();
+
+    // Slot: Copy the text of the selected hits to the clipboard
+    void onCopyClicked();
+
+private:
+    // Setup the user interface
+    void setupUI();
+
+    const OCRLog *log;
+    QStringList sourceNames;          // By source number in the log
+
+    // UI Components
+    QLineEdit *queryEdit;             // Words to find
+    QComboBox *sourceCombo;           // Camera to search, or all
+    QComboBox *periodCombo;           // How far back to search
+    QPushButton *searchButton;        // Run the search
+    QTreeWidget *resultTree;          // One hit per row
+    QPushButton *copyButton;          // Copy selected hits
+    QPushButton *closeButton;         // Close dialog button
+    QLabel *statusLabel;              // Hit count and search time
+};
+
+#endif // OCRLOGDIALOG_H
@@ -0,0 +1,184 @@
+/*
+ * ocrmodel.cpp - Shared Tesseract Model Implementation
+ *
+ * Purpose: Implements the traineddata lookup and mapping, engine
+ * initialization from memory and the resident memory measurement
+ */
+
+#include "ocrmodel.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QDebug>
+#include <tesseract/baseapi.h>
+#include <map>
+#include <memory>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+OcrModel &OcrModel::shared(const QString &language)
+{
+    static QMutex modelsMutex;
+    static std::map<QString, std::unique_ptr<OcrModel>> models;
+
+    QMutexLocker locker(&modelsMutex);
+    std::unique_ptr<OcrModel> &model = models[language];
+    if (!model) {
+        model.reset(new OcrModel(language));
+    }
+    return *model;
+}
+
+OcrModel::OcrModel(const QString &language)
+    : language(language)
+    , data(nullptr)
+    , dataSize(0)
+    , measured(false)
+    , engineCost(-1)
+{
+    QString path = findTrainedData();
+    if (path.isEmpty()) {
+        qWarning() << "Could not find" << language + ".traineddata,"
+                   << "engines will load it on their own";
+        return;
+    }
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open" << path;
+        return;
+    }
+
+    // Map the file read-only: all engines read the same pages, and pages
+    // not needed after initialization can be dropped by the OS
+    dataSize = file.size();
+    data = file.map(0, dataSize);
+    if (!data) {
+        fallbackBuffer = file.readAll();
+        data = reinterpret_cast<const uchar *>(fallbackBuffer.constData());
+        dataSize = fallbackBuffer.size();
+    }
+}
+
+QString OcrModel::findTrainedData() const
+{
+    const QString name = language + ".traineddata";
+
+    // Same places the README tells users to put the file, in the order
+    // Tesseract itself would look
+    QStringList directories;
+    const QString prefix = qEnvironmentVariable("TESSDATA_PREFIX");
+    if (!prefix.isEmpty()) {
+        directories << prefix << QDir(prefix).filePath("tessdata");
+    }
+    if (QCoreApplication::instance()) {
+        directories << QDir(QCoreApplication::applicationDirPath()).filePath("tessdata");
+    }
+    directories << QDir::current().filePath("tessdata");
+#ifdef Q_OS_WIN
+    directories << "C:/Program Files/Tesseract-OCR/tessdata";
+#else
+    directories << "/usr/share/tesseract-ocr/5/tessdata"
+                << "/usr/share/tesseract-ocr/4.00/tessdata"
+                << "/usr/share/tessdata"
+                << "/usr/local/share/tessdata"
+                << "/opt/homebrew/share/tessdata";
+#endif
+
+    for (const QString &directory : directories) {
+        QFileInfo info(QDir(directory).filePath(name));
+        if (info.isFile()) {
+            return info.absoluteFilePath();
+        }
+    }
+    return QString();
+}
+
+bool OcrModel::initEngine(tesseract::TessBaseAPI *api)
+{
+    // Only the first engine is measured, alone so that no other engine
+    // grows the process meanwhile; the rest start in parallel. Private
+    // memory leaves out the pages of the mapped file the engine faults
+    // in, which all engines share
+    QMutexLocker measureLocker(&measureMutex);
+    const bool measure = !measured;
+    if (!measure) {
+        measureLocker.unlock();
+    }
+
+    const QByteArray lang = language.toUtf8();
+    const qint64 before = measure ? privateBytes() : -1;
+
+    int status;
+    if (data) {
+        // Tesseract takes the traineddata content instead of a file
+        status = api->Init(reinterpret_cast<const char *>(data), int(dataSize), lang.constData(),
+                           tesseract::OEM_DEFAULT, nullptr, 0, nullptr, nullptr, false, nullptr);
+    } else {
+        status = api->Init(nullptr, lang.constData());
+    }
+
+    if (status != 0) {
+        return false;
+    }
+
+    if (measure) {
+        measured = true;
+        const qint64 after = privateBytes();
+        if (before >= 0 && after >= 0) {
+            QMutexLocker locker(&mutex);
+            engineCost = after - before;
+        }
+    }
+    return true;
+}
+
+qint64 OcrModel::engineBytes() const
+{
+    QMutexLocker locker(&mutex);
+    return engineCost;
+}
+
+QJsonObject OcrModel::toJson() const
+{
+    QJsonObject json;
+    json["language"] = language;
+    json["path"] = isLoaded() ? path() : QString();
+    json["shared_bytes"] = double(isLoaded() ? dataSize : 0);
+    json["engine_bytes"] = double(engineBytes());
+    json["resident_bytes"] = double(residentBytes());
+    return json;
+}
+
+qint64 OcrModel::residentBytes()
+{
+#ifdef Q_OS_LINUX
+    // Second field of statm: resident pages
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1) {
+            return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+        }
+    }
+#endif
+    return -1;
+}
+
+qint64 OcrModel::privateBytes()
+{
+#ifdef Q_OS_LINUX
+    // statm: resident pages minus the file-backed (shared) ones
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 2) {
+            return (fields[1].toLongLong() - fields[2].toLongLong()) * sysconf(_SC_PAGESIZE);
+        }
+    }
+#endif
+    return -1;
+}
@@ -0,0 +1,84 @@
+/*
+ * ocrmodel.h - Shared Tesseract Model Header
+ *
+ * Purpose: Loads a language's traineddata file once per process, memory
+ * mapped, and initializes every Tesseract engine from that memory instead
+ * of having each engine find and read the file on its own.
+ *
+ * Tesseract still unpacks the model into each engine's private data
+ * structures, so engines do not share the parsed network. What is shared
+ * is the file itself (one mapping, one read from disk), and the private
+ * memory the first engine initialization adds is measured so the real
+ * per-engine cost is known when sizing the pool.
+ */
+
+#ifndef OCRMODEL_H
+#define OCRMODEL_H
+
+#include <QString>
+#include <QFile>
+#include <QMutex>
+#include <QJsonObject>
+
+namespace tesseract {
+class TessBaseAPI;
+}
+
+class OcrModel
+{
+public:
+    // The process-wide model of the given language, loaded on first use.
+    // Thread-safe
+    static OcrModel &shared(const QString &language = "eng");
+
+    explicit OcrModel(const QString &language);
+
+    OcrModel(const OcrModel &) = delete;
+    OcrModel &operator=(const OcrModel &) = delete;
+
+    // True if the traineddata file was found and mapped
+    bool isLoaded() const { return data != nullptr; }
+
+    // Path and size of the loaded traineddata file
+    QString path() const { return file.fileName(); }
+    qint64 size() const { return dataSize; }
+
+    // Initialize an engine for this language: from the shared memory if
+    // the model is loaded, else through Tesseract's own file lookup.
+    // The first initialization runs alone so that the private memory it
+    // adds can be measured; the others wait for it and then run in
+    // parallel. Returns false if Tesseract failed. Thread-safe
+    bool initEngine(tesseract::TessBaseAPI *api);
+
+    // Private memory added by the first successful initEngine, in bytes;
+    // -1 before it and where it cannot be measured. Pages of the mapped
+    // file are shared by all engines and not part of it. Thread-safe
+    qint64 engineBytes() const;
+
+    // Model path, size and per-engine memory as JSON. Thread-safe
+    QJsonObject toJson() const;
+
+    // Resident set size of the process in bytes, -1 if unknown
+    static qint64 residentBytes();
+
+    // Resident memory of the process that is not backed by a file (heap,
+    // stacks), in bytes, -1 if unknown
+    static qint64 privateBytes();
+
+private:
+    // Find <language>.traineddata in the usual tessdata locations
+    QString findTrainedData() const;
+
+    QString language;
+    QFile file;                  // The traineddata file, kept open for the mapping
+    const uchar *data;           // Mapped (or read) file content, null if not loaded
+    qint64 dataSize;
+    QByteArray fallbackBuffer;   // File content if mapping is not supported
+
+    QMutex measureMutex;         // Held by the measured initEngine
+    bool measured;               // An engine was measured, guarded by measureMutex
+    mutable QMutex mutex;        // Guards engineCost
+    qint64 engineCost;           // Private bytes added by the measured engine, -1 = unknown
+};
+
+#endif // OCRMODEL_H
@@ -0,0 +1,51 @@
+/*
+ * ocrpreprocess.cpp - OCR Preprocessing Implementation
+ *
+ * Purpose: Implements the fused luma to Tesseract binary conversion
+ */
+
+#include "ocrpreprocess.h"
+#include <opencv2/imgproc.hpp>
+
+namespace OcrPreprocess {
+
+namespace {
+
+// Same weights as cv::COLOR_BGR2GRAY
+int lumaOf(const cv::Vec3b &bgr)
+{
+    return (bgr[0] * 114 + bgr[1] * 587 + bgr[2] * 299) / 1000;
+}
+
+} // namespace
+
+bool isLightText(const cv::Vec3b &fg, const cv::Vec3b &bg)
+{
+    return lumaOf(fg) > lumaOf(bg);
+}
+
+void binarize(const cv::Mat &luma, cv::Mat &binary, bool lightText,
+              ThresholdMethod method)
+{
+    CV_Assert(luma.type() == CV_8UC1);
+
+    if (method != ThresholdMethod::Otsu) {
+        // One binarizer per thread keeps its integral images across calls
+        thread_local AdaptiveBinarizer binarizer;
+        binarizer.setMethod(method);
+        binarizer.apply(luma, binary, lightText);
+
+        // apply() marks the brighter class, which is the text here
+        if (lightText) {
+            cv::bitwise_not(binary, binary);
+        }
+        return;
+    }
+
+    // Light text is above the Otsu threshold: invert it so that it ends up
+    // dark. Dark text is already below the threshold and stays dark.
+    int type = lightText ? cv::THRESH_BINARY_INV : cv::THRESH_BINARY;
+    cv::threshold(luma, binary, 128, 255, type | cv::THRESH_OTSU);
+}
+
+} // namespace OcrPreprocess
@@ -0,0 +1,37 @@
+/*
+ * ocrpreprocess.h - OCR Preprocessing Header
+ *
+ * Purpose: Turns a luma image into the binary image handed to Tesseract
+ * in a single thresholding pass. Colorization with the scheme colors is
+ * only needed for display and is not part of this path.
+ *
+ * Tesseract works best on dark text over a light background. The color
+ * scheme tells us the polarity of the text being read: light-on-dark
+ * schemes (White/Green/Yellow on Black) get inverted, dark-on-light
+ * schemes (Black on White) are kept as they are.
+ *
+ * The threshold is global Otsu by default, or a local adaptive one (see
+ * AdaptiveBinarizer) for unevenly lit captures.
+ */
+
+#ifndef OCRPREPROCESS_H
+#define OCRPREPROCESS_H
+
+#include <opencv2/core.hpp>
+#include "adaptivebinarizer.h"
+
+namespace OcrPreprocess {
+
+// Check if the scheme describes light text on a dark background
+// (colors in BGR order, compared by luma)
+bool isLightText(const cv::Vec3b &fg, const cv::Vec3b &bg);
+
+// Threshold a CV_8UC1 luma image straight into a 0/255 binary with dark
+// text on a light background. binary is reallocated only if needed.
+// Adaptive methods reuse per-thread buffers, so this is thread-safe.
+void binarize(const cv::Mat &luma, cv::Mat &binary, bool lightText,
+              ThresholdMethod method = ThresholdMethod::Otsu);
+
+} // namespace OcrPreprocess
+
+#endif // OCRPREPROCESS_H
@@ -0,0 +1,122 @@
+/*
+ * ocrprescale.cpp - OCR Input Rescaling Implementation
+ *
+ * Purpose: Implements the connected component glyph height estimate and
+ * the resize towards the target height
+ */
+
+#include "ocrprescale.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace OcrPrescale {
+
+namespace {
+
+// Components needed before the median means anything
+const int kMinComponents = 5;
+
+// Scales this close to 1 are not worth a resize
+const double kTolerance = 1.25;
+
+// Limits of the scale factor
+const double kMinScale = 0.25;
+const double kMaxScale = 4.0;
+
+} // namespace
+
+int estimateGlyphHeight(const cv::Mat &binary)
+{
+    CV_Assert(binary.type() == CV_8UC1);
+    if (binary.empty()) {
+        return 0;
+    }
+
+    // Text pixels are dark; connected components wants them non-zero.
+    // Scratch buffers per thread, OCR runs on several engines at once
+    thread_local cv::Mat text;
+    thread_local cv::Mat labels;
+    thread_local cv::Mat stats;
+    thread_local cv::Mat centroids;
+    cv::bitwise_not(binary, text);
+    const int count = cv::connectedComponentsWithStats(text, labels, stats, centroids, 8, CV_32S);
+
+    std::vector<int> heights;
+    const int maxHeight = std::max(4, binary.rows / 4);
+    for (int i = 1; i < count; i++) {  // Label 0 is the background
+        const int width = stats.at<int>(i, cv::CC_STAT_WIDTH);
+        const int height = stats.at<int>(i, cv::CC_STAT_HEIGHT);
+        const int area = stats.at<int>(i, cv::CC_STAT_AREA);
+
+        // Skip specks, rules and underlines, solid blocks and frames
+        if (height < 4 || height > maxHeight || area < 8) {
+            continue;
+        }
+        if (width > 3 * height) {
+            continue;
+        }
+        const double fill = double(area) / (double(width) * height);
+        if (fill < 0.1 || fill > 0.95) {
+            continue;
+        }
+        heights.push_back(height);
+    }
+
+    if (int(heights.size()) < kMinComponents) {
+        return 0;
+    }
+
+    std::nth_element(heights.begin(), heights.begin() + heights.size() / 2, heights.end());
+    return heights[heights.size() / 2];
+}
+
+double scaleFor(int glyphHeight, int targetHeight)
+{
+    if (glyphHeight <= 0 || targetHeight <= 0) {
+        return 1.0;
+    }
+
+    const double scale = std::clamp(double(targetHeight) / glyphHeight, kMinScale, kMaxScale);
+    if (scale < kTolerance && scale > 1.0 / kTolerance) {
+        return 1.0;
+    }
+    return scale;
+}
+
+double prescale(const cv::Mat &binary, cv::Mat &scaled, int targetHeight)
+{
+    const double scale = scaleFor(estimateGlyphHeight(binary), targetHeight);
+    if (scale == 1.0) {
+        scaled = binary;
+        return 1.0;
+    }
+
+    const cv::Size size(std::max(1, int(std::lround(binary.cols * scale))),
+                        std::max(1, int(std::lround(binary.rows * scale))));
+
+    // Area averaging when shrinking, smooth edges when enlarging; the
+    // threshold afterwards makes the result binary again
+    cv::resize(binary, scaled, size, 0, 0, scale < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR);
+    cv::threshold(scaled, scaled, 127, 255, cv::THRESH_BINARY);
+
+    // The factor actually applied, after rounding the size
+    return double(size.width) / binary.cols;
+}
+
+cv::Rect toSource(const cv::Rect &box, double scale, const cv::Size &sourceSize)
+{
+    if (scale == 1.0) {
+        return box & cv::Rect(cv::Point(0, 0), sourceSize);
+    }
+
+    // Round outwards so the source box covers the whole scaled one
+    const int x0 = int(std::floor(box.x / scale));
+    const int y0 = int(std::floor(box.y / scale));
+    const int x1 = int(std::ceil((box.x + box.width) / scale));
+    const int y1 = int(std::ceil((box.y + box.height) / scale));
+    return cv::Rect(x0, y0, x1 - x0, y1 - y0) & cv::Rect(cv::Point(0, 0), sourceSize);
+}
+
+} // namespace OcrPrescale
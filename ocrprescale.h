@@ -0,0 +1,48 @@
+/*
+ * ocrprescale.h - OCR Input Rescaling Header
+ *
+ * Purpose: Resizes the binary OCR input so that its text has the glyph
+ * height Tesseract reads best, whatever the camera resolution:
+ * - The dominant glyph height is the median height of the glyph-like
+ *   connected components of the text pixels
+ * - The image is scaled so that this height becomes the target height
+ * - Boxes found on the scaled image map back to source coordinates
+ *
+ * Downscaling 4K input with large text keeps Tesseract's runtime in
+ * check; upscaling small text from low resolution cameras brings it
+ * into the range where recognition is reliable.
+ */
+
+#ifndef OCRPRESCALE_H
+#define OCRPRESCALE_H
+
+#include <opencv2/core.hpp>
+
+namespace OcrPrescale {
+
+// Glyph height (pixels) that input is scaled to by default. Components
+// mix x-height and cap height; ~30 px puts lower case letters at the
+// 20 px x-height where Tesseract's accuracy levels off
+constexpr int kDefaultGlyphHeight = 30;
+
+// Median height of the glyph-like connected components of a CV_8UC1
+// binary with dark text on a light background (see OcrPreprocess).
+// Returns 0 if there are too few components to tell.
+int estimateGlyphHeight(const cv::Mat &binary);
+
+// Factor that brings glyphHeight to targetHeight, limited to [1/4, 4].
+// Returns 1 if the height is unknown or already close to the target.
+double scaleFor(int glyphHeight, int targetHeight = kDefaultGlyphHeight);
+
+// Scale a binary OCR image towards targetHeight. scaled is the resized
+// image (still binary), or shares binary's data if no scaling is needed.
+// Returns the factor applied: scaled size = binary size * factor.
+double prescale(const cv::Mat &binary, cv::Mat &scaled,
+                int targetHeight = kDefaultGlyphHeight);
+
+// Map a box on the scaled image back to the source image
+cv::Rect toSource(const cv::Rect &box, double scale, const cv::Size &sourceSize);
+
+} // namespace OcrPrescale
+
+#endif // OCRPRESCALE_H
@@ -0,0 +1,175 @@
+/*
+ * ocrresultcache.cpp - OCR Result Cache Implementation
+ *
+ * Purpose: Implements the content hashes and the LRU result store
+ */
+
+#include "ocrresultcache.h"
+#include <QMutexLocker>
+#include <opencv2/imgproc.hpp>
+#include <bitset>
+#include <cstring>
+
+namespace {
+
+// Multiply-xorshift step; fast, and good enough to tell frames apart
+inline quint64 mix(quint64 hash, quint64 value)
+{
+    hash = (hash ^ value) * 0x9E3779B97F4A7C15ULL;
+    return hash ^ (hash >> 32);
+}
+
+// Fixed bookkeeping cost per entry (list node, hash node, QString header)
+const qint64 kEntryOverhead = 96;
+
+} // namespace
+
+OCRResultCache::OCRResultCache(qint64 maxBytes, int maxEntries)
+    : maxBytes(maxBytes)
+    , maxEntries(maxEntries)
+    , perceptualTolerance(-1)
+    , usedBytes(0)
+    , hitCount(0)
+    , perceptualHitCount(0)
+    , missCount(0)
+{
+}
+
+OCRResultCache::Key OCRResultCache::computeKey(const cv::Mat &binary)
+{
+    CV_Assert(binary.type() == CV_8UC1);
+
+    Key key;
+
+    // Exact hash, 8 bytes at a time; the size is part of the content
+    quint64 hash = mix(0xCBF29CE484222325ULL, (quint64(binary.rows) << 32) | quint64(binary.cols));
+    for (int y = 0; y < binary.rows; y++) {
+        const uchar *row = binary.ptr<uchar>(y);
+        int x = 0;
+        for (; x + 8 <= binary.cols; x += 8) {
+            quint64 word;
+            std::memcpy(&word, row + x, sizeof(word));
+            hash = mix(hash, word);
+        }
+        quint64 tail = 0;
+        std::memcpy(&tail, row + x, binary.cols - x);
+        hash = mix(hash, tail);
+    }
+    key.exact = hash;
+
+    // dHash: is each cell of a 9x8 thumbnail brighter than its right
+    // neighbour? Stable under noise and small shifts
+    cv::Mat thumbnail;
+    cv::resize(binary, thumbnail, cv::Size(9, 8), 0, 0, cv::INTER_AREA);
+    quint64 bits = 0;
+    for (int y = 0; y < 8; y++) {
+        const uchar *row = thumbnail.ptr<uchar>(y);
+        for (int x = 0; x < 8; x++) {
+            bits = (bits << 1) | (row[x] > row[x + 1] ? 1 : 0);
+        }
+    }
+    key.perceptual = bits;
+
+    return key;
+}
+
+bool OCRResultCache::lookup(const Key &key, QString &text)
+{
+    QMutexLocker locker(&mutex);
+
+    auto found = index.find(key.exact);
+    EntryList::iterator entry = entries.end();
+
+    if (found != index.end()) {
+        entry = found.value();
+    } else if (perceptualTolerance >= 0) {
+        // Near match: closest dHash within the tolerance
+        int bestDistance = perceptualTolerance + 1;
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            int distance = int(std::bitset<64>(it->key.perceptual ^ key.perceptual).count());
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                entry = it;
+            }
+        }
+        if (entry != entries.end()) {
+            perceptualHitCount++;
+        }
+    }
+
+    if (entry == entries.end()) {
+        missCount++;
+        return false;
+    }
+
+    // Move to the front: most recently used
+    entries.splice(entries.begin(), entries, entry);
+    hitCount++;
+    text = entry->text;
+    return true;
+}
+
+void OCRResultCache::insert(const Key &key, const QString &text)
+{
+    QMutexLocker locker(&mutex);
+
+    auto found = index.find(key.exact);
+    if (found != index.end()) {
+        // Same content recognized twice (e.g. two jobs in flight)
+        usedBytes -= found.value()->bytes;
+        entries.erase(found.value());
+        index.erase(found);
+    }
+
+    qint64 bytes = kEntryOverhead + text.size() * qint64(sizeof(QChar));
+    entries.push_front(Entry{key, text, bytes});
+    index.insert(key.exact, entries.begin());
+    usedBytes += bytes;
+
+    evict();
+}
+
+void OCRResultCache::clear()
+{
+    QMutexLocker locker(&mutex);
+    entries.clear();
+    index.clear();
+    usedBytes = 0;
+}
+
+void OCRResultCache::setLimits(qint64 bytes, int count)
+{
+    QMutexLocker locker(&mutex);
+    maxBytes = bytes;
+    maxEntries = count;
+    evict();
+}
+
+void OCRResultCache::setPerceptualTolerance(int bits)
+{
+    QMutexLocker locker(&mutex);
+    perceptualTolerance = bits;
+}
+
+OCRResultCache::Stats OCRResultCache::stats() const
+{
+    QMutexLocker locker(&mutex);
+
+    Stats result;
+    result.hits = hitCount;
+    result.perceptualHits = perceptualHitCount;
+    result.misses = missCount;
+    result.entries = int(entries.size());
+    result.bytes = usedBytes;
+    return result;
+}
+
+void OCRResultCache::evict()
+{
+    while (!entries.empty() && (usedBytes > maxBytes || int(entries.size()) > maxEntries)) {
+        const Entry &oldest = entries.back();
+        usedBytes -= oldest.bytes;
+        index.remove(oldest.key.exact);
+        entries.pop_back();
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * ocrresultcache.h - OCR Result Cache Header
+ *
+ * Purpose: Remembers recent OCR results by the content of the binary
+ * image that was recognized, so that OCR'ing the same screen again
+ * returns instantly without running Tesseract:
+ * - Exact match: 64-bit hash of all pixels (and the image size)
+ * - Optional near match: 64-bit difference hash (dHash) within a
+ *   Hamming distance tolerance, for frames that differ only by noise
+ * - Least recently used eviction under an entry and memory bound
+ */
+
+#ifndef OCRRESULTCACHE_H
+#define OCRRESULTCACHE_H
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <opencv2/core.hpp>
+#include <list>
+
+class OCRResultCache
+{
+public:
+    // Content keys of a binary image
+    struct Key {
+        quint64 exact;       // Hash of every pixel
+        quint64 perceptual;  // 8x8 difference hash
+    };
+
+    // Hit/miss counters and current usage
+    struct Stats {
+        quint64 hits;            // Lookups answered (exact or near)
+        quint64 perceptualHits;  // Of which by near match
+        quint64 misses;          // Lookups that had to run OCR
+        int entries;             // Results currently cached
+        qint64 bytes;            // Approximate memory used
+    };
+
+    // maxBytes: memory bound for cached results, maxEntries: entry bound
+    explicit OCRResultCache(qint64 maxBytes = 4 * 1024 * 1024, int maxEntries = 256);
+
+    // Compute the keys of a CV_8UC1 image (one pass over the pixels)
+    static Key computeKey(const cv::Mat &binary);
+
+    // Look up a result; counts a hit or a miss. Thread-safe.
+    bool lookup(const Key &key, QString &text);
+
+    // Store a result, evicting the least recently used ones. Thread-safe.
+    void insert(const Key &key, const QString &text);
+
+    // Drop all results (e.g. when the OCR settings change). Thread-safe.
+    void clear();
+
+    // Configuration. A tolerance below 0 disables near matches (default)
+    void setLimits(qint64 maxBytes, int maxEntries);
+    void setPerceptualTolerance(int bits);
+
+    // Snapshot of the counters. Thread-safe.
+    Stats stats() const;
+
+private:
+    struct Entry {
+        Key key;
+        QString text;
+        qint64 bytes;
+    };
+    using EntryList = std::list<Entry>;
+
+    // Remove least recently used entries until within limits (locked)
+    void evict();
+
+    mutable QMutex mutex;                       // Guards everything below
+    EntryList entries;                          // Most recently used first
+    QHash<quint64, EntryList::iterator> index;  // Exact hash -> entry
+    qint64 maxBytes;
+    int maxEntries;
+    int perceptualTolerance;
+    qint64 usedBytes;
+    quint64 hitCount;
+    quint64 perceptualHitCount;
+    quint64 missCount;
+};
+
+#endif // OCRRESULTCACHE_H
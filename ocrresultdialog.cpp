@@ -13,6 +13,8 @@
 
 OCRResultDialog::OCRResultDialog(QWidget *parent)
     : QDialog(parent)
+    , lineCount(0)
+    , confidenceSum(0.0)
 {
     setupUI();
 }
@@ -81,6 +83,32 @@ void OCRResultDialog::setOCRText(const QString &text)
     textEdit->setPlainText(text);
 
     // Update status label with character count
+    updateCounts();
+}
+
+void OCRResultDialog::beginOCRLines()
+{
+    textEdit->clear();
+    lineCount = 0;
+    confidenceSum = 0.0;
+    statusLabel->setText("Recognizing...");
+}
+
+void OCRResultDialog::appendOCRLine(const OcrLine &line)
+{
+    // Each line becomes a paragraph of its own
+    textEdit->append(line.text);
+
+    lineCount++;
+    confidenceSum += line.confidence;
+    statusLabel->setText(QString("Recognizing... %1 lines so far (confidence %2%)")
+                             .arg(lineCount)
+                             .arg(confidenceSum / lineCount, 0, 'f', 0));
+}
+
+void OCRResultDialog::updateCounts()
+{
+    const QString text = textEdit->toPlainText();
     int charCount = text.length();
     int wordCount = text.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts).count();
 
@@ -113,12 +141,7 @@ void OCRResultDialog::onCopyClicked()
 
     // Create a timer to clear the status message after 3 seconds
     QTimer::singleShot(3000, this, [this]() {
-        int charCount = textEdit->toPlainText().length();
-        int wordCount = textEdit->toPlainText().split(QRegularExpression("\\s+"),
-                                                      Qt::SkipEmptyParts).count();
-        statusLabel->setText(QString("Characters: %1 | Words: %2")
-                                 .arg(charCount)
-                                 .arg(wordCount));
+        updateCounts();
     });
 }
 
@@ -2,7 +2,8 @@
  * ocrresultdialog.h - OCR Result Dialog Header
  *
  * Purpose: Dialog window for displaying OCR recognition results
- * Shows the extracted text from the captured video frame
+ * Shows the extracted text from the captured video frame, filled in line
+ * by line while recognition is still running
  */
 
 #ifndef OCRRESULTDIALOG_H
@@ -14,6 +15,7 @@
 #include <QVBoxLayout>
 #include <QLabel>
 #include <QClipboard>
+#include "ocrline.h"
 
 class OCRResultDialog : public QDialog
 {
@@ -23,9 +25,15 @@ public:
     // Constructor
     explicit OCRResultDialog(QWidget *parent = nullptr);
 
-    // Set the OCR result text to display
+    // Set the OCR result text to display (the complete result)
     void setOCRText(const QString &text);
 
+    // Start showing a new result that arrives line by line
+    void beginOCRLines();
+
+    // Append one recognized line of the result begun with beginOCRLines
+    void appendOCRLine(const OcrLine &line);
+
     // Get the current displayed text
     QString getOCRText() const;
 
@@ -43,12 +51,19 @@ private:
     // Setup the user interface
     void setupUI();
 
+    // Show character and word counts of the current text
+    void updateCounts();
+
     // UI Components
     QTextEdit *textEdit;              // Text display area
     QPushButton *copyButton;          // Copy to clipboard button
     QPushButton *clearButton;         // Clear text button
     QPushButton *closeButton;         // Close dialog button
     QLabel *statusLabel;              // Status information
+
+    // Lines received since beginOCRLines
+    int lineCount;
+    double confidenceSum;
 };
 
 #endif // OCRRESULTDIALOG_H
@@ -0,0 +1,213 @@
+/*
+ * pipelinestats.cpp - Pipeline Latency Statistics Implementation
+ *
+ * Purpose: Implements the log-linear histogram, percentile queries and
+ * the text/JSON reports
+ */
+
+#include "pipelinestats.h"
+#include <QtAlgorithms>
+#include <algorithm>
+
+// LatencyHistogram Implementation
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+int LatencyHistogram::bucketIndex(quint64 value)
+{
+    // Small values get one bucket each
+    if (value < quint64(kSubBuckets)) {
+        return int(value);
+    }
+
+    int exponent = 63 - int(qCountLeadingZeroBits(value));
+    if (exponent > kMaxExponent) {
+        return kBucketCount - 1;
+    }
+
+    // The top kSubBucketBits bits below the leading one pick the bucket
+    int sub = int(value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+    return (exponent - kSubBucketBits + 1) * kSubBuckets + sub;
+}
+
+quint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < kSubBuckets) {
+        return quint64(index);
+    }
+
+    int exponent = index / kSubBuckets + kSubBucketBits - 1;
+    int sub = index % kSubBuckets;
+    int shift = exponent - kSubBucketBits;
+    quint64 lower = quint64(kSubBuckets + sub) << shift;
+    return lower + (quint64(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(quint64 nanoseconds)
+{
+    buckets[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    quint64 previous = max.load(std::memory_order_relaxed);
+    while (nanoseconds > previous
+           && !max.compare_exchange_weak(previous, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const
+{
+    // Work on a snapshot so the percentiles agree with one total
+    quint64 snapshot[kBucketCount];
+    quint64 total = 0;
+    for (int i = 0; i < kBucketCount; i++) {
+        snapshot[i] = buckets[i].load(std::memory_order_relaxed);
+        total += snapshot[i];
+    }
+
+    Summary result;
+    result.count = total;
+    result.max = max.load(std::memory_order_relaxed);
+    result.mean = total > 0 ? double(sum.load(std::memory_order_relaxed)) / total : 0.0;
+
+    // Value at or below which the given fraction of values lies
+    auto percentile = [&](double fraction) -> quint64 {
+        if (total == 0) {
+            return 0;
+        }
+        quint64 rank = std::max<quint64>(1, quint64(fraction * total + 0.5));
+        quint64 seen = 0;
+        for (int i = 0; i < kBucketCount; i++) {
+            seen += snapshot[i];
+            if (seen >= rank) {
+                return std::min(bucketUpperBound(i), result.max);
+            }
+        }
+        return result.max;
+    };
+
+    result.p50 = percentile(0.50);
+    result.p90 = percentile(0.90);
+    result.p99 = percentile(0.99);
+    result.p999 = percentile(0.999);
+    return result;
+}
+
+void LatencyHistogram::reset()
+{
+    for (std::atomic<quint64> &bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+// PipelineStats Implementation
+PipelineStats::PipelineStats()
+    : startTime(now())
+{
+}
+
+PipelineStats &PipelineStats::instance()
+{
+    static PipelineStats stats;
+    return stats;
+}
+
+const char *PipelineStats::stageName(Stage stage)
+{
+    switch (stage) {
+    case FrameWait:     return "frame_wait";
+    case Ingest:        return "ingest";
+    case ToImage:       return "to_image";
+    case SceneDetect:   return "scene_detect";
+    case TextTrack:     return "text_track";
+    case Threshold:     return "threshold";
+    case Colorize:      return "colorize";
+    case FrameTotal:    return "frame_total";
+    case CaptureFusion: return "capture_fusion";
+    case OcrPreprocess: return "ocr_preprocess";
+    case OcrQueueWait:  return "ocr_queue_wait";
+    case OcrPrescale:   return "ocr_prescale";
+    case OcrRegions:    return "ocr_regions";
+    case OcrRecognize:  return "ocr_recognize";
+    case OcrEngine:     return "ocr_engine";
+    case OcrFirstLine:  return "ocr_first_line";
+    case OcrTotal:      return "ocr_total";
+    case StageCount:    break;
+    }
+    return "unknown";
+}
+
+double PipelineStats::elapsedSeconds() const
+{
+    return (now() - startTime.load(std::memory_order_relaxed)) / 1e9;
+}
+
+QString PipelineStats::toText() const
+{
+    const double seconds = std::max(elapsedSeconds(), 1e-9);
+
+    QString text = QString("%1 %2 %3 %4 %5 %6 %7\n")
+                       .arg(QString("stage"), -15)
+                       .arg(QString("count"), 8)
+                       .arg(QString("rate/s"), 8)
+                       .arg(QString("p50 ms"), 9)
+                       .arg(QString("p90 ms"), 9)
+                       .arg(QString("p99 ms"), 9)
+                       .arg(QString("max ms"), 9);
+
+    for (int i = 0; i < StageCount; i++) {
+        LatencyHistogram::Summary s = histograms[i].summary();
+        if (s.count == 0) {
+            continue;
+        }
+        text += QString("%1 %2 %3 %4 %5 %6 %7\n")
+                    .arg(QString(stageName(Stage(i))), -15)
+                    .arg(s.count, 8)
+                    .arg(s.count / seconds, 8, 'f', 1)
+                    .arg(s.p50 / 1e6, 9, 'f', 3)
+                    .arg(s.p90 / 1e6, 9, 'f', 3)
+                    .arg(s.p99 / 1e6, 9, 'f', 3)
+                    .arg(s.max / 1e6, 9, 'f', 3);
+    }
+
+    return text;
+}
+
+QJsonObject PipelineStats::toJson() const
+{
+    const double seconds = std::max(elapsedSeconds(), 1e-9);
+
+    QJsonObject stages;
+    for (int i = 0; i < StageCount; i++) {
+        LatencyHistogram::Summary s = histograms[i].summary();
+
+        QJsonObject stage;
+        stage["count"] = double(s.count);
+        stage["rate_per_s"] = s.count / seconds;
+        stage["mean_us"] = s.mean / 1e3;
+        stage["p50_us"] = s.p50 / 1e3;
+        stage["p90_us"] = s.p90 / 1e3;
+        stage["p99_us"] = s.p99 / 1e3;
+        stage["p999_us"] = s.p999 / 1e3;
+        stage["max_us"] = s.max / 1e3;
+        stages[stageName(Stage(i))] = stage;
+    }
+
+    QJsonObject json;
+    json["elapsed_s"] = seconds;
+    json["stages"] = stages;
+    return json;
+}
+
+void PipelineStats::reset()
+{
+    for (LatencyHistogram &histogram : histograms) {
+        histogram.reset();
+    }
+    startTime.store(now(), std::memory_order_relaxed);
+}
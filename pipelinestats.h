@@ -0,0 +1,153 @@
+/*
+ * pipelinestats.h - Pipeline Latency Statistics Header
+ *
+ * Purpose: Low-overhead instrumentation of the frame and OCR pipeline:
+ * - One latency histogram per pipeline stage (ingest, threshold, OCR, ...)
+ * - HDR-style log-linear buckets: ~6% resolution from 1 ns to hours
+ * - Recording is lock-free (relaxed atomic adds), safe from any thread
+ * - Percentiles, throughput and a JSON dump computed on demand
+ */
+
+#ifndef PIPELINESTATS_H
+#define PIPELINESTATS_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <chrono>
+
+// Latency histogram with log-linear buckets. Each power of two range is
+// split into kSubBuckets linear buckets, so the relative error of any
+// reported value is below 1 / kSubBuckets.
+class LatencyHistogram
+{
+public:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kMaxExponent = 47;  // ~39 hours in ns, larger values are clamped
+    static constexpr int kBucketCount = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+    // Summary of the recorded values, in nanoseconds
+    struct Summary {
+        quint64 count;
+        double mean;
+        quint64 p50;
+        quint64 p90;
+        quint64 p99;
+        quint64 p999;
+        quint64 max;
+    };
+
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    // Record one value. Lock-free, callable from any thread
+    void record(quint64 nanoseconds);
+
+    // Compute count, mean, percentiles and max (approximate while
+    // other threads are recording)
+    Summary summary() const;
+
+    // Forget all values
+    void reset();
+
+private:
+    static int bucketIndex(quint64 value);
+    static quint64 bucketUpperBound(int index);
+
+    std::atomic<quint64> buckets[kBucketCount];
+    std::atomic<quint64> count;
+    std::atomic<quint64> sum;
+    std::atomic<quint64> max;
+};
+
+// Per-stage histograms of the whole pipeline (process-wide)
+class PipelineStats
+{
+public:
+    // Instrumented stages, in pipeline order
+    enum Stage {
+        FrameWait,      // Mailbox post -> processing thread picks the frame up
+        Ingest,         // Map the frame and get its luma plane
+        ToImage,        // QVideoFrame::toImage fallback (part of Ingest)
+        SceneDetect,    // Scene change detection (auto OCR only)
+        TextTrack,      // Follow text regions, find changed ones (tracking only)
+        Threshold,      // Otsu threshold of the luma
+        Colorize,       // Binary -> scheme colors
+        FrameTotal,     // Whole processFrame call
+        CaptureFusion,  // Align and fuse the last frames of a capture
+        OcrPreprocess,  // Luma -> Tesseract binary
+        OcrQueueWait,   // Submitted -> picked up by an engine
+        OcrPrescale,    // Glyph height estimate and resize
+        OcrRegions,     // Text region proposals
+        OcrRecognize,   // One Tesseract recognition (GetUTF8Text)
+        OcrEngine,      // Whole job on the engine
+        OcrFirstLine,   // Submitted -> first text line recognized
+        OcrTotal,       // Submitted -> result back (engine or cache hit)
+        StageCount
+    };
+
+    static PipelineStats &instance();
+
+    // Record one latency of a stage. Lock-free
+    void record(Stage stage, quint64 nanoseconds) { histograms[stage].record(nanoseconds); }
+
+    const LatencyHistogram &histogram(Stage stage) const { return histograms[stage]; }
+
+    // Short stage name used in the panel and the JSON dump
+    static const char *stageName(Stage stage);
+
+    // Seconds since the statistics were created or last reset
+    double elapsedSeconds() const;
+
+    // Human-readable table of all stages that saw any values
+    QString toText() const;
+
+    // All stages with count, rate (per second), mean and percentiles
+    // (in microseconds)
+    QJsonObject toJson() const;
+
+    // Forget everything and restart the rate clock
+    void reset();
+
+    // Monotonic timestamp in nanoseconds, for latencies across threads
+    static qint64 now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    PipelineStats();
+
+    LatencyHistogram histograms[StageCount];
+    std::atomic<qint64> startTime;  // Rate clock origin (now())
+};
+
+// Records the lifetime of the scope as one latency of a stage
+class ScopedStageTimer
+{
+public:
+    explicit ScopedStageTimer(PipelineStats::Stage stage)
+        : stage(stage)
+        , start(PipelineStats::now())
+    {
+    }
+
+    ~ScopedStageTimer()
+    {
+        PipelineStats::instance().record(stage, quint64(PipelineStats::now() - start));
+    }
+
+    ScopedStageTimer(const ScopedStageTimer &) = delete;
+    ScopedStageTimer &operator=(const ScopedStageTimer &) = delete;
+
+private:
+    PipelineStats::Stage stage;
+    qint64 start;
+};
+
+#endif // PIPELINESTATS_H
@@ -0,0 +1,96 @@
+/*
+ * scenechangedetector.cpp - Scene Stability Detector Implementation
+ *
+ * Purpose: Implements the block-local thumbnail change metric and the
+ * change -> stable -> fire state machine
+ */
+
+#include "scenechangedetector.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+namespace {
+
+// Thumbnail width; height follows the frame's aspect ratio. Small
+// enough to be cheap, large enough that a glyph still covers a few
+// pixels. Frames are reduced at least kMinReduction times, so sensor
+// noise is averaged over as many pixels squared
+const int kMaxThumbnailWidth = 320;
+const int kMinReduction = 4;
+
+// A thumbnail pixel that moved by more gray levels than this changed
+const int kPixelDelta = 16;
+
+// Side of the sliding block, in thumbnail pixels, whose changed pixels
+// are counted. A changed word is small against the whole frame but
+// fills a good part of a block around it
+const int kBlockSize = 8;
+
+} // namespace
+
+SceneChangeDetector::SceneChangeDetector(int stableFrames, double changeThreshold)
+    : stableFrames(stableFrames)
+    , changeThreshold(changeThreshold)
+    , armed(true)
+    , stableCount(0)
+    , change(0.0)
+{
+}
+
+void SceneChangeDetector::reset()
+{
+    previous.release();
+    armed = true;
+    stableCount = 0;
+    change = 0.0;
+}
+
+bool SceneChangeDetector::update(const cv::Mat &luma)
+{
+    if (luma.empty()) {
+        return false;
+    }
+
+    // Area averaging also suppresses per-pixel sensor noise
+    int width = std::max(1, std::min(kMaxThumbnailWidth, luma.cols / kMinReduction));
+    int height = std::max(1, luma.rows * width / std::max(1, luma.cols));
+    cv::resize(luma, thumbnail, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+
+    if (previous.size() != thumbnail.size()) {
+        // First frame or resolution change: treat as a new scene
+        change = 1.0;
+    } else {
+        // Changed pixels (0/1), counted over every block position; the
+        // busiest block decides, however small the change is overall
+        cv::absdiff(thumbnail, previous, difference);
+        cv::threshold(difference, difference, kPixelDelta, 1, cv::THRESH_BINARY);
+        cv::boxFilter(difference, blockCounts, CV_32F, cv::Size(kBlockSize, kBlockSize),
+                      cv::Point(-1, -1), false, cv::BORDER_CONSTANT);
+        double most = 0.0;
+        cv::minMaxLoc(blockCounts, nullptr, &most);
+        change = most / (kBlockSize * kBlockSize);
+    }
+
+    // Keep the current thumbnail for the next frame (swap, no copy)
+    cv::swap(thumbnail, previous);
+
+    if (change > changeThreshold) {
+        armed = true;
+        stableCount = 0;
+        return false;
+    }
+
+    if (!armed) {
+        // Still the scene we already OCR'd
+        return false;
+    }
+
+    if (++stableCount < stableFrames) {
+        return false;
+    }
+
+    // Changed, then stable long enough: OCR it once
+    armed = false;
+    stableCount = 0;
+    return true;
+}
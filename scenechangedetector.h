@@ -0,0 +1,54 @@
+/*
+ * scenechangedetector.h - Scene Stability Detector Header
+ *
+ * Purpose: Decides when a continuously running camera should be OCR'd.
+ * Every frame is reduced to a small luma thumbnail and compared with the
+ * previous one. OCR fires once after the scene has changed and then
+ * stayed stable for a number of frames, so a static screen costs one
+ * OCR pass instead of one per frame.
+ */
+
+#ifndef SCENECHANGEDETECTOR_H
+#define SCENECHANGEDETECTOR_H
+
+#include <opencv2/core.hpp>
+
+class SceneChangeDetector
+{
+public:
+    // stableFrames: frames the scene must stay still before OCR fires
+    // changeThreshold: fraction of the thumbnail pixels in any one block
+    //                  that must differ for a frame to count as a change.
+    //                  The default is three pixels of a block, about what
+    //                  a single changed word gives
+    explicit SceneChangeDetector(int stableFrames = 10, double changeThreshold = 0.04);
+
+    // Feed the next CV_8UC1 luma frame. Returns true if OCR should run
+    // on this frame
+    bool update(const cv::Mat &luma);
+
+    // Forget the previous frame; the next stable scene triggers OCR again
+    void reset();
+
+    // Configuration
+    void setStableFrames(int frames) { stableFrames = frames; }
+    int getStableFrames() const { return stableFrames; }
+
+    // Change metric of the last frame passed to update(): the largest
+    // fraction of changed pixels in a block
+    double lastChange() const { return change; }
+
+private:
+    int stableFrames;        // Still frames required before firing
+    double changeThreshold;  // Metric above which the scene changed
+
+    cv::Mat thumbnail;       // Downsampled current frame
+    cv::Mat previous;        // Downsampled previous frame
+    cv::Mat difference;      // Scratch buffer for the comparison
+    cv::Mat blockCounts;     // Changed pixels per block, scratch
+    bool armed;              // Scene changed since the last OCR
+    int stableCount;         // Still frames since the last change
+    double change;           // Last change metric
+};
+
+#endif // SCENECHANGEDETECTOR_H
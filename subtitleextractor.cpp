@@ -0,0 +1,536 @@
+/*
+ * subtitleextractor.cpp - Subtitle Extraction Implementation
+ *
+ * Purpose: Implements the decode and preprocess threads, the band comparison,
+ * the merging of readings into cues and the stitching of frame ranges
+ */
+
+#include "subtitleextractor.h"
+#include "videoprocessor.h"
+#include "ocrenginepool.h"
+#include "ocrpreprocess.h"
+#include "pipelinestats.h"
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QStringList>
+#include <QDebug>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Decoded bands waiting for the preprocess thread at most. Enough to
+// ride out a slow frame, small enough not to decode far ahead of OCR
+constexpr int kQueuedBands = 8;
+
+// Bands are compared in blocks of this many pixels square, about a
+// stroke of a subtitle glyph at 480p and part of one at larger sizes
+constexpr int kBlockSize = 16;
+
+// Fraction of a block that must differ for the band to count as changed,
+// once one pixel wide flicker is removed
+constexpr double kChangedFraction = 0.1;
+
+// A cut-out band of one frame
+struct Band {
+    double timestampMs;
+    cv::Mat luma;
+};
+
+} // namespace
+
+// Bounded queue from the decode thread to the preprocess thread
+class BandQueue
+{
+public:
+    explicit BandQueue(int capacity)
+        : capacity(capacity)
+        , closed(false)
+        , end(0.0)
+    {
+    }
+
+    // Blocks while the queue is full. Returns false once closed
+    bool push(Band band)
+    {
+        QMutexLocker locker(&mutex);
+        while (int(items.size()) >= capacity && !closed) {
+            notFull.wait(&mutex);
+        }
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(band));
+        notEmpty.wakeOne();
+        return true;
+    }
+
+    // Blocks while the queue is empty. Returns false once it is closed
+    // and every band has been taken
+    bool pop(Band &band)
+    {
+        QMutexLocker locker(&mutex);
+        while (items.empty() && !closed) {
+            notEmpty.wait(&mutex);
+        }
+        if (items.empty()) {
+            return false;
+        }
+        band = std::move(items.front());
+        items.pop_front();
+        notFull.wakeOne();
+        return true;
+    }
+
+    // No more bands; the stream ended at endMs
+    void close(double endMs)
+    {
+        QMutexLocker locker(&mutex);
+        if (!closed) {
+            closed = true;
+            end = endMs;
+        }
+        notEmpty.wakeAll();
+        notFull.wakeAll();
+    }
+
+    double endMs() const
+    {
+        QMutexLocker locker(&mutex);
+        return end;
+    }
+
+private:
+    mutable QMutex mutex;
+    QWaitCondition notEmpty;
+    QWaitCondition notFull;
+    std::deque<Band> items;
+    const int capacity;
+    bool closed;
+    double end;
+};
+
+SubtitleExtractor::SubtitleExtractor(VideoProcessor *processor, const QString &path,
+                                     const Options &options, QObject *parent)
+    : QObject(parent)
+    , processor(processor)
+    , videoPath(path)
+    , options(options)
+    , fps(0.0)
+    , bands(new BandQueue(kQueuedBands))
+    , decodeThread(nullptr)
+    , preprocessThread(nullptr)
+    , stopping(false)
+    , streamEnded(false)
+    , streamStartMs(0.0)
+    , streamEndMs(0.0)
+    , done(false)
+    , decodedFrames(0)
+    , unchangedFrames(0)
+    , recognizedFrames(0)
+    , cueCount(0)
+{
+    this->options.stride = std::max(1, options.stride);
+    if (options.source < 0) {
+        this->options.source = processor->sourceId();
+    }
+
+    // Results come in submission order per source, so ranges read side
+    // by side as separate sources do not wait for each other's results
+    connect(processor->ocrEnginePool(), &OCREnginePool::ocrComplete,
+            this, &SubtitleExtractor::onOCRResult);
+}
+
+SubtitleExtractor::~SubtitleExtractor()
+{
+    // Unblock both stages wherever they wait, then let them finish
+    stopping.store(true);
+    bands->close(0.0);
+
+    for (QThread *thread : {decodeThread, preprocessThread}) {
+        if (thread) {
+            thread->wait();
+            delete thread;
+        }
+    }
+}
+
+bool SubtitleExtractor::start()
+{
+    if (!capture.open(videoPath.toStdString())) {
+        qWarning() << "Could not open video" << videoPath;
+        return false;
+    }
+    fps = capture.get(cv::CAP_PROP_FPS);
+
+    // Later ranges seek to their first frame. The backend decodes from
+    // the keyframe before it, so at most one group of pictures is decoded
+    // in vain per range
+    if (options.startFrame > 0) {
+        if (fps <= 0.0 || !capture.set(cv::CAP_PROP_POS_FRAMES, double(options.startFrame))) {
+            qWarning() << "Could not seek to frame" << options.startFrame << "of" << videoPath;
+            capture.release();
+            return false;
+        }
+        streamStartMs = options.startFrame * 1000.0 / fps;
+    }
+
+    // By default keep every engine busy with one band queued behind it
+    const int slots = options.maxInFlight > 0 ? options.maxInFlight
+                                              : 2 * processor->ocrEngineCount();
+    ocrSlots.release(slots);
+
+    decodeThread = QThread::create([this] { decodeLoop(); });
+    decodeThread->setObjectName("Subtitle decode");
+    preprocessThread = QThread::create([this] { preprocessLoop(); });
+    preprocessThread->setObjectName("Subtitle preprocess");
+
+    decodeThread->start();
+    preprocessThread->start();
+    return true;
+}
+
+SubtitleExtractor::Counters SubtitleExtractor::counters() const
+{
+    Counters counters;
+    counters.decoded = decodedFrames.load(std::memory_order_relaxed);
+    counters.unchanged = unchangedFrames.load(std::memory_order_relaxed);
+    counters.recognized = recognizedFrames.load(std::memory_order_relaxed);
+    counters.cues = cueCount.load(std::memory_order_relaxed);
+    return counters;
+}
+
+bool SubtitleExtractor::bandChanged(const cv::Mat &previous, const cv::Mat &binary)
+{
+    if (previous.size() != binary.size()) {
+        return true;
+    }
+
+    // Glyph edges and background pixels near the threshold flicker from
+    // frame to frame, another subtitle differs in whole strokes: erosion
+    // keeps only the latter
+    cv::Mat difference;
+    cv::bitwise_xor(previous, binary, difference);
+    cv::erode(difference, difference,
+              cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2, 2)));
+
+    // Mean of each block; a single changed one is enough
+    cv::Mat blocks;
+    cv::resize(difference, blocks,
+               cv::Size(std::max(1, difference.cols / kBlockSize),
+                        std::max(1, difference.rows / kBlockSize)),
+               0, 0, cv::INTER_AREA);
+    double most = 0.0;
+    cv::minMaxLoc(blocks, nullptr, &most);
+    return most > kChangedFraction * 255;
+}
+
+void SubtitleExtractor::decodeLoop()
+{
+    // Frame times from the frame rate, or from the container without one
+    auto timestampMs = [this](qint64 frameIndex) {
+        return fps > 0.0 ? frameIndex * 1000.0 / fps : capture.get(cv::CAP_PROP_POS_MSEC);
+    };
+
+    // Indices count from the start of the video, so strides line up
+    // across ranges
+    qint64 frameIndex = options.startFrame;
+    cv::Mat frame;
+    while (!stopping.load(std::memory_order_relaxed)
+           && (options.endFrame < 0 || frameIndex < options.endFrame)) {
+        // Frames between strides are grabbed, not retrieved and converted
+        if (frameIndex % options.stride != 0) {
+            if (!capture.grab()) {
+                break;
+            }
+            frameIndex++;
+            decodedFrames.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        if (!capture.read(frame) || frame.empty()) {
+            break;
+        }
+
+        Band band{timestampMs(frameIndex), cv::Mat()};
+        frameIndex++;
+        decodedFrames.fetch_add(1, std::memory_order_relaxed);
+
+        // Only the band is converted to luma
+        const int top = std::clamp(int(options.bandTop * frame.rows), 0, frame.rows - 1);
+        const int bottom = std::clamp(int(options.bandBottom * frame.rows), top + 1, frame.rows);
+        const cv::Mat region = frame.rowRange(top, bottom);
+        if (region.channels() == 3) {
+            cv::cvtColor(region, band.luma, cv::COLOR_BGR2GRAY);
+        } else if (region.channels() == 4) {
+            cv::cvtColor(region, band.luma, cv::COLOR_BGRA2GRAY);
+        } else {
+            region.copyTo(band.luma);
+        }
+
+        if (!bands->push(std::move(band))) {
+            break;
+        }
+    }
+
+    const double endMs = timestampMs(frameIndex);
+    capture.release();
+    bands->close(endMs);
+}
+
+void SubtitleExtractor::preprocessLoop()
+{
+    OCREnginePool *pool = processor->ocrEnginePool();
+    const int source = options.source;
+
+    // The scheme colors only decide the polarity
+    const QColor &fgColor = options.foreground;
+    const QColor &bgColor = options.background;
+    const bool lightText = OcrPreprocess::isLightText(
+        cv::Vec3b(fgColor.blue(), fgColor.green(), fgColor.red()),
+        cv::Vec3b(bgColor.blue(), bgColor.green(), bgColor.red()));
+
+    // The last band sent to OCR. Bands are compared with it rather than
+    // with the one just before, so a slow fade still adds up to a change
+    cv::Mat previous;
+    Band band;
+    while (bands->pop(band)) {
+        if (stopping.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        cv::Mat binary;
+        bool changed;
+        {
+            ScopedStageTimer timer(PipelineStats::OcrPreprocess);
+            OcrPreprocess::binarize(band.luma, binary, lightText, options.threshold);
+            changed = bandChanged(previous, binary);
+        }
+
+        // The same subtitle is still showing
+        if (!changed) {
+            unchangedFrames.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        previous = binary;
+
+        // Wait for an OCR slot; the decoder fills its queue meanwhile
+        while (!ocrSlots.tryAcquire(1, 100)) {
+            if (stopping.load(std::memory_order_relaxed)) {
+                return;
+            }
+        }
+
+        // Hold the lock across submit so the result cannot be handled
+        // before the job is known to be ours
+        quint64 jobId;
+        {
+            QMutexLocker locker(&jobsMutex);
+            jobId = pool->submit(binary, false, source);
+            jobs.insert(jobId);
+        }
+        recognizedFrames.fetch_add(1, std::memory_order_relaxed);
+
+        const double startMs = band.timestampMs;
+        QMetaObject::invokeMethod(this, [this, jobId, startMs]() {
+            addSegment(jobId, startMs);
+        }, Qt::QueuedConnection);
+    }
+
+    const double endMs = bands->endMs();
+    QMetaObject::invokeMethod(this, [this, endMs]() {
+        endOfStream(endMs);
+    }, Qt::QueuedConnection);
+}
+
+void SubtitleExtractor::onOCRResult(int sourceId, quint64 jobId, const QString &text)
+{
+    if (sourceId != options.source) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&jobsMutex);
+        if (!jobs.remove(jobId)) {
+            return;
+        }
+    }
+    ocrSlots.release();
+
+    results[jobId] = text;
+    drain();
+}
+
+void SubtitleExtractor::addSegment(quint64 jobId, double startMs)
+{
+    segments.push_back(Segment{jobId, startMs});
+    drain();
+}
+
+void SubtitleExtractor::endOfStream(double endMs)
+{
+    streamEnded = true;
+    streamEndMs = endMs;
+    drain();
+}
+
+void SubtitleExtractor::drain()
+{
+    // A segment lasts until the next one starts, so it can only be merged
+    // once the next one (or the end of the file) is known
+    while (!segments.empty()) {
+        auto result = results.find(segments.front().jobId);
+        if (result == results.end()) {
+            break;
+        }
+
+        double endMs;
+        if (segments.size() > 1) {
+            endMs = segments[1].startMs;
+        } else if (streamEnded) {
+            endMs = streamEndMs;
+        } else {
+            break;
+        }
+
+        merge(segments.front().startMs, endMs, result->second);
+        results.erase(result);
+        segments.pop_front();
+    }
+
+    if (streamEnded && segments.empty() && !done) {
+        flushCue();
+        done = true;
+        emit finished();
+    }
+}
+
+void SubtitleExtractor::merge(double startMs, double endMs, const QString &text)
+{
+    if (OCREnginePool::isErrorResult(text)) {
+        qWarning() << "OCR failed at" << startMs << "ms of" << videoPath << ":" << text;
+    }
+
+    for (const SubtitleCue &closed : merger.add(startMs, endMs, text)) {
+        report(closed);
+    }
+}
+
+void SubtitleExtractor::flushCue()
+{
+    for (const SubtitleCue &closed : merger.finish()) {
+        report(closed);
+    }
+}
+
+void SubtitleExtractor::report(const SubtitleCue &closed)
+{
+    cueCount.fetch_add(1, std::memory_order_relaxed);
+    emit cue(closed);
+}
+
+CueMerger::CueMerger()
+    : haveCue(false)
+    , openCue{0.0, 0.0, QString()}
+{
+}
+
+std::vector<SubtitleCue> CueMerger::add(double startMs, double endMs, const QString &text)
+{
+    // Lines trimmed, blank ones dropped; a failed or empty reading shows
+    // nothing, which closes the open cue
+    QStringList lines;
+    if (OCREnginePool::hasText(text)) {
+        for (const QString &line : text.split('\n')) {
+            QString trimmed = line.trimmed();
+            if (!trimmed.isEmpty()) {
+                lines.append(trimmed);
+            }
+        }
+    }
+    const QString cleaned = lines.join('\n');
+
+    // Same text as before: the band changed (noise, a moving background)
+    // but the subtitle did not
+    if (haveCue && cleaned == openCue.text) {
+        openCue.endMs = endMs;
+        return {};
+    }
+
+    std::vector<SubtitleCue> out = finish();
+    openCue = SubtitleCue{startMs, endMs, cleaned};
+    haveCue = true;
+    return out;
+}
+
+std::vector<SubtitleCue> CueMerger::finish()
+{
+    std::vector<SubtitleCue> out;
+    if (haveCue && !openCue.text.isEmpty()) {
+        out.push_back(openCue);
+    }
+    haveCue = false;
+    return out;
+}
+
+CueStitcher::CueStitcher(int chunks, double toleranceMs)
+    : pending(std::max(1, chunks))
+    , finished(std::max(1, chunks), false)
+    , next(0)
+    , tolerance(toleranceMs)
+    , haveHeld(false)
+    , held{0.0, 0.0, QString()}
+{
+}
+
+std::vector<SubtitleCue> CueStitcher::add(int chunk, const SubtitleCue &cue)
+{
+    std::vector<SubtitleCue> out;
+    if (chunk == next) {
+        append(cue, out);
+    } else {
+        pending[chunk].push_back(cue);
+    }
+    return out;
+}
+
+std::vector<SubtitleCue> CueStitcher::finish(int chunk)
+{
+    std::vector<SubtitleCue> out;
+    finished[chunk] = true;
+
+    // Everything up to the next unfinished range is in order now
+    const int chunks = int(finished.size());
+    while (next < chunks && finished[next]) {
+        next++;
+        if (next < chunks) {
+            for (const SubtitleCue &cue : pending[next]) {
+                append(cue, out);
+            }
+            pending[next].clear();
+        }
+    }
+
+    // The last cue can no longer grow
+    if (next == chunks && haveHeld) {
+        out.push_back(held);
+        haveHeld = false;
+    }
+    return out;
+}
+
+void CueStitcher::append(const SubtitleCue &cue, std::vector<SubtitleCue> &out)
+{
+    // The same subtitle on both sides of a range boundary
+    if (haveHeld && cue.text == held.text && cue.startMs - held.endMs <= tolerance) {
+        held.endMs = cue.endMs;
+        return;
+    }
+
+    if (haveHeld) {
+        out.push_back(held);
+    }
+    held = cue;
+    haveHeld = true;
+}
@@ -0,0 +1,223 @@
+/*
+ * subtitleextractor.h - Subtitle Extraction Header
+ *
+ * Purpose: Turns the subtitle (or ticker) band of a video file into timed
+ * text cues, for batch mode (VideoOCR --batch --subtitles):
+ * - A decode thread reads the frames and cuts out the band
+ * - A preprocess thread binarizes the band and compares it block by block
+ *   with the last band read; one that differs only in flickering pixels
+ *   (the same subtitle still showing) is not read again
+ * - Changed bands go to the OCR engine pool of a VideoProcessor
+ *
+ * The three stages run at once, connected by short bounded queues, so a
+ * file is decoded while earlier frames are being read. Back on the main
+ * thread, consecutive readings of the same text are merged into one cue
+ * from the first frame showing it to the first frame that does not.
+ *
+ * A long video can be split into frame ranges with an extractor each,
+ * running side by side; CueStitcher puts their cues back in order and
+ * joins the cue of a subtitle showing across a range boundary.
+ */
+
+#ifndef SUBTITLEEXTRACTOR_H
+#define SUBTITLEEXTRACTOR_H
+
+#include <QObject>
+#include <QString>
+#include <QColor>
+#include <QMutex>
+#include <QSet>
+#include <QSemaphore>
+#include <QThread>
+#include <opencv2/videoio.hpp>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+#include "adaptivebinarizer.h"
+
+class VideoProcessor;
+class BandQueue;
+
+// One subtitle: text shown from startMs until endMs
+struct SubtitleCue {
+    double startMs;
+    double endMs;
+    QString text;  // Lines separated by '\n'
+};
+
+// Merges consecutive readings of a band into cues: a reading with the
+// same text as the one before extends its cue, any other text starts a
+// new one. Readings without text (failed or empty) end the cue before
+// them and are not reported
+class CueMerger
+{
+public:
+    CueMerger();
+
+    // The band read text from startMs until endMs, readings in time
+    // order. Lines are trimmed, blank ones dropped. Returns the cue this
+    // closed, if any
+    std::vector<SubtitleCue> add(double startMs, double endMs, const QString &text);
+
+    // No more readings. Returns the open cue, if any
+    std::vector<SubtitleCue> finish();
+
+private:
+    bool haveCue;                         // openCue may still grow
+    SubtitleCue openCue;
+};
+
+class SubtitleExtractor : public QObject
+{
+    Q_OBJECT
+
+public:
+    // What to read and how
+    struct Options {
+        double bandTop = 0.75;       // Band of the frame holding the text,
+        double bandBottom = 1.0;     // as fractions of the frame height
+        int stride = 1;              // Look at every Nth frame
+        qint64 startFrame = 0;       // Frame range read: from startFrame
+        qint64 endFrame = -1;        // up to endFrame (exclusive), -1 = end
+        int maxInFlight = 0;         // OCR jobs at once, 0 = two per engine
+        int source = -1;             // Pool source of the jobs, -1 = the
+                                     // processor's (see OCREnginePool)
+        QColor foreground = Qt::white;  // Scheme colors, decide the polarity
+        QColor background = Qt::black;
+        ThresholdMethod threshold = ThresholdMethod::Otsu;
+    };
+
+    // Frame counters, readable from any thread
+    struct Counters {
+        quint64 decoded;    // Frames read from the file
+        quint64 unchanged;  // Bands like the one read before, not read
+        quint64 recognized; // Bands sent to OCR
+        quint64 cues;       // Cues reported
+    };
+
+    // Extract from the video at path using processor's OCR engines. The
+    // processor must outlive the extractor
+    SubtitleExtractor(VideoProcessor *processor, const QString &path,
+                      const Options &options, QObject *parent = nullptr);
+    ~SubtitleExtractor();
+
+    // Open the file and start the stages. Returns false (after a warning)
+    // if the file cannot be opened as a video
+    bool start();
+
+    QString path() const { return videoPath; }
+
+    // Length of the video read, valid once finished was emitted
+    double durationMs() const { return streamEndMs - streamStartMs; }
+
+    Counters counters() const;
+
+    // True if the binarized band differs from the previous one in more
+    // than flicker: some block of it changed in whole strokes
+    static bool bandChanged(const cv::Mat &previous, const cv::Mat &binary);
+
+signals:
+    // Signal: The next cue, in time order. Cues without text are not
+    // reported
+    void cue(const SubtitleCue &cue);
+
+    // Signal: The whole file has been read and every cue reported
+    void finished();
+
+private slots:
+    // Slot: Called for every OCR result of the pool
+    void onOCRResult(int sourceId, quint64 jobId, const QString &text);
+
+private:
+    // A changed band and the OCR job reading it, main thread
+    struct Segment {
+        quint64 jobId;
+        double startMs;   // Frame it was first seen in
+    };
+
+    // Decode thread: read frames, cut out the band
+    void decodeLoop();
+
+    // Preprocess thread: binarize, compare, submit changed bands
+    void preprocessLoop();
+
+    // Main thread: a changed band was submitted
+    void addSegment(quint64 jobId, double startMs);
+
+    // Main thread: the file ended at endMs
+    void endOfStream(double endMs);
+
+    // Main thread: turn segments whose text is known into cues
+    void drain();
+
+    // Main thread: merge a reading into the cues, report the closed ones
+    void merge(double startMs, double endMs, const QString &text);
+
+    // Main thread: report the open cue
+    void flushCue();
+
+    // Main thread: report a cue
+    void report(const SubtitleCue &closed);
+
+    VideoProcessor *processor;
+    QString videoPath;
+    Options options;
+
+    // Stages
+    cv::VideoCapture capture;             // Decode thread once started
+    double fps;                           // Frame rate of the video
+    std::unique_ptr<BandQueue> bands;     // Decode -> preprocess
+    QThread *decodeThread;
+    QThread *preprocessThread;
+    std::atomic<bool> stopping;           // Set to abandon the file
+    QSemaphore ocrSlots;                  // OCR jobs in flight at most
+    QMutex jobsMutex;                     // Guards jobs
+    QSet<quint64> jobs;                   // Own OCR jobs in flight
+
+    // Cue assembly, main thread
+    std::deque<Segment> segments;         // Submitted, in time order
+    std::map<quint64, QString> results;   // Text of segments not merged yet
+    bool streamEnded;
+    double streamStartMs;                 // Where the frame range starts
+    double streamEndMs;                   // Where the last segment ends
+    CueMerger merger;
+    bool done;                            // finished was emitted
+
+    // Counters
+    std::atomic<quint64> decodedFrames;
+    std::atomic<quint64> unchangedFrames;
+    std::atomic<quint64> recognizedFrames;
+    std::atomic<quint64> cueCount;
+};
+
+// Joins the cues of consecutive frame ranges of one video into one track.
+// Cues are passed on as soon as everything before them is known
+class CueStitcher
+{
+public:
+    // chunks: number of ranges. Cues of neighboring ranges with the same
+    // text are joined if no more than toleranceMs lies between them
+    CueStitcher(int chunks, double toleranceMs);
+
+    // A cue of a range, in time order within it. Returns the cues final
+    // by now, in time order
+    std::vector<SubtitleCue> add(int chunk, const SubtitleCue &cue);
+
+    // A range has reported all of its cues. Returns the cues final by now
+    std::vector<SubtitleCue> finish(int chunk);
+
+private:
+    // Append a cue after everything before it, joining it to the held one
+    void append(const SubtitleCue &cue, std::vector<SubtitleCue> &out);
+
+    std::vector<std::vector<SubtitleCue>> pending;  // Cues of later ranges
+    std::vector<bool> finished;                     // Ranges complete
+    int next;                                       // Earliest unfinished range
+    double tolerance;
+    bool haveHeld;                                  // held may still grow
+    SubtitleCue held;                               // Last cue so far
+};
+
+#endif // SUBTITLEEXTRACTOR_H
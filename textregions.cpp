@@ -0,0 +1,165 @@
+/*
+ * textregions.cpp - Text Region Proposal Implementation
+ *
+ * Purpose: Implements the morphology + connected components text
+ * detector and the reading-order sort
+ */
+
+#include "textregions.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+namespace TextRegions {
+
+namespace {
+
+// Frames are analyzed at no more than this width; text detection does
+// not need full resolution and the morphology cost scales with area
+const int kMaxWorkingWidth = 1280;
+
+// Component filters, in working resolution pixels
+const int kMinTextHeight = 6;
+const double kMinEdgeDensity = 0.15;
+
+// Above this fraction of the frame, cropping saves nothing
+const double kMaxCoverage = 0.6;
+
+// Union overlapping boxes until none overlap
+void mergeOverlapping(std::vector<cv::Rect> &boxes)
+{
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < boxes.size() && !merged; i++) {
+            for (size_t j = i + 1; j < boxes.size(); j++) {
+                if ((boxes[i] & boxes[j]).area() > 0) {
+                    boxes[i] |= boxes[j];
+                    boxes.erase(boxes.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+std::vector<Region> propose(const cv::Mat &binary)
+{
+    CV_Assert(binary.type() == CV_8UC1);
+
+    std::vector<Region> regions;
+    if (binary.empty()) {
+        return regions;
+    }
+
+    // Halve the resolution until the frame is small enough to analyze
+    int factor = 1;
+    while (binary.cols / factor > kMaxWorkingWidth) {
+        factor *= 2;
+    }
+
+    cv::Mat working;
+    if (factor > 1) {
+        cv::resize(binary, working, cv::Size(binary.cols / factor, binary.rows / factor),
+                   0, 0, cv::INTER_AREA);
+    } else {
+        working = binary;
+    }
+
+    // Glyph outlines, the same for dark-on-light and light-on-dark text
+    cv::Mat edges;
+    cv::morphologyEx(working, edges, cv::MORPH_GRADIENT,
+                     cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(3, 3)));
+    cv::threshold(edges, edges, 64, 255, cv::THRESH_BINARY);
+
+    // Join the glyphs of a line (but not adjacent lines) into one blob
+    cv::Mat joined;
+    int joinWidth = std::max(9, working.cols / 100);
+    cv::morphologyEx(edges, joined, cv::MORPH_CLOSE,
+                     cv::getStructuringElement(cv::MORPH_RECT, cv::Size(joinWidth, 1)));
+
+    cv::Mat labels, stats, centroids;
+    int count = cv::connectedComponentsWithStats(joined, labels, stats, centroids, 8, CV_32S);
+
+    std::vector<cv::Rect> boxes;
+    for (int i = 1; i < count; i++) {  // Label 0 is the background
+        int x = stats.at<int>(i, cv::CC_STAT_LEFT);
+        int y = stats.at<int>(i, cv::CC_STAT_TOP);
+        int w = stats.at<int>(i, cv::CC_STAT_WIDTH);
+        int h = stats.at<int>(i, cv::CC_STAT_HEIGHT);
+        int area = stats.at<int>(i, cv::CC_STAT_AREA);
+
+        // Too small to read, too tall to be a line, or too sparse to be
+        // glyphs (frames, lines, noise)
+        if (h < kMinTextHeight || h > working.rows / 3 || w < 3) {
+            continue;
+        }
+        if (area < kMinEdgeDensity * w * h) {
+            continue;
+        }
+
+        // Back to full resolution, with a margin Tesseract likes to have
+        int padX = std::max(2, h / 2) * factor;
+        int padY = std::max(2, h / 5) * factor;
+        cv::Rect box(x * factor - padX, y * factor - padY,
+                     w * factor + 2 * padX, h * factor + 2 * padY);
+        boxes.push_back(box & cv::Rect(0, 0, binary.cols, binary.rows));
+    }
+
+    mergeOverlapping(boxes);
+
+    double covered = 0.0;
+    for (const cv::Rect &box : boxes) {
+        covered += box.area();
+    }
+    if (covered > kMaxCoverage * binary.total()) {
+        return regions;
+    }
+
+    for (const cv::Rect &box : boxes) {
+        regions.push_back(Region{box, 0});
+    }
+    sortReadingOrder(regions);
+    return regions;
+}
+
+void sortReadingOrder(std::vector<Region> &regions)
+{
+    // Top to bottom first
+    std::sort(regions.begin(), regions.end(), [](const Region &a, const Region &b) {
+        return a.box.y < b.box.y;
+    });
+
+    // A box joins the current line if it overlaps it vertically by at
+    // least half of the smaller height
+    int line = -1;
+    int lineTop = 0;
+    int lineBottom = 0;
+    for (Region &region : regions) {
+        int top = region.box.y;
+        int bottom = region.box.y + region.box.height;
+        int overlap = std::min(bottom, lineBottom) - std::max(top, lineTop);
+
+        if (line < 0 || overlap * 2 < std::min(region.box.height, lineBottom - lineTop)) {
+            line++;
+            lineTop = top;
+            lineBottom = bottom;
+        } else {
+            lineTop = std::min(lineTop, top);
+            lineBottom = std::max(lineBottom, bottom);
+        }
+        region.line = line;
+    }
+
+    // Then left to right within each line
+    std::stable_sort(regions.begin(), regions.end(), [](const Region &a, const Region &b) {
+        if (a.line != b.line) {
+            return a.line < b.line;
+        }
+        return a.box.x < b.box.x;
+    });
+}
+
+} // namespace TextRegions
@@ -0,0 +1,38 @@
+/*
+ * textregions.h - Text Region Proposal Header
+ *
+ * Purpose: Finds the parts of a binarized frame that look like text, so
+ * Tesseract only has to look at those instead of running its page
+ * layout analysis over the whole frame:
+ * - Morphological gradient to find glyph edges
+ * - Horizontal closing to join the glyphs of a line
+ * - Connected components, filtered by size and edge density
+ * - Boxes sorted in reading order and grouped into lines
+ */
+
+#ifndef TEXTREGIONS_H
+#define TEXTREGIONS_H
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+namespace TextRegions {
+
+// A candidate text box
+struct Region {
+    cv::Rect box;  // Bounding box in image coordinates (padded)
+    int line;      // Reading-order line the box belongs to, from 0
+};
+
+// Propose text regions on a CV_8UC1 binary image (either polarity),
+// sorted in reading order (top to bottom, then left to right).
+// Returns no regions if nothing looks like text, or if text covers so
+// much of the frame that cropping would not save anything.
+std::vector<Region> propose(const cv::Mat &binary);
+
+// Sort boxes in reading order and assign their line numbers
+void sortReadingOrder(std::vector<Region> &regions);
+
+} // namespace TextRegions
+
+#endif // TEXTREGIONS_H
@@ -0,0 +1,431 @@
+/*
+ * texttracker.cpp - Text Region Tracker Implementation
+ *
+ * Purpose: Implements region following by template matching, the block
+ * wise change test and the discovery of new text at word boundaries
+ */
+
+#include "texttracker.h"
+#include "textregions.h"
+#include "ocrenginepool.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+namespace {
+
+// Frames between text region proposals. Following a region costs a small
+// template match, proposing runs morphology over the whole frame
+constexpr int kProposalInterval = 5;
+
+// Match score (normalized correlation) below which a region is not found
+constexpr double kMinMatch = 0.6;
+
+// Frames a region may go unfound before it is dropped
+constexpr int kMaxMisses = 3;
+
+// Regions are searched for this far around their last position, or
+// their height if larger. Bounds how fast text may scroll per frame
+constexpr int kMinSearchMargin = 16;
+
+// Fraction of a glyph-sized block that must differ for a region to count
+// as changed, once one pixel wide edge flicker is removed
+constexpr double kChangedFraction = 0.05;
+
+// Below this fraction of text pixels a region has gone blank
+constexpr double kMinInk = 0.01;
+
+// Two regions overlapping by more than this fraction of the smaller one
+// follow the same text
+constexpr double kDuplicateOverlap = 0.5;
+
+// Distance to the frame edge under which a box is cut at a word gap
+constexpr int kEdgeDistance = 2;
+
+// Whether a binary crop (dark text on light) holds almost no text
+bool isBlank(const cv::Mat &binary)
+{
+    const int ink = int(binary.total()) - cv::countNonZero(binary);
+    return ink < kMinInk * binary.total();
+}
+
+} // namespace
+
+TextTracker::TextTracker()
+    : nextId(0)
+    , maxPending(4)
+    , textRevision(0)
+    , frameCount(0)
+    , followedCount(0)
+    , unchangedCount(0)
+    , createdCount(0)
+    , lostCount(0)
+    , requestCount(0)
+    , trackCount(0)
+{
+}
+
+void TextTracker::setMaxPending(int regions)
+{
+    maxPending.store(std::max(1, regions), std::memory_order_relaxed);
+}
+
+void TextTracker::reset()
+{
+    tracks.clear();
+    frameSize = cv::Size();
+    trackCount.store(0, std::memory_order_relaxed);
+
+    QMutexLocker locker(&mutex);
+    if (!shared.empty()) {
+        shared.clear();
+        textRevision.fetch_add(1, std::memory_order_release);
+    }
+}
+
+std::vector<TextTracker::Request> TextTracker::update(const cv::Mat &luma, const cv::Mat &binary)
+{
+    CV_Assert(luma.type() == CV_8UC1 && binary.type() == CV_8UC1 && luma.size() == binary.size());
+
+    std::vector<Request> requests;
+
+    // Positions mean nothing in another resolution
+    if (luma.size() != frameSize) {
+        reset();
+        frameSize = luma.size();
+    }
+
+    const quint64 frame = frameCount.fetch_add(1, std::memory_order_relaxed);
+
+    // Regions whose OCR failed are read again
+    {
+        QMutexLocker locker(&mutex);
+        for (Track &track : tracks) {
+            Shared &state = shared[track.id];
+            if (state.retry) {
+                track.reference.release();
+                state.retry = false;
+            }
+        }
+    }
+
+    // Follow the regions; drop the ones gone for a few frames or gone blank
+    std::vector<int> removed;
+    for (size_t i = 0; i < tracks.size();) {
+        Track &track = tracks[i];
+        bool gone;
+        if (follow(track, luma)) {
+            track.misses = 0;
+            followedCount.fetch_add(1, std::memory_order_relaxed);
+            gone = isBlank(binary(track.box));
+        } else {
+            gone = ++track.misses > kMaxMisses;
+        }
+
+        if (gone) {
+            removed.push_back(track.id);
+            tracks.erase(tracks.begin() + i);
+        } else {
+            i++;
+        }
+    }
+
+    // Two regions that ended up on the same text: keep the older one
+    for (size_t i = 0; i < tracks.size(); i++) {
+        for (size_t j = i + 1; j < tracks.size();) {
+            const int overlap = (tracks[i].box & tracks[j].box).area();
+            const int smaller = std::min(tracks[i].box.area(), tracks[j].box.area());
+            if (overlap > kDuplicateOverlap * smaller) {
+                removed.push_back(tracks[j].id);
+                tracks.erase(tracks.begin() + j);
+            } else {
+                j++;
+            }
+        }
+    }
+    lostCount.fetch_add(removed.size(), std::memory_order_relaxed);
+
+    // Text no region covers yet
+    if (frame % kProposalInterval == 0) {
+        discover(luma, binary);
+    }
+
+    // Regions found in this frame with other pixels than last read
+    std::vector<size_t> changedTracks;
+    for (size_t i = 0; i < tracks.size(); i++) {
+        if (tracks[i].misses > 0) {
+            continue;
+        }
+        if (changed(tracks[i], binary)) {
+            changedTracks.push_back(i);
+        } else {
+            unchangedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    {
+        QMutexLocker locker(&mutex);
+
+        bool textChanged = false;
+        for (int id : removed) {
+            auto it = shared.find(id);
+            if (it != shared.end()) {
+                textChanged = textChanged || !it->second.text.isEmpty();
+                shared.erase(it);
+            }
+        }
+
+        int pending = 0;
+        for (Track &track : tracks) {
+            Shared &state = shared[track.id];
+            state.box = track.box;
+            pending += state.pending ? 1 : 0;
+        }
+
+        // A region still being read is checked again once its text is
+        // back, against the pixels it was sent with
+        const int limit = maxPending.load(std::memory_order_relaxed);
+        for (size_t i : changedTracks) {
+            Track &track = tracks[i];
+            Shared &state = shared[track.id];
+            if (state.pending || pending >= limit) {
+                continue;
+            }
+
+            state.pending = true;
+            pending++;
+            binary(track.box).copyTo(track.reference);
+            requests.push_back(Request{track.id, track.box, track.reference.clone()});
+        }
+
+        if (textChanged) {
+            textRevision.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    requestCount.fetch_add(requests.size(), std::memory_order_relaxed);
+    trackCount.store(int(tracks.size()), std::memory_order_relaxed);
+    return requests;
+}
+
+bool TextTracker::follow(Track &track, const cv::Mat &luma)
+{
+    const int margin = std::max(kMinSearchMargin, track.box.height);
+    const cv::Rect search = cv::Rect(track.box.x - margin, track.box.y - margin,
+                                     track.box.width + 2 * margin, track.box.height + 2 * margin)
+                            & cv::Rect(0, 0, luma.cols, luma.rows);
+
+    // Guard only: regions stay inside the frame size they were found in
+    if (search.width < track.patch.cols || search.height < track.patch.rows) {
+        return false;
+    }
+
+    cv::matchTemplate(luma(search), track.patch, matchScores, cv::TM_CCOEFF_NORMED);
+
+    double best = 0.0;
+    cv::Point at;
+    cv::minMaxLoc(matchScores, nullptr, &best, nullptr, &at);
+    if (!(best >= kMinMatch)) {
+        return false;
+    }
+
+    // The template follows the region, so slow changes are followed too
+    track.box = cv::Rect(search.x + at.x, search.y + at.y, track.box.width, track.box.height);
+    luma(track.box).copyTo(track.patch);
+    return true;
+}
+
+bool TextTracker::changed(const Track &track, const cv::Mat &binary)
+{
+    if (track.reference.empty()) {
+        return true;
+    }
+
+    // Glyph edges flicker by a pixel from frame to frame, a different
+    // glyph differs in whole strokes: erosion keeps only the latter
+    cv::absdiff(binary(track.box), track.reference, diffScratch);
+    cv::erode(diffScratch, diffScratch,
+              cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2, 2)));
+
+    // Differing pixels per column, summed over a sliding glyph-sized block
+    cv::reduce(diffScratch, columnScratch, 0, cv::REDUCE_SUM, CV_32S);
+    const int *columns = columnScratch.ptr<int>();
+    const int block = std::max(4, track.box.height / 2);
+    const qint64 limit = qint64(kChangedFraction * block * track.box.height * 255);
+
+    qint64 sum = 0;
+    for (int x = 0; x < columnScratch.cols; x++) {
+        sum += columns[x];
+        if (x >= block) {
+            sum -= columns[x - block];
+        }
+        if (sum > limit) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TextTracker::discover(const cv::Mat &luma, const cv::Mat &binary)
+{
+    for (const TextRegions::Region &region : TextRegions::propose(binary)) {
+        const cv::Rect &box = region.box;
+
+        // Horizontal extent of the tracks on the same line
+        std::vector<std::pair<int, int>> covered;
+        for (const Track &track : tracks) {
+            const int top = std::max(box.y, track.box.y);
+            const int bottom = std::min(box.y + box.height, track.box.y + track.box.height);
+            if ((bottom - top) * 2 < std::min(box.height, track.box.height)) {
+                continue;
+            }
+            if (track.box.x < box.x + box.width && box.x < track.box.x + track.box.width) {
+                covered.emplace_back(track.box.x, track.box.x + track.box.width);
+            }
+        }
+        std::sort(covered.begin(), covered.end());
+
+        // What is left of the proposal, e.g. new text of a ticker
+        // arriving next to the text already tracked
+        const int minWidth = std::max(kMinSearchMargin, box.height);
+        int x = box.x;
+        for (const auto &range : covered) {
+            if (range.first - x >= minWidth) {
+                addTrack(cv::Rect(x, box.y, range.first - x, box.height), luma, binary);
+            }
+            x = std::max(x, range.second);
+        }
+        if (box.x + box.width - x >= minWidth) {
+            addTrack(cv::Rect(x, box.y, box.x + box.width - x, box.height), luma, binary);
+        }
+    }
+}
+
+void TextTracker::addTrack(cv::Rect box, const cv::Mat &luma, const cv::Mat &binary)
+{
+    // Columns with any text pixel (0 in the binary)
+    cv::reduce(binary(box), columnScratch, 0, cv::REDUCE_MIN);
+    const uchar *columns = columnScratch.ptr<uchar>();
+
+    // Spaces between words are wider than between the letters of a word
+    const int minGap = std::max(2, box.height / 6);
+
+    int start = 0;
+    int end = box.width;
+
+    // Cut off a word the left edge hides part of: start in the first gap
+    if (box.x <= kEdgeDistance) {
+        int run = 0;
+        int x = 0;
+        for (; x < end && run < minGap; x++) {
+            run = columns[x] ? run + 1 : 0;
+        }
+        if (run < minGap) {
+            return;
+        }
+        start = x - minGap / 2;
+    }
+
+    // Same at the right edge: end in the last gap
+    if (box.x + box.width >= frameSize.width - kEdgeDistance) {
+        int run = 0;
+        int x = end - 1;
+        for (; x >= start && run < minGap; x--) {
+            run = columns[x] ? run + 1 : 0;
+        }
+        if (run < minGap) {
+            return;
+        }
+        end = x + 1 + minGap / 2;
+    }
+
+    if (end - start < box.height) {
+        return;
+    }
+    box = cv::Rect(box.x + start, box.y, end - start, box.height);
+
+    // Nothing to read in it
+    if (isBlank(binary(box))) {
+        return;
+    }
+
+    tracks.push_back(Track{nextId++, box, luma(box).clone(), cv::Mat(), 0});
+    createdCount.fetch_add(1, std::memory_order_relaxed);
+
+    QMutexLocker locker(&mutex);
+    shared[tracks.back().id] = Shared{box, QString(), false, false};
+}
+
+void TextTracker::setText(int track, const QString &text)
+{
+    QMutexLocker locker(&mutex);
+
+    auto it = shared.find(track);
+    if (it == shared.end()) {
+        return;
+    }
+
+    Shared &state = it->second;
+    state.pending = false;
+    if (OCREnginePool::isErrorResult(text)) {
+        state.retry = true;
+        return;
+    }
+
+    // A region is a line of text; one that reads as nothing holds none
+    QString line = OCREnginePool::hasText(text) ? text.simplified() : QString();
+    if (line != state.text) {
+        state.text = line;
+        textRevision.fetch_add(1, std::memory_order_release);
+    }
+}
+
+QString TextTracker::text() const
+{
+    std::vector<TextRegions::Region> regions;
+    std::vector<std::pair<cv::Rect, QString>> texts;
+    {
+        QMutexLocker locker(&mutex);
+        for (const auto &entry : shared) {
+            if (!entry.second.text.isEmpty()) {
+                regions.push_back(TextRegions::Region{entry.second.box, 0});
+                texts.emplace_back(entry.second.box, entry.second.text);
+            }
+        }
+    }
+
+    TextRegions::sortReadingOrder(regions);
+
+    // Regions on one line are joined by a space; boxes are the keys, two
+    // tracks never keep the same box for long (see update)
+    QString result;
+    int line = -1;
+    for (const TextRegions::Region &region : regions) {
+        auto it = std::find_if(texts.begin(), texts.end(), [&](const auto &item) {
+            return item.first == region.box;
+        });
+        if (it == texts.end()) {
+            continue;
+        }
+
+        if (line >= 0) {
+            result += region.line == line ? QChar(' ') : QChar('\n');
+        }
+        result += it->second;
+        line = region.line;
+        texts.erase(it);
+    }
+    return result;
+}
+
+TextTracker::Counters TextTracker::counters() const
+{
+    Counters counters;
+    counters.frames = frameCount.load(std::memory_order_relaxed);
+    counters.followed = followedCount.load(std::memory_order_relaxed);
+    counters.unchanged = unchangedCount.load(std::memory_order_relaxed);
+    counters.created = createdCount.load(std::memory_order_relaxed);
+    counters.lost = lostCount.load(std::memory_order_relaxed);
+    counters.requests = requestCount.load(std::memory_order_relaxed);
+    counters.tracks = trackCount.load(std::memory_order_relaxed);
+    return counters;
+}
@@ -0,0 +1,140 @@
+/*
+ * texttracker.h - Text Region Tracker Header
+ *
+ * Purpose: Follows text regions from frame to frame so continuous reading
+ * only sends new or changed text to Tesseract:
+ * - Each tracked region keeps a luma template, found again in the next
+ *   frame by template matching in a small window around its position
+ * - A region is re-read when its binary pixels differ from the ones last
+ *   sent to OCR, compared block by block so one changed digit in a long
+ *   line is noticed
+ * - Every few frames, text region proposals (see TextRegions) find text
+ *   that no region covers yet. Text running into the frame edge (a
+ *   scrolling ticker) is only taken up to the last word gap, so no word
+ *   is read half visible
+ *
+ * OCR work then follows the amount of text that changed, not the frame
+ * size: a dashboard where one value changes re-reads that value only, a
+ * ticker re-reads nothing that merely moved.
+ */
+
+#ifndef TEXTTRACKER_H
+#define TEXTTRACKER_H
+
+#include <QMutex>
+#include <QString>
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <map>
+#include <vector>
+
+// update is meant for the frame thread, setText and text for any other
+// thread; they only share a short critical section
+class TextTracker
+{
+public:
+    // A region to recognize
+    struct Request {
+        int track;      // Track the text belongs to (see setText)
+        cv::Rect box;   // Position in the frame
+        cv::Mat image;  // Binary crop of the region, owned by the request
+    };
+
+    // Counters since the tracker was created
+    struct Counters {
+        quint64 frames;     // Frames tracked
+        quint64 followed;   // Regions found again in a frame (per frame)
+        quint64 unchanged;  // ... of which had the text last read
+        quint64 created;    // New regions
+        quint64 lost;       // Regions that left the frame or went blank
+        quint64 requests;   // Regions sent to OCR
+        int tracks;         // Regions tracked right now
+    };
+
+    TextTracker();
+
+    TextTracker(const TextTracker &) = delete;
+    TextTracker &operator=(const TextTracker &) = delete;
+
+    // Regions waiting for OCR at most; changed regions beyond that wait
+    // for a frame when fewer are pending. Lock-free
+    void setMaxPending(int regions);
+
+    // Follow the regions into a frame: a CV_8UC1 luma image and its OCR
+    // binary (dark text on a light background, see OcrPreprocess), same
+    // size. Returns the regions to recognize, whose text is expected back
+    // through setText
+    std::vector<Request> update(const cv::Mat &luma, const cv::Mat &binary);
+
+    // Text recognized for a request. Error results ("Error: ...") keep the
+    // previous text and have the region read again; a region that reads as
+    // no text holds none. Unknown tracks (lost meanwhile) are ignored
+    void setText(int track, const QString &text);
+
+    // Text of all regions in reading order, one line per text line
+    QString text() const;
+
+    // Bumped whenever text() may have changed. Lock-free
+    quint64 revision() const { return textRevision.load(std::memory_order_acquire); }
+
+    // Forget all regions; results of requests still pending are ignored.
+    // Frame thread
+    void reset();
+
+    Counters counters() const;
+
+private:
+    // A tracked region, frame thread only
+    struct Track {
+        int id;
+        cv::Rect box;        // Position in the last frame
+        cv::Mat patch;       // Luma of the box in the last frame
+        cv::Mat reference;   // Binary of the box when last sent to OCR
+        int misses;          // Consecutive frames it was not found in
+    };
+
+    // What a track shares with the other threads, guarded by mutex
+    struct Shared {
+        cv::Rect box;        // Position in the last frame
+        QString text;        // Last text recognized
+        bool pending;        // Sent to OCR, no text back yet
+        bool retry;          // OCR failed, send it again
+    };
+
+    // Find a track again in the frame; false if it is lost
+    bool follow(Track &track, const cv::Mat &luma);
+
+    // Check if the binary pixels of a track differ from its reference
+    bool changed(const Track &track, const cv::Mat &binary);
+
+    // Add tracks for proposed text no track covers yet
+    void discover(const cv::Mat &luma, const cv::Mat &binary);
+
+    // Start a track on a box, cut at word gaps where it meets the frame
+    // edge. Does nothing if no complete word is left
+    void addTrack(cv::Rect box, const cv::Mat &luma, const cv::Mat &binary);
+
+    // Frame thread only
+    std::vector<Track> tracks;
+    cv::Size frameSize;                   // Size tracks are positioned in
+    int nextId;                           // ID of the next new track
+    cv::Mat matchScores;                  // Scratch buffers, reused
+    cv::Mat diffScratch;
+    cv::Mat columnScratch;
+
+    // Shared with setText and text
+    mutable QMutex mutex;                 // Guards shared
+    std::map<int, Shared> shared;         // By track ID
+
+    std::atomic<int> maxPending;
+    std::atomic<quint64> textRevision;
+    std::atomic<quint64> frameCount;
+    std::atomic<quint64> followedCount;
+    std::atomic<quint64> unchangedCount;
+    std::atomic<quint64> createdCount;
+    std::atomic<quint64> lostCount;
+    std::atomic<quint64> requestCount;
+    std::atomic<int> trackCount;
+};
+
+#endif // TEXTTRACKER_H
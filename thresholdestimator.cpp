@@ -0,0 +1,145 @@
+/*
+ * thresholdestimator.cpp - Temporal Threshold Estimator Implementation
+ *
+ * Purpose: Implements the subsampled histogram, Otsu's method and the
+ * smoothing/hysteresis/lighting-change logic
+ */
+
+#include "thresholdestimator.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+
+// Pixels sampled per frame. Plenty for a stable 256-bin histogram, and
+// 1/25 of a 1080p frame
+const double kSamplePixels = 65536.0;
+
+int strideFor(const cv::Mat &luma)
+{
+    return std::max(1, int(std::sqrt(double(luma.total()) / kSamplePixels)));
+}
+
+double meanOf(const int histogram[256])
+{
+    double count = 0.0;
+    double sum = 0.0;
+    for (int i = 0; i < 256; i++) {
+        count += histogram[i];
+        sum += double(i) * histogram[i];
+    }
+    return count > 0.0 ? sum / count : 0.0;
+}
+
+} // namespace
+
+ThresholdEstimator::ThresholdEstimator(double smoothing, double hysteresis,
+                                       double lightingChange)
+    : smoothing(smoothing)
+    , hysteresis(hysteresis)
+    , lightingChange(lightingChange)
+    , primed(false)
+    , referenceMean(0.0)
+    , smoothed(0.0)
+    , current(128)
+    , estimateCount(0)
+    , fullCount(0)
+{
+}
+
+void ThresholdEstimator::reset()
+{
+    primed = false;
+}
+
+int ThresholdEstimator::otsu(const int histogram[256])
+{
+    // Same recurrence as OpenCV's getThreshVal_Otsu_8u, so a full
+    // computation matches cv::threshold(..., THRESH_OTSU)
+    double total = 0.0;
+    double mu = 0.0;
+    for (int i = 0; i < 256; i++) {
+        total += histogram[i];
+        mu += double(i) * histogram[i];
+    }
+    if (total <= 0.0) {
+        return 128;
+    }
+    mu /= total;
+
+    double q1 = 0.0;
+    double mu1 = 0.0;
+    double maxSigma = 0.0;
+    int best = 0;
+    for (int i = 0; i < 256; i++) {
+        const double p = histogram[i] / total;
+        mu1 *= q1;
+        q1 += p;
+        const double q2 = 1.0 - q1;
+
+        if (std::min(q1, q2) < FLT_EPSILON || std::max(q1, q2) > 1.0 - FLT_EPSILON) {
+            continue;
+        }
+
+        mu1 = (mu1 + i * p) / q1;
+        const double mu2 = (mu - q1 * mu1) / q2;
+        const double sigma = q1 * q2 * (mu1 - mu2) * (mu1 - mu2);
+        if (sigma > maxSigma) {
+            maxSigma = sigma;
+            best = i;
+        }
+    }
+    return best;
+}
+
+void ThresholdEstimator::sampleHistogram(const cv::Mat &luma, int stride,
+                                         int histogram[256]) const
+{
+    std::fill_n(histogram, 256, 0);
+    for (int y = 0; y < luma.rows; y += stride) {
+        const uchar *row = luma.ptr<uchar>(y);
+        for (int x = 0; x < luma.cols; x += stride) {
+            histogram[row[x]]++;
+        }
+    }
+}
+
+int ThresholdEstimator::estimate(const cv::Mat &luma)
+{
+    CV_Assert(luma.empty() || luma.type() == CV_8UC1);
+    if (luma.empty()) {
+        return current;
+    }
+    estimateCount.fetch_add(1, std::memory_order_relaxed);
+
+    int histogram[256];
+    bool full = !primed || luma.size() != frameSize;
+
+    if (!full) {
+        sampleHistogram(luma, strideFor(luma), histogram);
+
+        // A large brightness shift means the old threshold is meaningless:
+        // start over instead of slowly averaging towards the new one
+        full = std::abs(meanOf(histogram) - referenceMean) > lightingChange;
+    }
+
+    if (full) {
+        sampleHistogram(luma, 1, histogram);
+        current = otsu(histogram);
+        smoothed = current;
+        referenceMean = meanOf(histogram);
+        frameSize = luma.size();
+        primed = true;
+        fullCount.fetch_add(1, std::memory_order_relaxed);
+        return current;
+    }
+
+    // Follow the sampled threshold slowly, and only switch the one in use
+    // once the average has clearly moved away from it
+    smoothed += smoothing * (otsu(histogram) - smoothed);
+    if (std::abs(smoothed - current) >= hysteresis) {
+        current = int(std::lround(smoothed));
+    }
+    return current;
+}
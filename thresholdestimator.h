@@ -0,0 +1,71 @@
+/*
+ * thresholdestimator.h - Temporal Threshold Estimator Header
+ *
+ * Purpose: Supplies the global (Otsu) threshold of a camera stream
+ * without a full-resolution histogram per frame. The histogram is built
+ * from a strided subsample of the frame, and the resulting threshold is
+ * smoothed over time with hysteresis, so the displayed monochrome image
+ * does not flicker when the threshold jitters by a level or two.
+ *
+ * A full-resolution Otsu is only computed for the first frame, after a
+ * resolution change and when the mean brightness of the subsample moves
+ * far enough to indicate a lighting change (lights switched, auto
+ * exposure, a cut to a different scene).
+ */
+
+#ifndef THRESHOLDESTIMATOR_H
+#define THRESHOLDESTIMATOR_H
+
+#include <QtGlobal>
+#include <opencv2/core.hpp>
+#include <atomic>
+
+// Not thread-safe: one estimator per stream. The counters may be read
+// from any thread.
+class ThresholdEstimator
+{
+public:
+    // smoothing: weight of a new frame's threshold in the running average
+    // hysteresis: gray levels the average must move before the threshold
+    //             in use changes
+    // lightingChange: shift of the mean brightness (gray levels) since the
+    //                 last full computation that triggers a new one
+    explicit ThresholdEstimator(double smoothing = 0.15, double hysteresis = 2.0,
+                                double lightingChange = 12.0);
+
+    // Threshold for a CV_8UC1 luma frame, to be used like the value
+    // cv::threshold returns with THRESH_OTSU (pixels above it are white)
+    int estimate(const cv::Mat &luma);
+
+    // Forget the history; the next frame gets a full computation
+    void reset();
+
+    // Threshold currently in use
+    int threshold() const { return current; }
+
+    // Frames estimated and full-resolution computations among them
+    quint64 estimates() const { return estimateCount.load(std::memory_order_relaxed); }
+    quint64 fullComputations() const { return fullCount.load(std::memory_order_relaxed); }
+
+    // Otsu threshold of a 256-bin histogram, same rule as cv::threshold
+    static int otsu(const int histogram[256]);
+
+private:
+    // Histogram over every stride-th pixel of every stride-th row
+    void sampleHistogram(const cv::Mat &luma, int stride, int histogram[256]) const;
+
+    double smoothing;
+    double hysteresis;
+    double lightingChange;
+
+    cv::Size frameSize;      // Size of the frames seen so far
+    bool primed;             // History is valid
+    double referenceMean;    // Sample mean at the last full computation
+    double smoothed;         // Running average of the sampled thresholds
+    int current;             // Threshold in use
+
+    std::atomic<quint64> estimateCount;
+    std::atomic<quint64> fullCount;
+};
+
+#endif // THRESHOLDESTIMATOR_H
@@ -5,259 +5,623 @@
  */
 
 #include "videoprocessor.h"
+#include "monochromekernel.h"
+#include "frameingest.h"
+#include "ocrpreprocess.h"
+#include "framemailbox.h"
+#include "ocrenginepool.h"
+#include "ocrresultcache.h"
+#include "ocrmodel.h"
+#include "pipelinestats.h"
 #include <QDebug>
 #include <QImage>
+#include <QJsonObject>
+#include <QPointer>
+#include <algorithm>
+
+// FrameWorker Implementation
+FrameWorker::FrameWorker(VideoProcessor *processor, FrameMailbox *mailbox)
+    : QObject(nullptr)
+    , processor(processor)
+    , mailbox(mailbox)
+{
+}
+
+void FrameWorker::drainMailbox()
+{
+    // Usually exactly one frame; a wakeup may also find the slot empty if
+    // an earlier call already picked up the frame it was posted for
+    while (FrameMailbox::Item *item = mailbox->take()) {
+        PipelineStats::instance().record(PipelineStats::FrameWait,
+                                         quint64(PipelineStats::now() - item->postedAt));
+        processor->processFrame(item->frame, item->foreground, item->background,
+                                item->capturedMs);
+        delete item;
+    }
+}
+
+// VideoProcessor Implementation
+VideoProcessor::VideoProcessor(QObject *parent, int ocrEngines)
+    : VideoProcessor(new OCREnginePool(ocrEngines), 0, parent)
+{
+    // Own pool: a child object, stops its engines when deleted. Its
+    // threads keep the UI responsive
+    ocrPool->setParent(this);
+}
 
-// OCRWorker Implementation
-OCRWorker::OCRWorker(QObject *parent)
+VideoProcessor::VideoProcessor(OCREnginePool *sharedPool, int sourceId, QObject *parent)
     : QObject(parent)
-    , tessApi(nullptr)
-{
-    // Initialize Tesseract API
-    tessApi = new tesseract::TessBaseAPI();
-
-    // Initialize with English language
-    // Make sure tessdata folder exists in application directory
-    // or set TESSDATA_PREFIX environment variable
-    if (tessApi->Init(nullptr, "eng")) {
-        qWarning() << "Could not initialize Tesseract API";
-        qWarning() << "Make sure tessdata folder is in the application directory";
-        delete tessApi;
-        tessApi = nullptr;
-    } else {
-        // Set page segmentation mode for better OCR results
-        // PSM_AUTO: Fully automatic page segmentation
-        tessApi->SetPageSegMode(tesseract::PSM_AUTO);
+    , ocrPool(sharedPool)
+    , source(sourceId)
+    , frameThread(nullptr)
+    , frameWorker(nullptr)
+    , frameMailbox(new FrameMailbox())
+    , processedFrames(0)
+    , continuousMode(false)
+    , continuousStableFrames(10)
+    , autoOCRCount(0)
+    , sceneDetectorActive(false)
+    , textTracking(false)
+    , textTrackerActive(false)
+    , trackedRevision(0)
+    , displaySink(nullptr)
+    , displayPending(false)
+    , displayedFrames(0)
+    , displayDroppedFrames(0)
+    , threshold(ThresholdMethod::Otsu)
+    , foregroundColor(Qt::white)
+    , backgroundColor(Qt::black)
+{
+    // Results arrive in submission order, forward them as they come
+    connect(ocrPool, &OCREnginePool::ocrComplete,
+            this, &VideoProcessor::onPoolResult);
+
+    // Lines are passed on as they are, for progressive display
+    connect(ocrPool, &OCREnginePool::ocrLine,
+            this, &VideoProcessor::onPoolLine);
+
+    // Create frame processing worker and thread
+    frameThread = new QThread(this);
+    frameWorker = new FrameWorker(this, frameMailbox);
+    frameWorker->moveToThread(frameThread);
+
+    connect(frameThread, &QThread::finished,
+            frameWorker, &FrameWorker::deleteLater);
+
+    frameThread->start();
+}
+
+VideoProcessor::~VideoProcessor()
+{
+    // Stop the frame thread first, it may still be submitting OCR work
+    if (frameThread) {
+        frameThread->quit();
+        frameThread->wait();
     }
+
+    // An own OCR pool is a child object and stops its engines when
+    // deleted; a shared one stays, with this source's results unclaimed
+
+    delete frameMailbox;
 }
 
-OCRWorker::~OCRWorker()
+void VideoProcessor::submitFrame(const QVideoFrame &frame,
+                                 const QColor &fgColor,
+                                 const QColor &bgColor)
 {
-    // Clean up Tesseract API
-    if (tessApi) {
-        tessApi->End();
-        delete tessApi;
+    // Only wake the worker when the slot was empty, otherwise a wakeup
+    // is already pending and will pick up this newer frame
+    if (frameMailbox->post(frame, fgColor, bgColor)) {
+        QMetaObject::invokeMethod(frameWorker, &FrameWorker::drainMailbox,
+                                  Qt::QueuedConnection);
     }
 }
 
-void OCRWorker::processOCR(const cv::Mat &image)
+VideoProcessor::FrameCounters VideoProcessor::frameCounters() const
 {
-    QString result;
+    FrameCounters counters;
+    counters.received = frameMailbox->received();
+    counters.processed = processedFrames.load(std::memory_order_relaxed);
+    counters.dropped = frameMailbox->dropped();
+    counters.autoOCR = autoOCRCount.load(std::memory_order_relaxed);
+    counters.displayed = displayedFrames.load(std::memory_order_relaxed);
+    counters.displayDropped = displayDroppedFrames.load(std::memory_order_relaxed);
+    counters.bufferAllocations = frameArena.allocations() + displayPool.allocations();
+    counters.thresholdFull = thresholdEstimator.fullComputations();
+    return counters;
+}
 
-    // Check if Tesseract is initialized
-    if (!tessApi) {
-        result = "Error: Tesseract not initialized";
-        emit ocrComplete(result);
-        return;
+void VideoProcessor::setContinuousMode(bool enabled, int stableFrames)
+{
+    if (enabled && !continuousMode.load()) {
+        // Report the first reading of a new session even if it matches
+        lastContinuousText.clear();
     }
 
-    // Check if image is valid
-    if (image.empty()) {
-        result = "Error: Invalid image";
-        emit ocrComplete(result);
-        return;
+    continuousStableFrames.store(std::max(1, stableFrames));
+    continuousMode.store(enabled);
+}
+
+bool VideoProcessor::isContinuousMode() const
+{
+    return continuousMode.load();
+}
+
+void VideoProcessor::setTextTracking(bool enabled)
+{
+    if (enabled && !textTracking.load()) {
+        // Report the first reading of a new session even if it matches
+        lastTrackedText.clear();
     }
 
-    try {
-        // Set the image for OCR processing
-        // Tesseract expects grayscale or color image
-        tessApi->SetImage(image.data, image.cols, image.rows,
-                          image.channels(), image.step);
+    // Two regions per engine in flight keep the engines busy without
+    // queueing up behind the other sources of a shared pool
+    textTracker.setMaxPending(2 * ocrPool->engineCount());
+    textTracking.store(enabled);
+}
 
-        // Perform OCR and get text
-        char* outText = tessApi->GetUTF8Text();
+bool VideoProcessor::isTextTracking() const
+{
+    return textTracking.load();
+}
 
-        if (outText) {
-            result = QString::fromUtf8(outText);
-            delete[] outText;  // Free memory allocated by Tesseract
-        } else {
-            result = "No text recognized";
-        }
+TextTracker::Counters VideoProcessor::textTrackingCounters() const
+{
+    return textTracker.counters();
+}
+
+void VideoProcessor::reportTrackedText()
+{
+    if (!textTracking.load()) {
+        return;
+    }
 
-    } catch (const std::exception &e) {
-        result = QString("OCR Error: %1").arg(e.what());
-        qWarning() << result;
+    QString text = textTracker.text();
+    if (text == lastTrackedText) {
+        return;
     }
+    lastTrackedText = text;
 
-    // Emit the result
-    emit ocrComplete(result);
+    emit ocrComplete(text);
 }
 
-// VideoProcessor Implementation
-VideoProcessor::VideoProcessor(QObject *parent)
-    : QObject(parent)
-    , ocrThread(nullptr)
-    , ocrWorker(nullptr)
-    , foregroundColor(Qt::white)
-    , backgroundColor(Qt::black)
+void VideoProcessor::onPoolResult(int sourceId, quint64 jobId, const QString &text)
 {
-    // Create OCR worker and thread
-    ocrThread = new QThread(this);
-    ocrWorker = new OCRWorker();
+    // Results of the other cameras sharing the pool
+    if (sourceId != source) {
+        return;
+    }
+
+    emit ocrResult(jobId, text);
 
-    // Move worker to separate thread to avoid blocking UI
-    ocrWorker->moveToThread(ocrThread);
+    // Text of one tracked region: report the text of all of them
+    int track = -1;
+    {
+        QMutexLocker locker(&trackJobsMutex);
+        auto it = trackJobs.find(jobId);
+        if (it != trackJobs.end()) {
+            track = it.value();
+            trackJobs.erase(it);
+        }
+    }
+    if (track >= 0) {
+        textTracker.setText(track, text);
+        reportTrackedText();
+        return;
+    }
 
-    // Connect signals and slots
-    connect(this, &VideoProcessor::requestOCR,
-            ocrWorker, &OCRWorker::processOCR);
+    // A newer capture replaced this one, its result follows
+    if (text == QLatin1String(OCREnginePool::kSupersededText)) {
+        return;
+    }
 
-    connect(ocrWorker, &OCRWorker::ocrComplete,
-            this, &VideoProcessor::ocrComplete);
+    bool continuous = false;
+    {
+        QMutexLocker locker(&continuousJobsMutex);
+        continuous = continuousJobs.remove(jobId);
+    }
 
-    // Clean up worker when thread finishes
-    connect(ocrThread, &QThread::finished,
-            ocrWorker, &OCRWorker::deleteLater);
+    if (continuous) {
+        // Only report auto OCR passes that read something new
+        QString trimmed = text.trimmed();
+        if (trimmed == lastContinuousText) {
+            return;
+        }
+        lastContinuousText = trimmed;
+    }
 
-    // Start the OCR thread
-    ocrThread->start();
+    emit ocrComplete(text);
 }
 
-VideoProcessor::~VideoProcessor()
+void VideoProcessor::onPoolLine(int sourceId, quint64 jobId, const OcrLine &line)
 {
-    // Stop and wait for OCR thread to finish
-    if (ocrThread) {
-        ocrThread->quit();
-        ocrThread->wait();
+    if (sourceId == source) {
+        emit ocrLine(jobId, line);
     }
 }
 
-void VideoProcessor::setColorScheme(const QColor &fgColor, const QColor &bgColor)
+int VideoProcessor::ocrEngineCount() const
 {
-    foregroundColor = fgColor;
-    backgroundColor = bgColor;
+    return ocrPool->engineCount();
 }
 
-cv::Mat VideoProcessor::videoFrameToMat(QVideoFrame &frame)
+void VideoProcessor::setRegionProposals(bool enabled)
 {
-    // Ensure frame is mapped to memory for reading
-    if (!frame.map(QVideoFrame::ReadOnly)) {
-        qWarning() << "Failed to map video frame";
-        return cv::Mat();
-    }
+    ocrPool->setRegionProposals(enabled);
+}
 
-    // Get frame properties
-    QSize frameSize = frame.size();
-    int width = frameSize.width();
-    int height = frameSize.height();
+void VideoProcessor::setPrescaleHeight(int pixels)
+{
+    ocrPool->setPrescaleHeight(pixels);
+}
 
-    // Convert QVideoFrame to QImage first
-    QImage image = frame.toImage();
+void VideoProcessor::setOCRDeadline(int msecs)
+{
+    ocrPool->setDeadline(msecs);
+}
 
-    // Unmap the frame
-    frame.unmap();
+void VideoProcessor::setCaptureFusion(int frames, FusionMethod method)
+{
+    captureFusion.configure(frames, method);
+}
 
-    // Check if conversion was successful
-    if (image.isNull()) {
-        qWarning() << "Failed to convert video frame to image";
-        return cv::Mat();
-    }
+void VideoProcessor::clearCaptureFusion()
+{
+    captureFusion.clear();
+}
 
-    // Convert QImage to OpenCV Mat
-    // QImage format: RGB32 or ARGB32 (4 bytes per pixel)
-    image = image.convertToFormat(QImage::Format_RGB888);
+OCRResultCache *VideoProcessor::ocrCache()
+{
+    return ocrPool->resultCache();
+}
 
-    // Create OpenCV Mat from QImage data
-    cv::Mat mat(image.height(), image.width(), CV_8UC3,
-                const_cast<uchar*>(image.bits()), image.bytesPerLine());
+QJsonObject VideoProcessor::statsSnapshot() const
+{
+    QJsonObject json = PipelineStats::instance().toJson();
+
+    const QJsonObject own = sourceSnapshot();
+    json["frames"] = own["frames"];
+
+    OCRResultCache::Stats cacheStats = ocrPool->resultCache()->stats();
+    QJsonObject cache;
+    cache["hits"] = double(cacheStats.hits);
+    cache["perceptual_hits"] = double(cacheStats.perceptualHits);
+    cache["misses"] = double(cacheStats.misses);
+    cache["entries"] = cacheStats.entries;
+    cache["bytes"] = double(cacheStats.bytes);
+    json["ocr_cache"] = cache;
+
+    json["ocr_engines"] = ocrPool->engineCount();
+    json["ocr_cancelled"] = double(ocrPool->cancelledJobs());
+    json["ocr_source"] = own["ocr"];
+    json["text_tracking"] = own["text_tracking"];
+    json["ocr_model"] = OcrModel::shared().toJson();
+    json["threshold"] = thresholdMethodName(thresholdMethod());
+
+    QJsonObject fusion;
+    fusion["frames"] = captureFusion.capacity();
+    fusion["last_fused"] = captureFusion.lastFused();
+    json["capture_fusion"] = fusion;
+    return json;
+}
+
+QJsonObject VideoProcessor::sourceSnapshot() const
+{
+    const double seconds = std::max(PipelineStats::instance().elapsedSeconds(), 1e-9);
+
+    FrameCounters counters = frameCounters();
+    QJsonObject frames;
+    frames["received"] = double(counters.received);
+    frames["processed"] = double(counters.processed);
+    frames["dropped"] = double(counters.dropped);
+    frames["auto_ocr"] = double(counters.autoOCR);
+    frames["displayed"] = double(counters.displayed);
+    frames["display_dropped"] = double(counters.displayDropped);
+    frames["buffer_allocations"] = double(counters.bufferAllocations);
+    frames["threshold_full"] = double(counters.thresholdFull);
+    frames["arena_bytes"] = double(frameArena.bytes());
+    frames["processed_per_s"] = counters.processed / seconds;
+
+    TextTracker::Counters trackCounters = textTracker.counters();
+    QJsonObject tracking;
+    tracking["enabled"] = isTextTracking();
+    tracking["frames"] = double(trackCounters.frames);
+    tracking["regions"] = trackCounters.tracks;
+    tracking["created"] = double(trackCounters.created);
+    tracking["lost"] = double(trackCounters.lost);
+    tracking["followed"] = double(trackCounters.followed);
+    tracking["unchanged"] = double(trackCounters.unchanged);
+    tracking["ocr_regions"] = double(trackCounters.requests);
+
+    QJsonObject json;
+    json["frames"] = frames;
+    json["ocr"] = ocrPool->sourceStatsJson(source);
+    json["text_tracking"] = tracking;
+    return json;
+}
+
+void VideoProcessor::setColorScheme(const QColor &fgColor, const QColor &bgColor)
+{
+    foregroundColor = fgColor;
+    backgroundColor = bgColor;
+}
 
-    // Clone the Mat to ensure data persistence
-    // (QImage data may be deleted when image goes out of scope)
-    return mat.clone();
+void VideoProcessor::setThresholdMethod(ThresholdMethod method)
+{
+    threshold.store(method, std::memory_order_relaxed);
+}
+
+ThresholdMethod VideoProcessor::thresholdMethod() const
+{
+    return threshold.load(std::memory_order_relaxed);
+}
+
+void VideoProcessor::setDisplaySink(QVideoSink *sink)
+{
+    displaySink.store(sink, std::memory_order_release);
 }
 
-cv::Mat VideoProcessor::convertToMonochrome(const cv::Mat &input,
-                                            const QColor &fgColor,
-                                            const QColor &bgColor)
+void VideoProcessor::convertToMonochrome(const cv::Mat &input,
+                                         cv::Mat &output,
+                                         const QColor &fgColor,
+                                         const QColor &bgColor)
 {
     // Check if input is valid
     if (input.empty()) {
-        return cv::Mat();
+        return;
     }
 
-    // Convert to grayscale first
+    // Convert to grayscale first. Intermediate images come from the
+    // arena, so the steady state allocates nothing
     cv::Mat gray;
     if (input.channels() == 3) {
+        gray = frameArena.acquire(FrameArena::Gray, input.size(), CV_8UC1);
         cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
     } else if (input.channels() == 4) {
+        gray = frameArena.acquire(FrameArena::Gray, input.size(), CV_8UC1);
         cv::cvtColor(input, gray, cv::COLOR_BGRA2GRAY);
     } else {
-        gray = input.clone();
+        // Already luma (see FrameIngest), threshold reads it in place
+        gray = input;
     }
 
-    // Apply binary threshold to create monochrome image
-    // This converts grayscale to pure black and white
-    cv::Mat binary;
-    cv::threshold(gray, binary, 128, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
-
-    // Create color monochrome image with custom colors
-    cv::Mat colorMono(binary.size(), CV_8UC3);
-
     // Get color values
     cv::Vec3b fg(fgColor.blue(), fgColor.green(), fgColor.red());  // BGR order
     cv::Vec3b bg(bgColor.blue(), bgColor.green(), bgColor.red());
 
-    // Apply custom colors
-    for (int y = 0; y < binary.rows; y++) {
-        for (int x = 0; x < binary.cols; x++) {
-            // If pixel is white in binary image, use foreground color
-            // Otherwise use background color
-            if (binary.at<uchar>(y, x) > 128) {
-                colorMono.at<cv::Vec3b>(y, x) = fg;
-            } else {
-                colorMono.at<cv::Vec3b>(y, x) = bg;
-            }
+    // Apply binary threshold to create monochrome image
+    // This converts grayscale to pure black and white
+    cv::Mat &binary = frameArena.acquire(FrameArena::Binary, gray.size(), CV_8UC1);
+    {
+        ScopedStageTimer timer(PipelineStats::Threshold);
+        ThresholdMethod method = thresholdMethod();
+        if (method == ThresholdMethod::Otsu) {
+            // Otsu from a subsampled histogram, smoothed across frames so
+            // the display does not flicker (see ThresholdEstimator)
+            int level = thresholdEstimator.estimate(gray);
+            cv::threshold(gray, binary, level, 255, cv::THRESH_BINARY);
+        } else {
+            // Local threshold, placed relative to the text the scheme
+            // is meant for; white still marks the brighter pixels
+            displayBinarizer.setMethod(method);
+            displayBinarizer.apply(gray, binary, OcrPreprocess::isLightText(fg, bg));
         }
     }
 
-    return colorMono;
+    // Apply custom colors: pixels that are white in the binary image get
+    // the foreground color, all others the background color.
+    // Vectorized and row-parallel, see monochromekernel.cpp
+    {
+        ScopedStageTimer timer(PipelineStats::Colorize);
+        if (output.type() == CV_8UC4) {
+            MonochromeKernel::colorizeBgrx(binary, output, fg, bg);
+        } else {
+            MonochromeKernel::colorize(binary, output, fg, bg);
+        }
+    }
+}
+
+void VideoProcessor::displayMonochrome(const QVideoFrame &source,
+                                       const cv::Mat &luma,
+                                       const QColor &fgColor,
+                                       const QColor &bgColor)
+{
+    QVideoSink *sink = displaySink.load(std::memory_order_acquire);
+    if (!sink) {
+        return;
+    }
+
+    // Latest wins: while the GUI thread has not shown the previous frame,
+    // rendering another one would only build up a queue
+    if (displayPending.load(std::memory_order_acquire)) {
+        displayDroppedFrames.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    QVideoFrame &output = displayPool.nextFrame(QSize(luma.cols, luma.rows));
+    if (!output.map(QVideoFrame::WriteOnly)) {
+        qWarning() << "Failed to map display frame";
+        return;
+    }
+
+    // Colorize straight into the frame's memory, no intermediate image
+    cv::Mat target(output.height(), output.width(), CV_8UC4,
+                   output.bits(0), output.bytesPerLine(0));
+    convertToMonochrome(luma, target, fgColor, bgColor);
+    output.unmap();
+
+    output.setStartTime(source.startTime());
+    output.setEndTime(source.endTime());
+
+    // Hand over a shallow copy; the pool keeps using its own reference
+    displayPending.store(true, std::memory_order_release);
+    QPointer<QVideoSink> sinkGuard(sink);
+    QVideoFrame shown = output;
+    QMetaObject::invokeMethod(this, [this, sinkGuard, shown]() {
+        if (sinkGuard && displaySink.load(std::memory_order_acquire) == sinkGuard) {
+            sinkGuard->setVideoFrame(shown);
+            displayedFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+        displayPending.store(false, std::memory_order_release);
+    }, Qt::QueuedConnection);
 }
 
 void VideoProcessor::processFrame(QVideoFrame &frame,
                                   const QColor &fgColor,
-                                  const QColor &bgColor)
+                                  const QColor &bgColor,
+                                  qint64 capturedMs)
 {
-    // Convert video frame to OpenCV Mat
-    cv::Mat mat = videoFrameToMat(frame);
+    ScopedStageTimer totalTimer(PipelineStats::FrameTotal);
+    processedFrames.fetch_add(1, std::memory_order_relaxed);
+
+    // Get the frame's luma plane, zero copy for the common YUV formats
+    const qint64 ingestStart = PipelineStats::now();
+    FrameIngest ingest(frame, &frameArena);
+    PipelineStats::instance().record(PipelineStats::Ingest,
+                                     quint64(PipelineStats::now() - ingestStart));
 
-    if (mat.empty()) {
+    if (!ingest.isValid()) {
         return;
     }
 
-    // Convert to monochrome with specified colors
-    cv::Mat monochrome = convertToMonochrome(mat, fgColor, bgColor);
+    // Keep the frame for denoised captures
+    captureFusion.push(ingest.luma());
+
+    // Continuous mode: OCR once whenever the scene settles after a change
+    if (continuousMode.load(std::memory_order_relaxed)) {
+        sceneDetectorActive = true;
+        sceneDetector.setStableFrames(continuousStableFrames.load(std::memory_order_relaxed));
+
+        bool stable;
+        {
+            ScopedStageTimer timer(PipelineStats::SceneDetect);
+            stable = sceneDetector.update(ingest.luma());
+        }
+
+        if (stable) {
+            autoOCRCount.fetch_add(1, std::memory_order_relaxed);
+
+            // Hold the lock across submit so the result cannot be handled
+            // before the job is known to be a continuous one
+            QMutexLocker locker(&continuousJobsMutex);
+            continuousJobs.insert(performOCR(ingest.luma(), fgColor, bgColor, false, capturedMs));
+        }
+    } else if (sceneDetectorActive) {
+        // Start from scratch the next time continuous mode is enabled
+        sceneDetector.reset();
+        sceneDetectorActive = false;
+    }
+
+    // Text tracking: OCR only the regions that are new or changed
+    if (textTracking.load(std::memory_order_relaxed)) {
+        textTrackerActive = true;
+        trackText(ingest.luma(), fgColor, bgColor, capturedMs);
+    } else if (textTrackerActive) {
+        // Start from scratch the next time tracking is enabled
+        textTracker.reset();
+        textTrackerActive = false;
+    }
 
-    // Note: The processed frame is not displayed back to the video widget
-    // in this implementation. If you want to display the processed frame,
-    // you would need to convert the Mat back to QVideoFrame and emit it
-    // through a custom video sink. This is left as an exercise or can be
-    // implemented if needed.
+    // Convert to monochrome with specified colors and show the result
+    displayMonochrome(frame, ingest.luma(), fgColor, bgColor);
 }
 
-void VideoProcessor::performOCR(QVideoFrame &frame,
-                                const QColor &fgColor,
-                                const QColor &bgColor)
+void VideoProcessor::trackText(const cv::Mat &luma,
+                               const QColor &fgColor,
+                               const QColor &bgColor,
+                               qint64 capturedMs)
 {
-    // Convert video frame to OpenCV Mat
-    cv::Mat mat = videoFrameToMat(frame);
+    cv::Vec3b fg(fgColor.blue(), fgColor.green(), fgColor.red());  // BGR order
+    cv::Vec3b bg(bgColor.blue(), bgColor.green(), bgColor.red());
+
+    // Regions are compared and cropped in the binary Tesseract reads
+    std::vector<TextTracker::Request> requests;
+    {
+        ScopedStageTimer timer(PipelineStats::TextTrack);
+        cv::Mat &binary = frameArena.acquire(FrameArena::OcrBinary, luma.size(), CV_8UC1);
+        OcrPreprocess::binarize(luma, binary, OcrPreprocess::isLightText(fg, bg),
+                                thresholdMethod());
+        requests = textTracker.update(luma, binary);
+    }
 
-    if (mat.empty()) {
+    // Hold the lock across submit so a result cannot be handled before
+    // the job is known to be a region's
+    if (!requests.empty()) {
+        QMutexLocker locker(&trackJobsMutex);
+        for (const TextTracker::Request &request : requests) {
+            trackJobs.insert(ocrPool->submit(request.image, false, source,
+                                             OCREnginePool::Layout::SingleLine, capturedMs),
+                             request.track);
+        }
+    }
+
+    // Regions left the frame or went blank: report the text without them
+    const quint64 revision = textTracker.revision();
+    if (revision != trackedRevision) {
+        trackedRevision = revision;
+        QMetaObject::invokeMethod(this, [this]() {
+            reportTrackedText();
+        }, Qt::QueuedConnection);
+    }
+}
+
+quint64 VideoProcessor::performOCR(QVideoFrame &frame,
+                                   const QColor &fgColor,
+                                   const QColor &bgColor)
+{
+    // Denoised capture: the recent frames aligned and fused. The newest
+    // of them was taken about when the captured frame was
+    if (captureFusion.capacity() > 1) {
+        cv::Mat fused;
+        int used;
+        {
+            ScopedStageTimer timer(PipelineStats::CaptureFusion);
+            used = captureFusion.fuse(fused);
+        }
+        if (used > 0) {
+            return performOCR(fused, fgColor, bgColor, true);
+        }
+    }
+
+    // Get the frame's luma plane, zero copy for the common YUV formats
+    FrameIngest ingest(frame);
+
+    if (!ingest.isValid()) {
         emit ocrComplete("Error: Could not process frame");
-        return;
+        return kNoJob;
     }
 
-    // Convert to monochrome for better OCR results
-    cv::Mat monochrome = convertToMonochrome(mat, fgColor, bgColor);
+    return performOCR(ingest.luma(), fgColor, bgColor, true);
+}
 
-    if (monochrome.empty()) {
-        emit ocrComplete("Error: Could not convert to monochrome");
-        return;
+quint64 VideoProcessor::performOCR(const cv::Mat &image,
+                                   const QColor &fgColor,
+                                   const QColor &bgColor,
+                                   bool interactive,
+                                   qint64 capturedMs)
+{
+    // Reduce color input to luma, luma input is used as is
+    cv::Mat luma;
+    if (image.channels() == 3) {
+        cv::cvtColor(image, luma, cv::COLOR_BGR2GRAY);
+    } else if (image.channels() == 4) {
+        cv::cvtColor(image, luma, cv::COLOR_BGRA2GRAY);
+    } else {
+        luma = image;
     }
 
-    // Convert to grayscale for Tesseract (it works better with grayscale)
-    cv::Mat gray;
-    cv::cvtColor(monochrome, gray, cv::COLOR_BGR2GRAY);
+    // Threshold luma straight into dark-on-light binary for Tesseract.
+    // The scheme colors only decide the polarity, colorizing is for display.
+    cv::Vec3b fg(fgColor.blue(), fgColor.green(), fgColor.red());  // BGR order
+    cv::Vec3b bg(bgColor.blue(), bgColor.green(), bgColor.red());
+
+    cv::Mat binary;
+    {
+        ScopedStageTimer timer(PipelineStats::OcrPreprocess);
+        OcrPreprocess::binarize(luma, binary, OcrPreprocess::isLightText(fg, bg),
+                                thresholdMethod());
+    }
 
-    // Request OCR processing in worker thread
-    emit requestOCR(gray);
+    // Queue OCR on the next free engine of the pool
+    return ocrPool->submit(binary, interactive, source, OCREnginePool::Layout::Page, capturedMs);
 }
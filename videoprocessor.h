@@ -2,9 +2,16 @@
  * videoprocessor.h - Video Frame Processor Header
  *
  * Purpose: Handles video frame processing including:
- * - Conversion from QVideoFrame to OpenCV Mat
- * - Monochrome conversion with custom color schemes
- * - OCR processing using Tesseract
+ * - Conversion from QVideoFrame to a luma Mat (see FrameIngest)
+ * - Denoising captures by fusing the last few frames (see FrameFusion)
+ * - Monochrome conversion with custom color schemes, rendered into a
+ *   pool of display frames (see DisplayFramePool), thresholded globally
+ *   (Otsu, estimated over time by ThresholdEstimator) or locally (see
+ *   AdaptiveBinarizer)
+ * - OCR processing using Tesseract (see OCREnginePool). Several
+ *   processors (one per camera) can share one pool as separate sources
+ * - Reading only the text that changed, by tracking text regions from
+ *   frame to frame (see TextTracker)
  */
 
 #ifndef VIDEOPROCESSOR_H
@@ -15,29 +22,44 @@
 #include <QImage>
 #include <QColor>
 #include <QThread>
+#include <QMutex>
+#include <QSet>
+#include <QHash>
+#include <QJsonObject>
+#include <QVideoSink>
 #include <opencv2/opencv.hpp>
 #include <tesseract/baseapi.h>
+#include <atomic>
+#include "scenechangedetector.h"
+#include "displayframepool.h"
+#include "framearena.h"
+#include "adaptivebinarizer.h"
+#include "thresholdestimator.h"
+#include "framefusion.h"
+#include "texttracker.h"
+#include "ocrline.h"
 
-// Worker class for OCR processing in separate thread
-// This prevents UI freezing during OCR operations
-class OCRWorker : public QObject
+class FrameMailbox;
+class OCREnginePool;
+class OCRResultCache;
+class VideoProcessor;
+
+// Worker class for per-frame processing in a separate thread.
+// Drains the latest-frame mailbox so the GUI thread never waits on a frame
+class FrameWorker : public QObject
 {
     Q_OBJECT
 
 public:
-    explicit OCRWorker(QObject *parent = nullptr);
-    ~OCRWorker();
+    FrameWorker(VideoProcessor *processor, FrameMailbox *mailbox);
 
 public slots:
-    // Slot: Process OCR on the given image
-    void processOCR(const cv::Mat &image);
-
-signals:
-    // Signal: Emitted when OCR processing is complete
-    void ocrComplete(const QString &text);
+    // Slot: Process whatever frame is waiting in the mailbox
+    void drainMailbox();
 
 private:
-    tesseract::TessBaseAPI *tessApi;  // Tesseract OCR API instance
+    VideoProcessor *processor;  // Processor doing the actual work
+    FrameMailbox *mailbox;      // Source of frames (owned by the processor)
 };
 
 // Main video processor class
@@ -46,35 +68,212 @@ class VideoProcessor : public QObject
     Q_OBJECT
 
 public:
-    explicit VideoProcessor(QObject *parent = nullptr);
+    // ocrEngines: number of parallel Tesseract engines, 0 = one per physical core
+    explicit VideoProcessor(QObject *parent = nullptr, int ocrEngines = 0);
+
+    // Processor that submits its OCR to a pool shared with other
+    // processors, as the given source (see OCREnginePool::submit).
+    // The pool must outlive the processor
+    VideoProcessor(OCREnginePool *sharedPool, int sourceId, QObject *parent = nullptr);
     ~VideoProcessor();
 
-    // Process a video frame: convert to monochrome and update display
-    void processFrame(QVideoFrame &frame, const QColor &fgColor, const QColor &bgColor);
+    // Source ID of this processor's OCR jobs in the pool
+    int sourceId() const { return source; }
+
+    // OCR pool, owned or shared
+    OCREnginePool *ocrEnginePool() const { return ocrPool; }
+
+    // Frame counters of the processing thread
+    struct FrameCounters {
+        quint64 received;   // Frames handed to submitFrame
+        quint64 processed;  // Frames run through processFrame
+        quint64 dropped;    // Frames replaced by a newer one before processing
+        quint64 autoOCR;    // OCR passes started by continuous mode
+        quint64 displayed;  // Processed frames handed to the display sink
+        quint64 displayDropped;  // Not displayed, the display was behind
+        quint64 bufferAllocations;  // Frame buffers (re)allocated, see FrameArena
+        quint64 thresholdFull;      // Full-resolution Otsu computations
+    };
+
+    // Queue a frame for the processing thread. Never blocks: if the
+    // previous frame has not been picked up yet it is dropped.
+    void submitFrame(const QVideoFrame &frame, const QColor &fgColor, const QColor &bgColor);
+
+    // Get a snapshot of the frame counters (callable from any thread)
+    FrameCounters frameCounters() const;
+
+    // Process a video frame: convert to monochrome and update display.
+    // Runs on the processing thread when frames come through submitFrame.
+    // The monochrome image is only computed while a display sink is set.
+    // capturedMs: when the frame was taken (ms since the epoch), -1 = now;
+    // reported with the results of its OCR jobs
+    void processFrame(QVideoFrame &frame, const QColor &fgColor, const QColor &bgColor,
+                      qint64 capturedMs = -1);
+
+    // Returned by performOCR when no job could be started
+    static constexpr quint64 kNoJob = ~quint64(0);
+
+    // Perform OCR on a captured frame. This is an interactive request:
+    // it replaces earlier captures that are still waiting or running.
+    // With capture fusion, the last frames of the stream are fused
+    // instead of reading this frame alone.
+    // Returns the job ID, or kNoJob if the frame could not be read
+    quint64 performOCR(QVideoFrame &frame, const QColor &fgColor, const QColor &bgColor);
+
+    // Perform OCR on a BGR, BGRA or luma image (e.g. from a file).
+    // Returns the job ID reported back through ocrResult. See
+    // OCREnginePool::submit for interactive
+    quint64 performOCR(const cv::Mat &image, const QColor &fgColor, const QColor &bgColor,
+                       bool interactive = false, qint64 capturedMs = -1);
+
+    // Number of parallel OCR engines
+    int ocrEngineCount() const;
+
+    // The settings below belong to the OCR pool: with a shared pool they
+    // apply to all of its sources
+
+    // Recognize proposed text regions only (default) or whole frames
+    void setRegionProposals(bool enabled);
+
+    // Glyph height OCR input is rescaled to, 0 = native resolution
+    // (see OcrPrescale)
+    void setPrescaleHeight(int pixels);
+
+    // Give up on OCR jobs not done within msecs of the request, 0 = never
+    void setOCRDeadline(int msecs);
+
+    // Fuse the last frames processed (up to 16) into a denoised image
+    // for captures, 0 or 1 to OCR the captured frame alone (default).
+    // Costs a luma copy per processed frame while enabled
+    void setCaptureFusion(int frames, FusionMethod method = FusionMethod::Average);
+
+    // Forget the frames kept for fused captures, so a capture only fuses
+    // frames processed from now on (the camera was stopped or started)
+    void clearCaptureFusion();
 
-    // Perform OCR on a captured frame
-    void performOCR(QVideoFrame &frame, const QColor &fgColor, const QColor &bgColor);
+    // Cache of recent OCR results (limits, tolerance, hit/miss counters)
+    OCRResultCache *ocrCache();
+
+    // Per-stage latencies (see PipelineStats), frame counters and cache
+    // counters as one JSON object. Callable from any thread
+    QJsonObject statsSnapshot() const;
+
+    // This processor's frame counters and OCR source counters (see
+    // OCREnginePool::sourceStatsJson). Callable from any thread
+    QJsonObject sourceSnapshot() const;
+
+    // Continuous mode: OCR automatically whenever the scene has changed
+    // and then stayed still for stableFrames frames. ocrComplete is only
+    // emitted for these passes when the recognized text differs from
+    // the previous one.
+    void setContinuousMode(bool enabled, int stableFrames = 10);
+    bool isContinuousMode() const;
+
+    // Text tracking: follow the text regions of every processed frame and
+    // OCR only regions that are new or whose pixels changed. ocrComplete
+    // is emitted with the text of all regions whenever it changes
+    void setTextTracking(bool enabled);
+    bool isTextTracking() const;
+
+    // Region counters of text tracking (callable from any thread)
+    TextTracker::Counters textTrackingCounters() const;
 
     // Set the color scheme for monochrome conversion
     void setColorScheme(const QColor &fgColor, const QColor &bgColor);
 
+    // Set how frames are thresholded, for display and for OCR
+    void setThresholdMethod(ThresholdMethod method);
+    ThresholdMethod thresholdMethod() const;
+
+    // Show processed frames on this sink (e.g. QVideoWidget::videoSink()),
+    // or nullptr to stop. The sink must live in the processor's thread and
+    // outlive the processor. If the display has not taken the previous
+    // frame yet, a processed frame is dropped instead of queued
+    void setDisplaySink(QVideoSink *sink);
+
 signals:
-    // Signal: Emitted when OCR processing is complete
+    // Signal: Emitted when OCR processing is complete (in request order).
+    // Not emitted for captures replaced by a newer one
     void ocrComplete(const QString &text);
 
-    // Signal: Request OCR processing in worker thread
-    void requestOCR(const cv::Mat &image);
+    // Signal: One text line of a job, as soon as it is recognized and
+    // before the job's ocrComplete (see OCREnginePool::ocrLine)
+    void ocrLine(quint64 jobId, const OcrLine &line);
+
+    // Signal: Same as ocrComplete, with the job ID returned by performOCR
+    void ocrResult(quint64 jobId, const QString &text);
+
+private slots:
+    // Slot: Called for every pool result, in submission order per source
+    void onPoolResult(int sourceId, quint64 jobId, const QString &text);
+
+    // Slot: Called for every line the pool recognizes
+    void onPoolLine(int sourceId, quint64 jobId, const OcrLine &line);
 
 private:
-    // Convert QVideoFrame to OpenCV Mat
-    cv::Mat videoFrameToMat(QVideoFrame &frame);
+    // Convert to monochrome using specified colors into output, which is
+    // either CV_8UC3 BGR or CV_8UC4 BGRX (e.g. wrapping a display frame)
+    void convertToMonochrome(const cv::Mat &input, cv::Mat &output,
+                             const QColor &fgColor, const QColor &bgColor);
+
+    // Render the luma into the next display frame and post it to the sink
+    void displayMonochrome(const QVideoFrame &source, const cv::Mat &luma,
+                           const QColor &fgColor, const QColor &bgColor);
+
+    // Follow the text regions into a frame and OCR the changed ones
+    void trackText(const cv::Mat &luma, const QColor &fgColor, const QColor &bgColor,
+                   qint64 capturedMs);
+
+    // Emit the tracked text if it differs from what was reported last
+    void reportTrackedText();
+
+    // Pool of Tesseract engines running OCR in parallel threads
+    OCREnginePool *ocrPool;
+    int source;                       // Source ID of this processor's jobs
+
+    // Frame processing worker and thread
+    QThread *frameThread;             // Separate thread for per-frame work
+    FrameWorker *frameWorker;         // Worker object draining the mailbox
+    FrameMailbox *frameMailbox;       // Latest-frame handoff from the GUI thread
+    std::atomic<quint64> processedFrames;  // Frames run through processFrame
+
+    // Continuous OCR state
+    std::atomic<bool> continuousMode;          // Auto OCR enabled
+    std::atomic<int> continuousStableFrames;   // Still frames before OCR
+    std::atomic<quint64> autoOCRCount;         // Auto OCR passes started
+    SceneChangeDetector sceneDetector;         // Frame thread only
+    bool sceneDetectorActive;                  // Frame thread only
+    QMutex continuousJobsMutex;                // Guards continuousJobs
+    QSet<quint64> continuousJobs;              // Auto OCR jobs in flight
+    QString lastContinuousText;                // Last auto result reported
+
+    // Text tracking state
+    std::atomic<bool> textTracking;            // Tracking enabled
+    TextTracker textTracker;                   // Updated on the frame thread
+    bool textTrackerActive;                    // Frame thread only
+    quint64 trackedRevision;                   // Frame thread only
+    QMutex trackJobsMutex;                     // Guards trackJobs
+    QHash<quint64, int> trackJobs;             // Region OCR jobs -> track
+    QString lastTrackedText;                   // Last tracked text reported
+
+    // Processed frame display
+    std::atomic<QVideoSink *> displaySink;     // Where processed frames go
+    std::atomic<bool> displayPending;          // A frame is on its way to the sink
+    std::atomic<quint64> displayedFrames;      // Frames shown
+    std::atomic<quint64> displayDroppedFrames; // Frames skipped, display behind
+    DisplayFramePool displayPool;              // Frame thread only
+
+    // Intermediate images of processFrame, reused across frames.
+    // Frame thread only (counters are readable from any thread)
+    FrameArena frameArena;
 
-    // Convert to monochrome using specified colors
-    cv::Mat convertToMonochrome(const cv::Mat &input, const QColor &fgColor, const QColor &bgColor);
+    // Thresholding of display and OCR images
+    std::atomic<ThresholdMethod> threshold;    // Method in use
+    AdaptiveBinarizer displayBinarizer;        // Frame thread only
+    ThresholdEstimator thresholdEstimator;     // Frame thread only
 
-    // OCR worker and thread
-    QThread *ocrThread;       // Separate thread for OCR
-    OCRWorker *ocrWorker;     // Worker object for OCR processing
+    // Recent frames for denoised captures
+    FrameFusion captureFusion;
 
     // Current color scheme
     QColor foregroundColor;